@@ -0,0 +1,259 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_ASYNC_LOGGER_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_ASYNC_LOGGER_H_
+
+#include "EventTime.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One deferred argument of a log record. Strings are copied inline (and
+// truncated) so the record never points at memory the caller may free.
+struct LogArg {
+    enum Type {
+        LOG_ARG_INT,
+        LOG_ARG_UINT,
+        LOG_ARG_DOUBLE,
+        LOG_ARG_STRING,
+        LOG_ARG_TIME        // Epoch microseconds, printed as a timestamp
+    };
+
+    static const int kMaxString = 23;
+
+    Type type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        char s[kMaxString + 1];
+    };
+};
+
+// Fixed-size binary log record. `format` must be a string literal; each "{}"
+// in it is replaced by the next argument when the record is flushed.
+struct LogRecord {
+    static const int kMaxArgs = 6;
+
+    int64_t wall_time_us;
+    const char* format;
+    int num_args;
+    LogArg args[kMaxArgs];
+};
+
+// Asynchronous logger with one producer (the strategy's event thread) and one
+// background writer. Log() copies its arguments into a preallocated ring slot
+// with no locks, allocation or formatting; the writer thread formats records
+// and appends them to the file. When the ring is full the record is dropped
+// and counted rather than blocking the event thread.
+class AsyncLogger {
+public:
+    AsyncLogger() :
+        file_(nullptr),
+        mask_(0),
+        head_(0),
+        tail_(0),
+        cached_tail_(0),
+        dropped_(0),
+        running_(false) {}
+
+    ~AsyncLogger() { Stop(); }
+
+    // capacity is rounded up to a power of two
+    bool Start(const std::string& path, std::size_t capacity = 1 << 14)
+    {
+        if (running_.load()) return true;
+
+        file_ = fopen(path.c_str(), "a");
+        if (file_ == nullptr) return false;
+
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        records_.assign(size, LogRecord());
+        mask_ = size - 1;
+        head_.store(0);
+        tail_.store(0);
+        cached_tail_ = 0;
+
+        running_.store(true);
+        writer_ = std::thread(&AsyncLogger::Run, this);
+        return true;
+    }
+
+    // Drains everything already logged, then closes the file
+    void Stop()
+    {
+        if (!running_.exchange(false)) return;
+        writer_.join();
+
+        uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped > 0) {
+            fprintf(file_, "AsyncLogger dropped %llu records\n", static_cast<unsigned long long>(dropped));
+        }
+        fclose(file_);
+        file_ = nullptr;
+    }
+
+    template <typename... Args>
+    void Log(const char* format, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= LogRecord::kMaxArgs, "Too many log arguments");
+        if (!running_.load(std::memory_order_relaxed)) return;
+
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ > mask_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ > mask_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        LogRecord& record = records_[head & mask_];
+        record.wall_time_us = WallMicros();
+        record.format = format;
+        record.num_args = 0;
+        Pack(record, args...);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    bool running() const { return running_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static int64_t WallMicros()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    static void Pack(LogRecord&) {}
+
+    template <typename T, typename... Rest>
+    static void Pack(LogRecord& record, const T& value, const Rest&... rest)
+    {
+        Set(record.args[record.num_args++], value);
+        Pack(record, rest...);
+    }
+
+    static void Set(LogArg& arg, bool value) { arg.type = LogArg::LOG_ARG_INT; arg.i = value; }
+    static void Set(LogArg& arg, int value) { arg.type = LogArg::LOG_ARG_INT; arg.i = value; }
+    static void Set(LogArg& arg, long value) { arg.type = LogArg::LOG_ARG_INT; arg.i = value; }
+    static void Set(LogArg& arg, long long value) { arg.type = LogArg::LOG_ARG_INT; arg.i = value; }
+    static void Set(LogArg& arg, unsigned value) { arg.type = LogArg::LOG_ARG_UINT; arg.u = value; }
+    static void Set(LogArg& arg, unsigned long value) { arg.type = LogArg::LOG_ARG_UINT; arg.u = value; }
+    static void Set(LogArg& arg, unsigned long long value) { arg.type = LogArg::LOG_ARG_UINT; arg.u = value; }
+    static void Set(LogArg& arg, double value) { arg.type = LogArg::LOG_ARG_DOUBLE; arg.d = value; }
+    static void Set(LogArg& arg, const std::string& value) { Set(arg, value.c_str()); }
+    static void Set(LogArg& arg, const char* value)
+    {
+        arg.type = LogArg::LOG_ARG_STRING;
+        strncpy(arg.s, value, LogArg::kMaxString);
+        arg.s[LogArg::kMaxString] = '\0';
+    }
+    static void Set(LogArg& arg, const boost::posix_time::ptime& value)
+    {
+        arg.type = LogArg::LOG_ARG_TIME;
+        arg.i = ToEpochMicros(value);
+    }
+
+    static int FormatTime(char* out, std::size_t size, int64_t epoch_us)
+    {
+        time_t seconds = static_cast<time_t>(epoch_us / 1000000);
+        tm parts;
+        gmtime_r(&seconds, &parts);
+        std::size_t n = strftime(out, size, "%Y-%m-%d %H:%M:%S", &parts);
+        return static_cast<int>(n) + snprintf(out + n, size - n, ".%06lld",
+                                              static_cast<long long>(epoch_us % 1000000));
+    }
+
+    static int FormatArg(char* out, std::size_t size, const LogArg& arg)
+    {
+        switch (arg.type) {
+            case LogArg::LOG_ARG_INT:
+                return snprintf(out, size, "%lld", static_cast<long long>(arg.i));
+            case LogArg::LOG_ARG_UINT:
+                return snprintf(out, size, "%llu", static_cast<unsigned long long>(arg.u));
+            case LogArg::LOG_ARG_DOUBLE:
+                return snprintf(out, size, "%.10g", arg.d);
+            case LogArg::LOG_ARG_STRING:
+                return snprintf(out, size, "%s", arg.s);
+            case LogArg::LOG_ARG_TIME:
+                return FormatTime(out, size, arg.i);
+        }
+        return 0;
+    }
+
+    void Write(const LogRecord& record)
+    {
+        char line[1024];
+        std::size_t n = FormatTime(line, sizeof(line), record.wall_time_us);
+        line[n++] = ' ';
+
+        int next_arg = 0;
+        for (const char* p = record.format; *p != '\0' && n < sizeof(line) - 2; ++p) {
+            if (p[0] == '{' && p[1] == '}' && next_arg < record.num_args) {
+                int written = FormatArg(line + n, sizeof(line) - n - 1, record.args[next_arg++]);
+                if (written > 0) n += written;
+                if (n > sizeof(line) - 2) n = sizeof(line) - 2;
+                ++p;
+            } else {
+                line[n++] = *p;
+            }
+        }
+        line[n++] = '\n';
+        fwrite(line, 1, n, file_);
+    }
+
+    void Run()
+    {
+        for (;;) {
+            bool running = running_.load(std::memory_order_acquire);
+            uint64_t head = head_.load(std::memory_order_acquire);
+            uint64_t tail = tail_.load(std::memory_order_relaxed);
+
+            if (tail == head) {
+                if (!running) break;
+                fflush(file_);
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                continue;
+            }
+
+            for (; tail != head; ++tail) {
+                Write(records_[tail & mask_]);
+            }
+            tail_.store(tail, std::memory_order_release);
+        }
+        fflush(file_);
+    }
+
+    FILE* file_;
+    std::vector<LogRecord> records_;
+    std::size_t mask_;
+
+    // Producer and consumer indices are padded onto separate cache lines.
+    // Padding rather than alignas: the owning strategy is created with plain
+    // operator new, which ignores extended alignment before C++17.
+    std::atomic<uint64_t> head_;
+    char head_pad_[64];
+    std::atomic<uint64_t> tail_;
+    char tail_pad_[64];
+    uint64_t cached_tail_;      // Producer's last view of tail_
+    std::atomic<uint64_t> dropped_;
+    std::atomic<bool> running_;
+    std::thread writer_;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_BAR_AGGREGATOR_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_BAR_AGGREGATOR_H_
+
+#include "LengthList.h"
+#include "LevelTracker.h"
+#include "TickPrice.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// One bar series: clock-aligned time bars of `length` microseconds, or bars
+// of `length` shares or `length` trades
+struct BarSpec {
+    enum Kind {
+        TIME,
+        VOLUME,
+        TICKS
+    };
+
+    BarSpec() : kind(TIME), length(0) {}
+    BarSpec(Kind kind, int64_t length) : kind(kind), length(length) {}
+
+    Kind kind;
+    int64_t length;
+};
+
+// Parses a comma-separated bar list such as "1h,5m,5000v,500t": s, m and h
+// are time bars, v is a share volume and t a trade count. Appends to specs;
+// returns false on a malformed or non-positive entry.
+inline bool ParseBarSpecs(const std::string& spec, std::vector<BarSpec>& specs)
+{
+    return ParseLengthList(spec, [&specs](long long length, char unit) {
+        switch (unit) {
+            case 's': specs.push_back(BarSpec(BarSpec::TIME, length * 1000000)); return true;
+            case 'm': specs.push_back(BarSpec(BarSpec::TIME, length * 60000000)); return true;
+            case 'h': specs.push_back(BarSpec(BarSpec::TIME, length * 3600000000LL)); return true;
+            case 'v': specs.push_back(BarSpec(BarSpec::VOLUME, length)); return true;
+            case 't': specs.push_back(BarSpec(BarSpec::TICKS, length)); return true;
+            default: return false;
+        }
+    });
+}
+
+struct AggregatedBar {
+    AggregatedBar() : start_us(0), end_us(0), open(0), high(0), low(0), close(0), volume(0), trades(0) {}
+
+    int64_t start_us;   // Interval start for time bars, first trade otherwise
+    int64_t end_us;     // Interval end for time bars, last trade otherwise
+    TickPrice open;
+    TickPrice high;
+    TickPrice low;
+    TickPrice close;
+    double volume;
+    int64_t trades;
+};
+
+// Builds time, volume and tick bars for one instrument from its trades, for
+// up to kMaxSpecs bar series at once, plus a rolling high/low over a window
+// of event time. Each trade is O(1) per series (amortized O(1) for the
+// rolling window, see LevelTracker), so no bar waits on the framework.
+//
+// A time bar closes on the first trade at or after its interval end, and
+// intervals without trades make no bar. A volume or tick bar closes on the
+// trade that reaches its length; that trade is part of the bar, so volume
+// bars can run over.
+class BarAggregator {
+public:
+    static const int kMaxSpecs = 8;
+
+    BarAggregator() : num_specs_(0) { clear(); }
+
+    // Starts over with the first kMaxSpecs specs
+    void SetSpecs(const std::vector<BarSpec>& specs)
+    {
+        num_specs_ = 0;
+        for (std::size_t i = 0; i < specs.size() && num_specs_ < kMaxSpecs; ++i) {
+            specs_[num_specs_++] = specs[i];
+        }
+        clear();
+    }
+
+    // Rolling high/low over the last window_us of event time, 0 for none.
+    // Starts the window over.
+    void SetRollingWindow(int64_t window_us)
+    {
+        std::vector<LevelHorizon> horizons;
+        if (window_us > 0) horizons.push_back(LevelHorizon(LevelHorizon::TIME, window_us));
+        rolling_.SetHorizons(horizons);
+    }
+
+    // Returns a mask with bit i set when this trade closed a bar of spec i;
+    // that bar stays in bar(i) until the next one closes
+    unsigned OnTrade(int64_t time_us, TickPrice price, double size)
+    {
+        rolling_.OnPrice(time_us, price);
+
+        unsigned closed = 0;
+        for (int i = 0; i < num_specs_; ++i) {
+            const BarSpec& spec = specs_[i];
+            AggregatedBar& forming = forming_[i];
+
+            if (spec.kind == BarSpec::TIME && forming.trades > 0 && time_us >= forming.end_us) {
+                Close(i);
+                closed |= 1u << i;
+            }
+
+            if (forming.trades == 0) {
+                forming.open = price;
+                forming.high = price;
+                forming.low = price;
+                forming.start_us = spec.kind == BarSpec::TIME ? time_us - time_us % spec.length : time_us;
+            }
+            if (price > forming.high) forming.high = price;
+            if (price < forming.low) forming.low = price;
+            forming.close = price;
+            forming.volume += size;
+            ++forming.trades;
+            forming.end_us = spec.kind == BarSpec::TIME ? forming.start_us + spec.length : time_us;
+
+            if ((spec.kind == BarSpec::VOLUME && forming.volume >= spec.length) ||
+                (spec.kind == BarSpec::TICKS && forming.trades >= spec.length)) {
+                Close(i);
+                closed |= 1u << i;
+            }
+        }
+        return closed;
+    }
+
+    int num_specs() const { return num_specs_; }
+    const BarSpec& spec(int i) const { return specs_[i]; }
+
+    // Last closed bar of spec i, valid once has_bar(i)
+    bool has_bar(int i) const { return has_bar_[i]; }
+    const AggregatedBar& bar(int i) const { return bars_[i]; }
+
+    // The bar of spec i still forming; empty when trades is 0
+    const AggregatedBar& forming(int i) const { return forming_[i]; }
+
+    // Rolling high/low over the trades passed to OnTrade so far. Read them
+    // before passing a trade in to test it against the window as it stood
+    // before that trade. Valid once a trade is in.
+    bool has_rolling() const { return rolling_.num_horizons() > 0; }
+    // Whether the window holds a trade and has seen at least span_us of
+    // event time since it started over
+    bool rolling_covers(int64_t span_us) const
+    {
+        return has_rolling() && rolling_.count() > 0 && rolling_.span_us() >= span_us;
+    }
+    TickPrice rolling_high() const { return rolling_.high(0); }
+    TickPrice rolling_low() const { return rolling_.low(0); }
+
+    void clear()
+    {
+        for (int i = 0; i < kMaxSpecs; ++i) {
+            forming_[i] = AggregatedBar();
+            bars_[i] = AggregatedBar();
+            has_bar_[i] = false;
+        }
+        rolling_.clear();
+    }
+
+private:
+    void Close(int i)
+    {
+        bars_[i] = forming_[i];
+        has_bar_[i] = true;
+        forming_[i] = AggregatedBar();
+    }
+
+    BarSpec specs_[kMaxSpecs];
+    int num_specs_;
+    AggregatedBar forming_[kMaxSpecs];
+    AggregatedBar bars_[kMaxSpecs];
+    bool has_bar_[kMaxSpecs];
+    LevelTracker rolling_;
+};
+
+#endif
@@ -0,0 +1,304 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_BRACKET_ORDER_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_BRACKET_ORDER_H_
+
+#include "ExecutionTypes.h"
+#include "TickPrice.h"
+
+#include <cstdlib>
+
+using namespace RCM::StrategyStudio;
+
+// Message the caller should send for a bracket
+enum BracketAction {
+    BRACKET_ACTION_NEW_TARGET,      // Limit at target_ticks() for quantity
+    BRACKET_ACTION_RESIZE_TARGET,   // Cancel/replace the target to quantity
+    BRACKET_ACTION_CANCEL_TARGET,
+    BRACKET_ACTION_EXIT             // Market order for quantity
+};
+
+struct BracketStep {
+    BracketAction action;
+    bool is_buy;
+    int quantity;
+};
+
+// One instrument's entry order with a profit target and a stop around the
+// position it opens. The target rests on the book as a limit; the stop is held
+// here and fired by OnPrice, as only market and limit orders are available.
+// Target and stop are one-cancels-other: a target fill shrinks what the stop
+// would close and ends the bracket once flat, and a triggered stop cancels the
+// target in the same call that sends the market exit. Every entry fill,
+// partial or not, grows the target to the filled size.
+//
+// Order IDs come back from SendNewOrder, so fills are matched even when they
+// arrive before the open ack. Methods that may need orders fill steps (room
+// for kMaxSteps) and return how many; the caller sends them in order and
+// reports new orders back with OnTargetSent/OnExitSent.
+class Bracket {
+public:
+    static const int kMaxSteps = 2;
+
+    enum Phase {
+        FLAT,       // No bracket
+        ENTERING,   // Entry working, nothing filled yet
+        OPEN,       // Position on: target resting, stop armed
+        EXITING     // Stop or Exit fired: flattening at market
+    };
+
+    Bracket() { clear(); }
+
+    // Starts a bracket on side (1 long, -1 short). Offsets are in ticks from
+    // the first entry fill; a stop_offset of 0 arms no stop.
+    void Open(int side, int quantity, TickPrice target_offset, TickPrice stop_offset)
+    {
+        clear();
+        phase_ = ENTERING;
+        side_ = side;
+        entry_remaining_ = quantity;
+        target_offset_ = target_offset;
+        stop_offset_ = stop_offset;
+    }
+
+    void OnEntrySent(OrderID order_id)
+    {
+        entry_order_id_ = order_id;
+        if (order_id == 0) clear();     // Never reached the venue
+    }
+
+    void OnTargetSent(OrderID order_id, int quantity)
+    {
+        target_order_id_ = order_id;
+        target_size_ = order_id != 0 ? quantity : 0;
+        target_pending_ = order_id != 0;
+    }
+
+    void OnExitSent(OrderID order_id, int quantity)
+    {
+        exit_order_id_ = order_id;
+        exit_remaining_ = order_id != 0 ? quantity : 0;
+    }
+
+    // Open or modify ack. A target resized while its last message was still
+    // unacknowledged catches up here.
+    int OnAcknowledged(OrderID order_id, BracketStep* steps)
+    {
+        if (order_id == 0 || order_id != target_order_id_) return 0;
+        target_pending_ = false;
+        return Settle(steps);
+    }
+
+    // size is unsigned; fill_ticks sets the levels on the first entry fill
+    int OnFill(OrderID order_id, int size, TickPrice fill_ticks, BracketStep* steps)
+    {
+        if (order_id == 0) return 0;
+
+        if (order_id == entry_order_id_) {
+            position_ += side_ * size;
+            entry_remaining_ -= size;
+            if (entry_remaining_ <= 0) entry_order_id_ = 0;
+            if (phase_ == ENTERING) {
+                phase_ = OPEN;
+                entry_ticks_ = fill_ticks;
+                target_ticks_ = fill_ticks + side_ * target_offset_;
+                stop_ticks_ = fill_ticks - side_ * stop_offset_;
+            }
+        } else if (order_id == target_order_id_) {
+            position_ -= side_ * size;
+            target_size_ -= size;
+            target_prior_size_ -= size;
+            if (target_size_ <= 0) ClearTarget();
+        } else if (order_id == exit_order_id_) {
+            position_ += exit_side_ * size;
+            exit_remaining_ -= size;
+            if (exit_remaining_ <= 0) exit_order_id_ = 0;
+        } else {
+            return 0;
+        }
+        return Settle(steps);
+    }
+
+    // Cancel ack or reject. A target or exit the venue drops is not sent
+    // again from here, which would loop on a persistent reject: the stop
+    // still covers an open position and OnPrice retries an exit.
+    int OnOrderGone(OrderID order_id, BracketStep* steps)
+    {
+        if (order_id == 0) return 0;
+
+        if (order_id == entry_order_id_) {
+            entry_order_id_ = 0;
+            entry_remaining_ = 0;
+        } else if (order_id == target_order_id_) {
+            ClearTarget();
+        } else if (order_id == exit_order_id_) {
+            exit_order_id_ = 0;
+            exit_remaining_ = 0;
+            return 0;
+        } else {
+            return 0;
+        }
+        return phase_ == OPEN ? 0 : Settle(steps);
+    }
+
+    // Cancel or cancel/replace reject: the target is still live at the size
+    // it had before the message. A rejected cancel while exiting is sent
+    // again, as nothing can flatten the rest until the target is gone; a
+    // rejected resize is sent again by Settle if the position still differs.
+    int OnCancelRejected(OrderID order_id, BracketStep* steps)
+    {
+        if (order_id == 0 || order_id != target_order_id_) return 0;
+
+        if (target_cancelling_) {     // Only set by Exit
+            steps[0] = MakeStep(BRACKET_ACTION_CANCEL_TARGET, side_ < 0, target_size_);
+            return 1;
+        }
+        if (target_pending_) {
+            target_pending_ = false;
+            target_size_ = target_prior_size_;
+            if (target_size_ <= 0) ClearTarget();
+        }
+        return Settle(steps);
+    }
+
+    // Fires the stop once a trade prints at or through it
+    int OnPrice(TickPrice price, BracketStep* steps)
+    {
+        if (phase_ == OPEN && stop_offset_ > 0 && side_ * (price - stop_ticks_) <= 0) {
+            return Exit(steps);
+        }
+        return phase_ == EXITING ? Settle(steps) : 0;
+    }
+
+    // Cancels the target and flattens at market. A fill racing the cancel
+    // leaves a remainder, which is flattened once nothing is working.
+    int Exit(BracketStep* steps)
+    {
+        if (phase_ == FLAT || phase_ == EXITING) return 0;
+        phase_ = EXITING;
+
+        int num_steps = 0;
+        if (target_order_id_ != 0 && !target_cancelling_) {
+            target_cancelling_ = true;
+            steps[num_steps++] = MakeStep(BRACKET_ACTION_CANCEL_TARGET, side_ < 0, target_size_);
+        }
+        if (position_ != 0 && exit_order_id_ == 0) {
+            steps[num_steps++] = ExitStep();
+        }
+        return num_steps;
+    }
+
+    Phase phase() const { return phase_; }
+    int side() const { return side_; }
+    int position() const { return position_; }     // Signed, from this bracket's fills
+    TickPrice entry_ticks() const { return entry_ticks_; }
+    TickPrice target_ticks() const { return target_ticks_; }
+    TickPrice stop_ticks() const { return stop_ticks_; }
+    OrderID target_order_id() const { return target_order_id_; }
+
+    void clear()
+    {
+        phase_ = FLAT;
+        side_ = 0;
+        position_ = 0;
+        target_offset_ = 0;
+        stop_offset_ = 0;
+        entry_ticks_ = 0;
+        target_ticks_ = 0;
+        stop_ticks_ = 0;
+        entry_order_id_ = 0;
+        entry_remaining_ = 0;
+        exit_order_id_ = 0;
+        exit_remaining_ = 0;
+        exit_side_ = 0;
+        ClearTarget();
+    }
+
+private:
+    static BracketStep MakeStep(BracketAction action, bool is_buy, int quantity)
+    {
+        BracketStep step;
+        step.action = action;
+        step.is_buy = is_buy;
+        step.quantity = quantity;
+        return step;
+    }
+
+    BracketStep ExitStep()
+    {
+        exit_side_ = position_ < 0 ? 1 : -1;
+        return MakeStep(BRACKET_ACTION_EXIT, position_ < 0, abs(position_));
+    }
+
+    void ClearTarget()
+    {
+        target_order_id_ = 0;
+        target_size_ = 0;
+        target_prior_size_ = 0;
+        target_pending_ = false;
+        target_cancelling_ = false;
+    }
+
+    // Brings the orders in line with the position after an event
+    int Settle(BracketStep* steps)
+    {
+        bool working = entry_order_id_ != 0 || target_order_id_ != 0 || exit_order_id_ != 0;
+        switch (phase_) {
+            case ENTERING:
+                if (!working) clear();      // Entry gone unfilled
+                return 0;
+
+            case OPEN: {
+                int open = side_ * position_;
+                if (open <= 0) {
+                    if (!working) clear();  // Target took the whole position
+                    return 0;
+                }
+                if (target_order_id_ == 0) {
+                    steps[0] = MakeStep(BRACKET_ACTION_NEW_TARGET, side_ < 0, open);
+                    return 1;
+                }
+                // Never stack a second message on an unacknowledged one
+                if (target_pending_ || target_cancelling_ || target_size_ == open) return 0;
+                target_prior_size_ = target_size_;
+                target_size_ = open;
+                target_pending_ = true;
+                steps[0] = MakeStep(BRACKET_ACTION_RESIZE_TARGET, side_ < 0, open);
+                return 1;
+            }
+
+            case EXITING:
+                if (working) return 0;
+                if (position_ == 0) {
+                    clear();
+                    return 0;
+                }
+                steps[0] = ExitStep();
+                return 1;
+
+            default:
+                return 0;
+        }
+    }
+
+    Phase phase_;
+    int side_;                  // 1 long, -1 short
+    int position_;              // Signed net of entry, target and exit fills
+    TickPrice target_offset_;
+    TickPrice stop_offset_;
+    TickPrice entry_ticks_;     // First entry fill
+    TickPrice target_ticks_;
+    TickPrice stop_ticks_;
+    OrderID entry_order_id_;
+    int entry_remaining_;
+    OrderID target_order_id_;
+    int target_size_;           // Size the target was last sent or resized to, less fills
+    int target_prior_size_;     // target_size_ before the last resize, less fills
+    bool target_pending_;       // Sent or resized, not yet acknowledged
+    bool target_cancelling_;
+    OrderID exit_order_id_;
+    int exit_remaining_;
+    int exit_side_;             // 1 buy, -1 sell
+};
+
+#endif
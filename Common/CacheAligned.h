@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_CACHE_ALIGNED_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_CACHE_ALIGNED_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static const std::size_t kCacheLineSize = 64;
+
+// Allocator whose blocks start on a cache line. std::allocator only honours
+// over-aligned types from C++17 on, and the strategies build as C++11.
+template <typename T>
+class CacheAlignedAllocator {
+public:
+    typedef T value_type;
+
+    CacheAlignedAllocator() {}
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+    template <typename U>
+    struct rebind {
+        typedef CacheAlignedAllocator<U> other;
+    };
+
+    T* allocate(std::size_t n)
+    {
+        void* ptr = nullptr;
+        std::size_t alignment = alignof(T) > kCacheLineSize ? alignof(T) : kCacheLineSize;
+        if (posix_memalign(&ptr, alignment, n * sizeof(T)) != 0) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, std::size_t) { free(ptr); }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const CacheAlignedAllocator<U>&) const { return false; }
+};
+
+// Contiguous per-slot array starting on a cache line
+template <typename T>
+using CacheAlignedVector = std::vector<T, CacheAlignedAllocator<T> >;
+
+#endif
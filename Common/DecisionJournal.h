@@ -0,0 +1,269 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_DECISION_JOURNAL_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_DECISION_JOURNAL_H_
+
+#include "EventTime.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+enum JournalRecordType {
+    JOURNAL_STATE = 1,      // code: new state, quantity: previous state
+    JOURNAL_SIGNAL,         // code: signal id, values: its inputs (see the labels)
+    JOURNAL_ORDER,          // code: JournalOrderAction, quantity: signed (+buy), values[0]: price (0 market)
+    JOURNAL_FILL            // quantity: signed (+buy), values[0]: fill price
+};
+
+enum JournalOrderAction {
+    JOURNAL_ORDER_NEW,
+    JOURNAL_ORDER_REPLACE,
+    JOURNAL_ORDER_CANCEL
+};
+
+// One journal entry; the layout is the file format
+struct JournalRecord {
+    static const int kMaxValues = 4;
+
+    int64_t event_time_us;
+    uint16_t type;          // JournalRecordType
+    uint16_t slot;          // Instrument slot, named in the header
+    int32_t code;
+    int64_t order_id;
+    int64_t quantity;
+    double values[kMaxValues];
+};
+
+// Name of a state or signal code, and for signals the names of its values
+struct JournalLabel {
+    static const int kMaxName = 24;
+    static const int kMaxValueName = 16;
+
+    uint16_t type;
+    uint16_t reserved;
+    int32_t code;
+    char name[kMaxName];
+    char value_names[JournalRecord::kMaxValues][kMaxValueName];
+};
+
+// First kSize bytes of the file; records follow
+struct JournalHeader {
+    static const int kSize = 4096;
+    static const int kMaxSymbols = 128;
+    static const int kMaxSymbol = 16;
+    static const int kMaxLabels = 16;
+    static const uint32_t kVersion = 1;
+
+    char magic[8];                  // "SSJRNL1"
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t record_count;          // Updated after every record
+    char strategy[32];
+    uint32_t num_symbols;
+    uint32_t num_labels;
+    char symbols[kMaxSymbols][kMaxSymbol];  // By slot; later slots go unnamed
+    JournalLabel labels[kMaxLabels];
+};
+
+static_assert(sizeof(JournalRecord) == 64, "JournalRecord is the file format");
+static_assert(sizeof(JournalHeader) <= JournalHeader::kSize, "JournalHeader must fit its block");
+
+inline void CopyJournalName(char* dest, std::size_t size, const char* src)
+{
+    strncpy(dest, src != nullptr ? src : "", size - 1);
+    dest[size - 1] = '\0';
+}
+
+// Binary record of a strategy's decisions: state transitions, the signal
+// inputs behind them, orders sent and fills, for offline replay analysis.
+// Records are appended to a memory-mapped file, so writing one is a memcpy
+// into the mapping with no formatting or system call; the file grows by
+// doubling, the only time a record costs more. Tools/Journal converts a
+// journal to CSV or to one array file per column.
+//
+// Handlers call set_time on entry; every record is stamped with that event
+// time. Every method is a no-op until Open succeeds.
+class DecisionJournal {
+public:
+    DecisionJournal() :
+        fd_(-1),
+        map_(nullptr),
+        map_size_(0),
+        capacity_(0),
+        count_(0),
+        now_us_(0) {}
+
+    ~DecisionJournal() { Close(); }
+
+    // Truncates path; capacity is the number of records mapped up front
+    bool Open(const std::string& path, const std::string& strategy, std::size_t capacity = 1 << 16)
+    {
+        if (is_open()) return true;
+
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) return false;
+        count_ = 0;
+        if (!Map(capacity > 0 ? capacity : 1)) {
+            close(fd_);
+            fd_ = -1;
+            return false;
+        }
+
+        JournalHeader* header = this->header();
+        memcpy(header->magic, "SSJRNL1", 8);
+        header->version = JournalHeader::kVersion;
+        header->record_size = sizeof(JournalRecord);
+        CopyJournalName(header->strategy, sizeof(header->strategy), strategy.c_str());
+        return true;
+    }
+
+    // Trims the file to the records written
+    void Close()
+    {
+        if (!is_open()) return;
+        munmap(map_, map_size_);
+        // If the trim fails, readers still stop at the header's record_count
+        int trimmed = ftruncate(fd_, JournalHeader::kSize + count_ * sizeof(JournalRecord));
+        (void)trimmed;
+        close(fd_);
+        fd_ = -1;
+        map_ = nullptr;
+        map_size_ = 0;
+        capacity_ = 0;
+    }
+
+    bool is_open() const { return map_ != nullptr; }
+    uint64_t size() const { return count_; }
+
+    void SetSymbol(int slot, const std::string& symbol)
+    {
+        if (!is_open() || slot < 0 || slot >= JournalHeader::kMaxSymbols) return;
+        JournalHeader* header = this->header();
+        CopyJournalName(header->symbols[slot], JournalHeader::kMaxSymbol, symbol.c_str());
+        if (static_cast<uint32_t>(slot) >= header->num_symbols) header->num_symbols = slot + 1;
+    }
+
+    // Names a state or signal code; redefining a code replaces its label
+    void DefineLabel(JournalRecordType type, int code, const char* name, const char* value0 = nullptr,
+                     const char* value1 = nullptr, const char* value2 = nullptr, const char* value3 = nullptr)
+    {
+        if (!is_open()) return;
+        JournalHeader* header = this->header();
+        uint32_t i = 0;
+        while (i < header->num_labels && (header->labels[i].type != type || header->labels[i].code != code)) ++i;
+        if (i == JournalHeader::kMaxLabels) return;
+        if (i == header->num_labels) ++header->num_labels;
+
+        JournalLabel& label = header->labels[i];
+        label.type = static_cast<uint16_t>(type);
+        label.code = code;
+        CopyJournalName(label.name, JournalLabel::kMaxName, name);
+        const char* values[JournalRecord::kMaxValues] = { value0, value1, value2, value3 };
+        for (int v = 0; v < JournalRecord::kMaxValues; ++v) {
+            CopyJournalName(label.value_names[v], JournalLabel::kMaxValueName, values[v]);
+        }
+    }
+
+    void set_time(const boost::posix_time::ptime& now)
+    {
+        if (is_open()) now_us_ = ToEpochMicros(now);
+    }
+
+    void State(int slot, int from, int to)
+    {
+        if (!is_open()) return;
+        JournalRecord record = MakeRecord(JOURNAL_STATE, slot, to);
+        record.quantity = from;
+        Append(record);
+    }
+
+    void Signal(int slot, int code, double value0, double value1 = 0, double value2 = 0, double value3 = 0)
+    {
+        if (!is_open()) return;
+        JournalRecord record = MakeRecord(JOURNAL_SIGNAL, slot, code);
+        record.values[0] = value0;
+        record.values[1] = value1;
+        record.values[2] = value2;
+        record.values[3] = value3;
+        Append(record);
+    }
+
+    void Order(int slot, JournalOrderAction action, uint64_t order_id, int64_t quantity, double price)
+    {
+        if (!is_open()) return;
+        JournalRecord record = MakeRecord(JOURNAL_ORDER, slot, action);
+        record.order_id = static_cast<int64_t>(order_id);
+        record.quantity = quantity;
+        record.values[0] = price;
+        Append(record);
+    }
+
+    void Fill(int slot, uint64_t order_id, int64_t quantity, double price)
+    {
+        if (!is_open()) return;
+        JournalRecord record = MakeRecord(JOURNAL_FILL, slot, 0);
+        record.order_id = static_cast<int64_t>(order_id);
+        record.quantity = quantity;
+        record.values[0] = price;
+        Append(record);
+    }
+
+private:
+    JournalHeader* header() { return reinterpret_cast<JournalHeader*>(map_); }
+
+    JournalRecord MakeRecord(JournalRecordType type, int slot, int code) const
+    {
+        JournalRecord record;
+        memset(&record, 0, sizeof(record));
+        record.event_time_us = now_us_;
+        record.type = static_cast<uint16_t>(type);
+        record.slot = static_cast<uint16_t>(slot);
+        record.code = code;
+        return record;
+    }
+
+    void Append(const JournalRecord& record)
+    {
+        if (count_ == capacity_ && !Map(capacity_ * 2)) return;
+        char* dest = static_cast<char*>(map_) + JournalHeader::kSize + count_ * sizeof(JournalRecord);
+        memcpy(dest, &record, sizeof(record));
+        header()->record_count = ++count_;
+    }
+
+    // Sizes the file for capacity records and maps it, keeping what is written
+    bool Map(std::size_t capacity)
+    {
+        std::size_t size = JournalHeader::kSize + capacity * sizeof(JournalRecord);
+        if (ftruncate(fd_, size) != 0) return false;
+        void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (map == MAP_FAILED) return false;
+
+        // Writing the new pages now takes their page faults here rather than
+        // on the records that reach them
+        std::size_t used = map_ != nullptr ? map_size_ : 0;
+        memset(static_cast<char*>(map) + used, 0, size - used);
+
+        if (map_ != nullptr) munmap(map_, map_size_);
+        map_ = map;
+        map_size_ = size;
+        capacity_ = capacity;
+        return true;
+    }
+
+    int fd_;
+    void* map_;
+    std::size_t map_size_;
+    std::size_t capacity_;          // Records the mapping holds
+    uint64_t count_;
+    int64_t now_us_;                // Set by set_time
+};
+
+#endif
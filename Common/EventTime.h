@@ -0,0 +1,37 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_EVENT_TIME_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_EVENT_TIME_H_
+
+#include <boost/date_time/local_time/local_time.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <cstdint>
+
+// Event timestamps as integer microseconds since the Unix epoch, for hot-path
+// arithmetic and comparisons. not_a_date_time maps to 0.
+inline int64_t ToEpochMicros(const boost::posix_time::ptime& time)
+{
+    static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+    if (time.is_special()) return 0;
+    return (time - epoch).total_microseconds();
+}
+
+inline boost::posix_time::ptime FromEpochMicros(int64_t time_us)
+{
+    static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+    return epoch + boost::posix_time::microseconds(time_us);
+}
+
+// Event time of a New York wall-clock time on date, such as the 09:30 open
+// of the US equity session, with US daylight saving applied
+inline boost::posix_time::ptime FromNewYorkTime(const boost::gregorian::date& date,
+                                                const boost::posix_time::time_duration& time_of_day)
+{
+    static const boost::local_time::time_zone_ptr new_york(
+        new boost::local_time::posix_time_zone("EST-05EDT,M3.2.0,M11.1.0"));
+    return boost::local_time::local_date_time(date, time_of_day, new_york,
+                                              boost::local_time::local_date_time::NOT_DATE_TIME_ON_ERROR).utc_time();
+}
+
+#endif
@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_INSTRUMENT_INDEX_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_INSTRUMENT_INDEX_H_
+
+#include <MarketModels/Instrument.h>
+
+#include <cstdint>
+#include <vector>
+
+// Assigns each registered instrument a dense slot 0..size()-1 so per-instrument
+// state can live in plain arrays. Lookups probe a small open-addressed table
+// keyed by the instrument pointer and never insert.
+class InstrumentIndex {
+public:
+    typedef RCM::StrategyStudio::MarketModels::Instrument Instrument;
+
+    static const int kNotFound = -1;
+
+    InstrumentIndex() : mask_(0) {}
+
+    // Returns the instrument's slot, assigning the next free one if it is new
+    int Add(const Instrument* instrument)
+    {
+        int slot = Find(instrument);
+        if (slot != kNotFound) return slot;
+
+        slot = static_cast<int>(instruments_.size());
+        instruments_.push_back(instrument);
+        if (instruments_.size() * 2 > table_.size()) {
+            Rehash(table_.empty() ? 16 : table_.size() * 2);
+        } else {
+            Place(instrument, slot);
+        }
+        return slot;
+    }
+
+    int Find(const Instrument* instrument) const
+    {
+        if (table_.empty()) return kNotFound;
+        for (std::size_t i = Hash(instrument) & mask_; ; i = (i + 1) & mask_) {
+            const Entry& entry = table_[i];
+            if (entry.instrument == instrument) return entry.slot;
+            if (entry.instrument == nullptr) return kNotFound;
+        }
+    }
+
+    const Instrument* instrument(int slot) const { return instruments_[slot]; }
+    int size() const { return static_cast<int>(instruments_.size()); }
+
+    void clear()
+    {
+        instruments_.clear();
+        table_.clear();
+        mask_ = 0;
+    }
+
+private:
+    struct Entry {
+        Entry() : instrument(nullptr), slot(kNotFound) {}
+
+        const Instrument* instrument;
+        int slot;
+    };
+
+    static std::size_t Hash(const Instrument* instrument)
+    {
+        // Fibonacci hashing of the pointer; the low bits are alignment zeros
+        uint64_t key = reinterpret_cast<uintptr_t>(instrument) >> 4;
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    void Place(const Instrument* instrument, int slot)
+    {
+        std::size_t i = Hash(instrument) & mask_;
+        while (table_[i].instrument != nullptr) {
+            i = (i + 1) & mask_;
+        }
+        table_[i].instrument = instrument;
+        table_[i].slot = slot;
+    }
+
+    void Rehash(std::size_t capacity)
+    {
+        table_.assign(capacity, Entry());
+        mask_ = capacity - 1;
+        for (std::size_t slot = 0; slot < instruments_.size(); ++slot) {
+            Place(instruments_[slot], static_cast<int>(slot));
+        }
+    }
+
+    std::vector<const Instrument*> instruments_;
+    std::vector<Entry> table_;
+    std::size_t mask_;
+};
+
+#endif
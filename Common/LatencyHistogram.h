@@ -0,0 +1,148 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_LATENCY_HISTOGRAM_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_LATENCY_HISTOGRAM_H_
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Raw timestamp counter. Falls back to steady_clock nanoseconds where there is
+// no TSC, in which case TscClock reports one tick per nanosecond.
+inline uint64_t ReadTsc()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Converts TSC ticks to nanoseconds. Calibrated lazily against steady_clock
+// over the whole interval since the last Reset, so nothing blocks at start-up
+// and the estimate tightens as the session runs.
+class TscClock {
+public:
+    TscClock() { Reset(); }
+
+    void Reset()
+    {
+        tsc_start_ = ReadTsc();
+        clock_start_ = std::chrono::steady_clock::now();
+    }
+
+    double NanosPerTick() const
+    {
+        uint64_t ticks = ReadTsc() - tsc_start_;
+        double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - clock_start_).count();
+        if (ticks == 0 || nanos <= 0) return 1.0;
+        return nanos / ticks;
+    }
+
+private:
+    uint64_t tsc_start_;
+    std::chrono::steady_clock::time_point clock_start_;
+};
+
+// HDR-style log-linear histogram of tick counts. Values below kSubBuckets get
+// a bucket each; above that every power of two is split into kSubBuckets equal
+// buckets, so any recorded value is known to within 1/kSubBuckets. Recording
+// is a count-leading-zeros and an increment; there is no allocation.
+class LatencyHistogram {
+public:
+    static const int kSubBits = 4;
+    static const int kSubBuckets = 1 << kSubBits;
+    static const int kMaxBit = 40;      // Larger values land in the last bucket
+    static const int kBuckets = (kMaxBit - kSubBits + 2) * kSubBuckets;
+
+    LatencyHistogram() { clear(); }
+
+    void Record(uint64_t value)
+    {
+        ++counts_[BucketIndex(value)];
+        ++count_;
+        sum_ += value;
+        if (value < min_) min_ = value;
+        if (value > max_) max_ = value;
+    }
+
+    void Merge(const LatencyHistogram& other)
+    {
+        for (int i = 0; i < kBuckets; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        if (other.min_ < min_) min_ = other.min_;
+        if (other.max_ > max_) max_ = other.max_;
+    }
+
+    // Value at quantile q in [0, 1], reported as the middle of its bucket
+    uint64_t Percentile(double q) const
+    {
+        if (count_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * count_ + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > count_) rank = count_;
+
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                uint64_t mid = BucketLow(i) + BucketWidth(i) / 2;
+                return mid < min_ ? min_ : (mid > max_ ? max_ : mid);
+            }
+        }
+        return max_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ > 0 ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ > 0 ? static_cast<double>(sum_) / count_ : 0.0; }
+
+    void clear()
+    {
+        memset(counts_, 0, sizeof(counts_));
+        count_ = 0;
+        sum_ = 0;
+        min_ = UINT64_MAX;
+        max_ = 0;
+    }
+
+    static int BucketIndex(uint64_t value)
+    {
+        if (value < static_cast<uint64_t>(kSubBuckets)) return static_cast<int>(value);
+        int msb = 63 - __builtin_clzll(value);
+        if (msb > kMaxBit) return kBuckets - 1;
+        int mantissa = static_cast<int>(value >> (msb - kSubBits));   // In [kSubBuckets, 2 * kSubBuckets)
+        return (msb - kSubBits + 1) * kSubBuckets + (mantissa - kSubBuckets);
+    }
+
+    static uint64_t BucketLow(int index)
+    {
+        if (index < kSubBuckets) return static_cast<uint64_t>(index);
+        int group = index / kSubBuckets;
+        uint64_t mantissa = static_cast<uint64_t>(index % kSubBuckets + kSubBuckets);
+        return mantissa << (group - 1);
+    }
+
+    static uint64_t BucketWidth(int index)
+    {
+        return index < kSubBuckets ? 1 : static_cast<uint64_t>(1) << (index / kSubBuckets - 1);
+    }
+
+private:
+    uint64_t counts_[kBuckets];
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t min_;
+    uint64_t max_;
+};
+
+#endif
@@ -0,0 +1,193 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_LATENCY_RECORDER_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_LATENCY_RECORDER_H_
+
+#include "CacheAligned.h"
+#include "InstrumentIndex.h"
+#include "LatencyHistogram.h"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+// Event handlers whose tick-to-order latency is tracked
+enum LatencyHandler {
+    LATENCY_HANDLER_NONE = -1,
+    LATENCY_HANDLER_ON_TRADE = 0,
+    LATENCY_HANDLER_ON_TOP_QUOTE,
+    LATENCY_HANDLER_ON_DEPTH,
+    LATENCY_HANDLER_ON_BAR,
+    LATENCY_HANDLER_ON_ORDER_UPDATE,
+    LATENCY_HANDLER_COUNT
+};
+
+inline const char* LatencyHandlerName(int handler)
+{
+    static const char* const kNames[LATENCY_HANDLER_COUNT] = {
+        "OnTrade", "OnTopQuote", "OnDepth", "OnBar", "OnOrderUpdate"
+    };
+    return handler >= 0 && handler < LATENCY_HANDLER_COUNT ? kNames[handler] : "None";
+}
+
+// Tick-to-order latency: the time from entering an event handler until an
+// order send or cancel returns, one histogram per handler and instrument slot.
+// Handlers open a Scope on entry; every order action made while it is open
+// records one sample. Scopes nest, so actions from a nested handler are
+// charged to the innermost one.
+class LatencyRecorder {
+public:
+    class Scope {
+    public:
+        Scope(LatencyRecorder& recorder, LatencyHandler handler) :
+            recorder_(recorder),
+            saved_handler_(recorder.handler_),
+            saved_start_(recorder.start_tsc_)
+        {
+            if (!recorder_.enabled_) return;
+            recorder_.handler_ = handler;
+            recorder_.start_tsc_ = ReadTsc();
+        }
+
+        ~Scope()
+        {
+            recorder_.handler_ = saved_handler_;
+            recorder_.start_tsc_ = saved_start_;
+        }
+
+    private:
+        LatencyRecorder& recorder_;
+        LatencyHandler saved_handler_;
+        uint64_t saved_start_;
+    };
+
+    LatencyRecorder() :
+        enabled_(false),
+        num_slots_(0),
+        handler_(LATENCY_HANDLER_NONE),
+        start_tsc_(0),
+        snapshot_(0) {}
+
+    void Reset(int num_slots)
+    {
+        num_slots_ = num_slots;
+        histograms_.assign(static_cast<std::size_t>(num_slots) * LATENCY_HANDLER_COUNT, LatencyHistogram());
+        clock_.Reset();
+    }
+
+    // Call right after an order send or cancel returns
+    void RecordOrderAction(int slot)
+    {
+        if (handler_ == LATENCY_HANDLER_NONE || !enabled_) return;
+        histograms_[handler_ * num_slots_ + slot].Record(ReadTsc() - start_tsc_);
+    }
+
+    // All instruments' samples for one handler, in TSC ticks
+    LatencyHistogram Merged(int handler) const
+    {
+        LatencyHistogram merged;
+        for (int slot = 0; slot < num_slots_; ++slot) {
+            merged.Merge(histograms_[handler * num_slots_ + slot]);
+        }
+        return merged;
+    }
+
+    // One-line summary of a handler in nanoseconds, empty if it has no samples
+    std::string Summary(int handler) const
+    {
+        LatencyHistogram merged = Merged(handler);
+        if (merged.count() == 0) return std::string();
+
+        double ns_per_tick = clock_.NanosPerTick();
+        std::stringstream ss;
+        ss << "Latency " << LatencyHandlerName(handler) << " (ns):"
+           << " Samples: " << merged.count()
+           << " p50: " << merged.Percentile(0.50) * ns_per_tick
+           << " p99: " << merged.Percentile(0.99) * ns_per_tick
+           << " p99.9: " << merged.Percentile(0.999) * ns_per_tick
+           << " Max: " << merged.max() * ns_per_tick;
+        return ss.str();
+    }
+
+    void ClearHistograms()
+    {
+        for (std::size_t i = 0; i < histograms_.size(); ++i) {
+            histograms_[i].clear();
+        }
+    }
+
+    // Appends one snapshot to a CSV file, in nanoseconds: a row per handler
+    // over all instruments ("ALL"), then a row per handler and instrument
+    // that has samples.
+    bool Dump(const std::string& path, const InstrumentIndex& index, const std::string& reason)
+    {
+        FILE* file = fopen(path.c_str(), "a");
+        if (file == nullptr) return false;
+
+        if (ftell(file) == 0) {
+            fprintf(file, "snapshot,reason,handler,symbol,count,min_ns,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n");
+        }
+
+        ++snapshot_;
+        double ns_per_tick = clock_.NanosPerTick();
+        for (int handler = 0; handler < LATENCY_HANDLER_COUNT; ++handler) {
+            LatencyHistogram merged = Merged(handler);
+            if (merged.count() == 0) continue;
+            WriteRow(file, reason, handler, "ALL", merged, ns_per_tick);
+
+            for (int slot = 0; slot < num_slots_; ++slot) {
+                const LatencyHistogram& histogram = histograms_[handler * num_slots_ + slot];
+                if (histogram.count() == 0) continue;
+                WriteRow(file, reason, handler, index.instrument(slot)->symbol().c_str(), histogram, ns_per_tick);
+            }
+        }
+
+        fclose(file);
+        return true;
+    }
+
+    double NanosPerTick() const { return clock_.NanosPerTick(); }
+
+    void set_enabled(bool enabled) { enabled_ = enabled; }
+    bool enabled() const { return enabled_; }
+
+private:
+    void WriteRow(FILE* file, const std::string& reason, int handler, const char* symbol,
+                  const LatencyHistogram& histogram, double ns_per_tick) const
+    {
+        fprintf(file, "%d,%s,%s,%s,%llu,%.0f,%.1f,%.0f,%.0f,%.0f,%.0f,%.0f\n",
+                snapshot_, reason.c_str(), LatencyHandlerName(handler), symbol,
+                static_cast<unsigned long long>(histogram.count()),
+                histogram.min() * ns_per_tick,
+                histogram.mean() * ns_per_tick,
+                histogram.Percentile(0.50) * ns_per_tick,
+                histogram.Percentile(0.90) * ns_per_tick,
+                histogram.Percentile(0.99) * ns_per_tick,
+                histogram.Percentile(0.999) * ns_per_tick,
+                histogram.max() * ns_per_tick);
+    }
+
+    bool enabled_;
+    int num_slots_;
+    LatencyHandler handler_;
+    uint64_t start_tsc_;
+    int snapshot_;
+    TscClock clock_;
+    CacheAlignedVector<LatencyHistogram> histograms_;   // [handler * num_slots + slot]
+};
+
+// LatencyRecorder::Scope that compiles to nothing when Enabled is false
+template <bool Enabled>
+class OptionalLatencyScope : public LatencyRecorder::Scope {
+public:
+    OptionalLatencyScope(LatencyRecorder& recorder, LatencyHandler handler) :
+        LatencyRecorder::Scope(recorder, handler) {}
+};
+
+template <>
+class OptionalLatencyScope<false> {
+public:
+    OptionalLatencyScope(LatencyRecorder&, LatencyHandler) {}
+};
+
+#endif
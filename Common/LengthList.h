@@ -0,0 +1,33 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_LENGTH_LIST_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_LENGTH_LIST_H_
+
+#include <cstdlib>
+#include <string>
+
+// Parses a comma-separated list of <count><unit> tokens such as
+// "100t,15m,1h", calling add(count, unit) for each in order. add maps the
+// unit character to an entry and returns false for a unit it does not know.
+// Empty tokens are skipped; returns false on a malformed or non-positive
+// token, or on the first token add refuses.
+template <typename AddFn>
+inline bool ParseLengthList(const std::string& spec, AddFn add)
+{
+    std::size_t pos = 0;
+    while (pos < spec.size()) {
+        std::size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty()) continue;
+
+        char* unit;
+        long long count = strtoll(item.c_str(), &unit, 10);
+        if (count <= 0 || unit == item.c_str() || unit[0] == '\0' || unit[1] != '\0') return false;
+        if (!add(count, unit[0])) return false;
+    }
+    return true;
+}
+
+#endif
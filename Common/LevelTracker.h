@@ -0,0 +1,212 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_LEVEL_TRACKER_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_LEVEL_TRACKER_H_
+
+#include "LengthList.h"
+#include "TickPrice.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Lookback of one rolling high/low: the last `length` trades, or the last
+// `length` microseconds of event time
+struct LevelHorizon {
+    enum Kind {
+        TRADES,
+        TIME
+    };
+
+    LevelHorizon() : kind(TRADES), length(0) {}
+    LevelHorizon(Kind kind, int64_t length) : kind(kind), length(length) {}
+
+    Kind kind;
+    int64_t length;
+};
+
+// Parses a comma-separated horizon list such as "100t,10000t,5m,60m": t is a
+// trade count, s, m and h are seconds, minutes and hours. Appends to
+// horizons; returns false on a malformed or non-positive entry.
+inline bool ParseLevelHorizons(const std::string& spec, std::vector<LevelHorizon>& horizons)
+{
+    return ParseLengthList(spec, [&horizons](long long length, char unit) {
+        switch (unit) {
+            case 't': horizons.push_back(LevelHorizon(LevelHorizon::TRADES, length)); return true;
+            case 's': horizons.push_back(LevelHorizon(LevelHorizon::TIME, length * 1000000)); return true;
+            case 'm': horizons.push_back(LevelHorizon(LevelHorizon::TIME, length * 60000000)); return true;
+            case 'h': horizons.push_back(LevelHorizon(LevelHorizon::TIME, length * 3600000000LL)); return true;
+            default: return false;
+        }
+    });
+}
+
+// Rolling highs and lows over several trade-count and time horizons at once.
+// One monotonic deque per side serves every horizon: it holds, oldest first,
+// the samples that can still become an extreme of some window, and the
+// extreme of each window is its oldest entry inside that window. Each horizon
+// keeps a cursor to that entry, which only moves forward, so an update costs
+// amortized O(1) per horizon with no scan of the window.
+// The deques grow (by doubling) only while a trend outruns their storage.
+class LevelTracker {
+public:
+    static const int kMaxHorizons = 8;
+    static const int kNone = -1;
+
+    LevelTracker() : num_horizons_(0) { clear(); }
+
+    // Starts over with the first kMaxHorizons horizons
+    void SetHorizons(const std::vector<LevelHorizon>& horizons)
+    {
+        num_horizons_ = 0;
+        for (std::size_t i = 0; i < horizons.size() && num_horizons_ < kMaxHorizons; ++i) {
+            horizons_[num_horizons_++] = horizons[i];
+        }
+        clear();
+    }
+
+    void OnPrice(int64_t time_us, TickPrice price)
+    {
+        if (num_horizons_ == 0) return;
+        ++count_;
+        if (count_ == 1) first_time_us_ = time_us;
+        last_time_us_ = time_us;
+
+        Sample sample(count_, time_us, price);
+        highs_.Push(sample, 1, horizons_, num_horizons_, count_, time_us);
+        lows_.Push(sample, -1, horizons_, num_horizons_, count_, time_us);
+    }
+
+    int num_horizons() const { return num_horizons_; }
+    const LevelHorizon& horizon(int h) const { return horizons_[h]; }
+
+    // Whether horizon h has seen a full window since the last reset
+    bool ready(int h) const
+    {
+        const LevelHorizon& horizon = horizons_[h];
+        if (count_ == 0) return false;
+        if (horizon.kind == LevelHorizon::TRADES) return count_ >= static_cast<uint64_t>(horizon.length);
+        return last_time_us_ - first_time_us_ >= horizon.length;
+    }
+
+    // Prices since the last reset, and the event time they span
+    uint64_t count() const { return count_; }
+    int64_t span_us() const { return last_time_us_ - first_time_us_; }
+
+    // Only valid after the first price
+    TickPrice high(int h) const { return highs_.Extreme(h); }
+    TickPrice low(int h) const { return lows_.Extreme(h); }
+
+    // First ready horizon, in order, whose high or low (high first) is within
+    // range of price, or kNone
+    int FindNear(TickPrice price, TickPrice range, bool& is_near_high) const
+    {
+        for (int h = 0; h < num_horizons_; ++h) {
+            if (!ready(h)) continue;
+            if (llabs(price - high(h)) <= range) {
+                is_near_high = true;
+                return h;
+            }
+            if (llabs(price - low(h)) <= range) {
+                is_near_high = false;
+                return h;
+            }
+        }
+        return kNone;
+    }
+
+    void clear()
+    {
+        count_ = 0;
+        first_time_us_ = 0;
+        last_time_us_ = 0;
+        highs_.clear();
+        lows_.clear();
+    }
+
+private:
+    struct Sample {
+        Sample() : seq(0), time_us(0), price(0) {}
+        Sample(uint64_t seq, int64_t time_us, TickPrice price) : seq(seq), time_us(time_us), price(price) {}
+
+        uint64_t seq;       // 1-based arrival number
+        int64_t time_us;
+        TickPrice price;
+    };
+
+    // Monotonic deque over absolute positions head_..tail_-1, stored in a
+    // power-of-two ring so positions never need renumbering
+    class ExtremeQueue {
+    public:
+        ExtremeQueue() : buffer_(64), mask_(63) { clear(); }
+
+        // sign is 1 for highs and -1 for lows
+        void Push(const Sample& sample, int sign, const LevelHorizon* horizons, int num_horizons,
+                  uint64_t count, int64_t now_us)
+        {
+            // Ties keep the newest sample, which stays in the windows longest
+            while (tail_ > head_ && sign * (At(tail_ - 1).price - sample.price) <= 0) --tail_;
+            if (tail_ - head_ == buffer_.size()) Grow();
+            At(tail_) = sample;
+            uint64_t newest = tail_++;
+
+            uint64_t oldest = newest;
+            for (int h = 0; h < num_horizons; ++h) {
+                uint64_t& cursor = cursors_[h];
+                if (cursor > newest) cursor = newest;
+                while (cursor < newest && Expired(At(cursor), horizons[h], count, now_us)) ++cursor;
+                if (cursor < oldest) oldest = cursor;
+            }
+            head_ = oldest;
+        }
+
+        TickPrice Extreme(int h) const { return At(cursors_[h]).price; }
+
+        void clear()
+        {
+            head_ = 0;
+            tail_ = 0;
+            for (int h = 0; h < kMaxHorizons; ++h) cursors_[h] = 0;
+        }
+
+    private:
+        static bool Expired(const Sample& sample, const LevelHorizon& horizon, uint64_t count, int64_t now_us)
+        {
+            if (horizon.kind == LevelHorizon::TRADES) {
+                return sample.seq + static_cast<uint64_t>(horizon.length) <= count;
+            }
+            return sample.time_us <= now_us - horizon.length;
+        }
+
+        Sample& At(uint64_t pos) { return buffer_[pos & mask_]; }
+        const Sample& At(uint64_t pos) const { return buffer_[pos & mask_]; }
+
+        void Grow()
+        {
+            std::vector<Sample> buffer(buffer_.size() * 2);
+            uint64_t mask = buffer.size() - 1;
+            for (uint64_t pos = head_; pos < tail_; ++pos) {
+                buffer[pos & mask] = At(pos);
+            }
+            buffer_.swap(buffer);
+            mask_ = mask;
+        }
+
+        std::vector<Sample> buffer_;
+        uint64_t mask_;
+        uint64_t head_;
+        uint64_t tail_;
+        uint64_t cursors_[kMaxHorizons];   // Position of each horizon's extreme
+    };
+
+    LevelHorizon horizons_[kMaxHorizons];
+    int num_horizons_;
+    uint64_t count_;
+    int64_t first_time_us_;
+    int64_t last_time_us_;
+    ExtremeQueue highs_;
+    ExtremeQueue lows_;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_POSITION_BOOK_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_POSITION_BOOK_H_
+
+#include "CacheAligned.h"
+
+#include <cstdlib>
+
+// Position, cost basis and PnL of one instrument
+struct PositionEntry {
+    PositionEntry() :
+        position(0),
+        avg_price(0),
+        realized_pnl(0),
+        mark_price(0) {}
+
+    double UnrealizedPnl() const { return mark_price > 0 ? position * (mark_price - avg_price) : 0.0; }
+
+    int position;           // Signed: long > 0, short < 0
+    double avg_price;       // VWAP of the open position, 0 when flat
+    double realized_pnl;
+    double mark_price;      // Last mid used for unrealized PnL
+};
+
+// Strategy-local position book, one entry per instrument slot, updated
+// incrementally from our own fills. Reading a position is one load instead of
+// a framework call; Reconcile() checks the book against the portfolio.
+class PositionBook {
+public:
+    void Reset(int num_slots) { entries_.assign(num_slots, PositionEntry()); }
+
+    // signed_size > 0 for buys, < 0 for sells
+    void OnFill(int slot, int signed_size, double price)
+    {
+        if (signed_size == 0) return;
+        PositionEntry& entry = entries_[slot];
+        int old_position = entry.position;
+
+        if (old_position == 0 || (old_position > 0) == (signed_size > 0)) {
+            // Opening or adding: blend into the cost basis
+            int old_size = abs(old_position);
+            int add_size = abs(signed_size);
+            entry.avg_price = (entry.avg_price * old_size + price * add_size) / (old_size + add_size);
+            entry.position += signed_size;
+            return;
+        }
+
+        // Reducing, closing or flipping: realize against the cost basis
+        int closed = abs(signed_size) < abs(old_position) ? abs(signed_size) : abs(old_position);
+        entry.realized_pnl += closed * (price - entry.avg_price) * (old_position > 0 ? 1 : -1);
+        entry.position += signed_size;
+
+        if (entry.position == 0) {
+            entry.avg_price = 0;
+        } else if ((entry.position > 0) != (old_position > 0)) {
+            entry.avg_price = price;    // Flipped: the remainder opened at this fill
+        }
+    }
+
+    void Mark(int slot, double mid_price) { entries_[slot].mark_price = mid_price; }
+
+    // Adopts the portfolio position if the book disagrees. Returns whether
+    // the book matched.
+    bool Reconcile(int slot, int portfolio_position)
+    {
+        PositionEntry& entry = entries_[slot];
+        if (entry.position == portfolio_position) return true;
+
+        entry.position = portfolio_position;
+        if (portfolio_position == 0) {
+            entry.avg_price = 0;
+        } else if (entry.avg_price == 0) {
+            entry.avg_price = entry.mark_price;
+        }
+        return false;
+    }
+
+    // Starts a new day's realized PnL; positions and cost basis carry over
+    void ResetRealized()
+    {
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            entries_[i].realized_pnl = 0;
+        }
+    }
+
+    int position(int slot) const { return entries_[slot].position; }
+    const PositionEntry& entry(int slot) const { return entries_[slot]; }
+    int size() const { return static_cast<int>(entries_.size()); }
+
+    double TotalRealizedPnl() const
+    {
+        double total = 0;
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            total += entries_[i].realized_pnl;
+        }
+        return total;
+    }
+
+    double TotalUnrealizedPnl() const
+    {
+        double total = 0;
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            total += entries_[i].UnrealizedPnl();
+        }
+        return total;
+    }
+
+private:
+    CacheAlignedVector<PositionEntry> entries_;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_RING_BUFFER_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_RING_BUFFER_H_
+
+#include <cstddef>
+#include <vector>
+
+// Rolling window over the last window() samples. Storage is a power-of-two
+// array indexed with a mask, so pushing and evicting never allocate. Only
+// SetWindow allocates, and only when the window outgrows the current storage.
+template <typename T>
+class RingBuffer {
+public:
+    RingBuffer() : head_(0), size_(0), window_(0), mask_(0) {}
+    explicit RingBuffer(std::size_t window) : head_(0), size_(0), window_(0), mask_(0) { SetWindow(window); }
+
+    // Changes the window length, keeping the newest samples that still fit
+    void SetWindow(std::size_t window)
+    {
+        while (size_ > window) {
+            pop_front();
+        }
+
+        if (window > buffer_.size()) {
+            std::size_t capacity = 1;
+            while (capacity < window) {
+                capacity <<= 1;
+            }
+
+            std::vector<T> buffer(capacity);
+            for (std::size_t i = 0; i < size_; ++i) {
+                buffer[i] = (*this)[i];
+            }
+            buffer_.swap(buffer);
+            head_ = 0;
+            mask_ = capacity - 1;
+        }
+
+        window_ = window;
+    }
+
+    // Appends a sample, dropping the oldest one if the window is full
+    void push_back(const T& value)
+    {
+        if (window_ == 0) return;
+        if (size_ == window_) {
+            pop_front();
+        }
+        buffer_[(head_ + size_) & mask_] = value;
+        ++size_;
+    }
+
+    void pop_front()
+    {
+        head_ = (head_ + 1) & mask_;
+        --size_;
+    }
+
+    void pop_back() { --size_; }
+
+    // i = 0 is the oldest sample
+    const T& operator[](std::size_t i) const { return buffer_[(head_ + i) & mask_]; }
+    const T& front() const { return (*this)[0]; }
+    const T& back() const { return (*this)[size_ - 1]; }
+
+    std::size_t size() const { return size_; }
+    std::size_t window() const { return window_; }
+    std::size_t capacity() const { return buffer_.size(); }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == window_; }
+
+    void clear()
+    {
+        head_ = 0;
+        size_ = 0;
+    }
+
+private:
+    std::vector<T> buffer_;
+    std::size_t head_;
+    std::size_t size_;
+    std::size_t window_;
+    std::size_t mask_;
+};
+
+#endif
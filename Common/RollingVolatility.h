@@ -0,0 +1,198 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_ROLLING_VOLATILITY_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_ROLLING_VOLATILITY_H_
+
+#include "RingBuffer.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Sample variance (n - 1 divisor) of the last window() values, updated in O(1)
+// per value with Welford's add and remove steps. Removing values lets rounding
+// error build up, so the sums are recomputed exactly from the window once
+// every window() removals, which keeps the amortized cost O(1).
+class RollingVariance {
+public:
+    RollingVariance() : mean_(0), m2_(0), removals_(0) {}
+    explicit RollingVariance(std::size_t window) : mean_(0), m2_(0), removals_(0) { SetWindow(window); }
+
+    // A shorter window drops the oldest values; a longer one fills up again
+    void SetWindow(std::size_t window)
+    {
+        while (values_.size() > window) {
+            Remove(values_.front());
+            values_.pop_front();
+        }
+        values_.SetWindow(window);
+    }
+
+    void Add(double x)
+    {
+        if (values_.window() == 0) return;
+        if (values_.full()) {
+            Remove(values_.front());
+            values_.pop_front();
+        }
+        values_.push_back(x);
+
+        double n = static_cast<double>(values_.size());
+        double delta = x - mean_;
+        mean_ += delta / n;
+        m2_ += delta * (x - mean_);
+
+        if (removals_ >= values_.window()) {
+            Recompute();
+        }
+    }
+
+    double Mean() const { return mean_; }
+
+    double Variance() const
+    {
+        if (values_.size() < 2) return 0;
+        return m2_ > 0 ? m2_ / (values_.size() - 1) : 0;
+    }
+
+    double StdDev() const { return sqrt(Variance()); }
+
+    std::size_t size() const { return values_.size(); }
+    std::size_t window() const { return values_.window(); }
+    bool full() const { return values_.full(); }
+
+    void clear()
+    {
+        values_.clear();
+        mean_ = 0;
+        m2_ = 0;
+        removals_ = 0;
+    }
+
+private:
+    // x must still be counted in values_.size()
+    void Remove(double x)
+    {
+        std::size_t n = values_.size();
+        if (n <= 1) {
+            mean_ = 0;
+            m2_ = 0;
+            return;
+        }
+        double delta = x - mean_;
+        mean_ -= delta / (n - 1);
+        m2_ -= delta * (x - mean_);
+        ++removals_;
+    }
+
+    void Recompute()
+    {
+        double sum = 0;
+        for (std::size_t i = 0; i < values_.size(); ++i) {
+            sum += values_[i];
+        }
+        mean_ = sum / values_.size();
+
+        double m2 = 0;
+        for (std::size_t i = 0; i < values_.size(); ++i) {
+            double d = values_[i] - mean_;
+            m2 += d * d;
+        }
+        m2_ = m2;
+        removals_ = 0;
+    }
+
+    RingBuffer<double> values_;
+    double mean_;
+    double m2_;             // Sum of squared deviations from mean_
+    std::size_t removals_;  // Since the last exact recompute
+};
+
+// Which measure VolatilityTracker::volatility() reports
+enum VolatilityMode {
+    VOLATILITY_MODE_PRICE = 0,        // Std dev of the last window prices
+    VOLATILITY_MODE_LOG_RETURN = 1,   // Std dev of the last window log returns
+    VOLATILITY_MODE_EWMA = 2          // EWMA std dev of log returns, span window
+};
+
+// Price, log-return and EWMA volatility of one instrument, all updated on
+// every price. The selected measure is cached, so reading it is one load.
+// Until a full window has been seen it reads 0.
+class VolatilityTracker {
+public:
+    VolatilityTracker() :
+        mode_(VOLATILITY_MODE_PRICE),
+        ewma_alpha_(1),
+        last_price_(0),
+        ewma_variance_(0),
+        returns_seen_(0),
+        volatility_(0) {}
+
+    void SetWindow(int window)
+    {
+        std::size_t size = window > 0 ? static_cast<std::size_t>(window) : 0;
+        prices_.SetWindow(size);
+        returns_.SetWindow(size);
+        ewma_alpha_ = 2.0 / (size > 0 ? size + 1 : 2);
+        Cache();
+    }
+
+    void set_mode(VolatilityMode mode)
+    {
+        mode_ = mode;
+        Cache();
+    }
+
+    void OnPrice(double price)
+    {
+        prices_.Add(price);
+        if (last_price_ > 0 && price > 0) {
+            double r = log(price / last_price_);
+            returns_.Add(r);
+            ewma_variance_ = returns_seen_ == 0 ? r * r : ewma_variance_ + ewma_alpha_ * (r * r - ewma_variance_);
+            ++returns_seen_;
+        }
+        last_price_ = price;
+        Cache();
+    }
+
+    double volatility() const { return volatility_; }
+
+    double price_volatility() const { return prices_.full() ? prices_.StdDev() : 0; }
+    double return_volatility() const { return returns_.full() ? returns_.StdDev() : 0; }
+    double ewma_volatility() const
+    {
+        return returns_seen_ > 0 && returns_seen_ >= returns_.window() ? sqrt(ewma_variance_) : 0;
+    }
+
+    void clear()
+    {
+        prices_.clear();
+        returns_.clear();
+        last_price_ = 0;
+        ewma_variance_ = 0;
+        returns_seen_ = 0;
+        volatility_ = 0;
+    }
+
+private:
+    void Cache()
+    {
+        switch (mode_) {
+            case VOLATILITY_MODE_LOG_RETURN: volatility_ = return_volatility(); break;
+            case VOLATILITY_MODE_EWMA: volatility_ = ewma_volatility(); break;
+            default: volatility_ = price_volatility(); break;
+        }
+    }
+
+    VolatilityMode mode_;
+    double ewma_alpha_;
+    double last_price_;
+    double ewma_variance_;      // Mean of squared log returns, zero-mean EWMA
+    uint64_t returns_seen_;
+    double volatility_;         // Cached measure for mode_
+    RollingVariance prices_;
+    RollingVariance returns_;
+};
+
+#endif
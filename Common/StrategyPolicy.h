@@ -0,0 +1,31 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_STRATEGY_POLICY_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_STRATEGY_POLICY_H_
+
+// Compile-time switches the strategies are templated over. A disabled feature
+// is a constant-false branch, so the optimizer drops it together with its
+// logging and formatting code.
+//
+// Production: no debug logging or latency instrumentation compiled in; the
+// debug and latency_stats params are accepted but have no effect.
+struct ProductionPolicy {
+    static const bool kDebugLog = false;        // Debug log records (debug param)
+    static const bool kInstrumentation = false; // Latency histograms (latency_stats param)
+};
+
+// Diagnostic: everything compiled in, switched at runtime by the params
+struct DiagnosticPolicy {
+    static const bool kDebugLog = true;
+    static const bool kInstrumentation = true;
+};
+
+// Policy of the variant being built; the Makefiles define STRATEGY_DIAGNOSTIC
+// for the diagnostic .so
+#ifdef STRATEGY_DIAGNOSTIC
+typedef DiagnosticPolicy StrategyPolicy;
+#else
+typedef ProductionPolicy StrategyPolicy;
+#endif
+
+#endif
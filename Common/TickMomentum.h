@@ -0,0 +1,152 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_TICK_MOMENTUM_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_TICK_MOMENTUM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Tick direction history as two bit masks, one bit per trade in the up mask
+// and one in the down mask, so 64 trades fit in a pair of words. Running sums
+// (ups minus downs) are kept for up to kMaxLookbacks lookbacks off the same
+// history: each push adds the new direction and subtracts the one leaving
+// each window, O(1) per lookback. Sum() answers any other lookback with
+// popcounts, 64 trades per word. Only SetLookbacks allocates.
+class TickMomentum {
+public:
+    static const int kMaxLookbacks = 4;
+
+    TickMomentum() : num_lookbacks_(0), count_(0), valid_(0), word_mask_(0) { SetLookback(0); }
+
+    // Sets the lookbacks to keep running sums for, the first kMaxLookbacks of
+    // them. History is kept; a longer window fills up again, like
+    // RingBuffer::SetWindow.
+    void SetLookbacks(const int* lookbacks, int num_lookbacks)
+    {
+        num_lookbacks_ = 0;
+        int longest = 0;
+        for (int i = 0; i < num_lookbacks && num_lookbacks_ < kMaxLookbacks; ++i) {
+            int lookback = lookbacks[i] > 0 ? lookbacks[i] : 0;
+            lookbacks_[num_lookbacks_++] = lookback;
+            if (lookback > longest) longest = lookback;
+        }
+
+        // History past the longest window, so its leaving direction is still
+        // held, and one spare word, so clearing the word a push starts never
+        // touches a window
+        std::size_t words = 2;
+        while (words * 64 - 64 <= static_cast<std::size_t>(longest)) words <<= 1;
+        if (words > up_.size()) Grow(words);
+
+        for (int i = 0; i < num_lookbacks_; ++i) {
+            sums_[i] = Sum(lookbacks_[i]);
+        }
+    }
+
+    void SetLookback(int lookback) { SetLookbacks(&lookback, 1); }
+
+    // direction: 1 up, -1 down, 0 unchanged
+    void Push(int direction)
+    {
+        uint64_t pos = count_++;
+        std::size_t word = static_cast<std::size_t>(pos >> 6) & word_mask_;
+        uint64_t up = uint64_t(direction > 0) << (pos & 63);
+        uint64_t down = uint64_t(direction < 0) << (pos & 63);
+        if ((pos & 63) == 0) {
+            up_[word] = up;
+            down_[word] = down;
+        } else {
+            up_[word] |= up;
+            down_[word] |= down;
+        }
+
+        if (valid_ < history()) ++valid_;
+        for (int i = 0; i < num_lookbacks_; ++i) {
+            sums_[i] += direction;
+            if (valid_ > static_cast<uint64_t>(lookbacks_[i])) {
+                sums_[i] -= Direction(pos - lookbacks_[i]);
+            }
+        }
+    }
+
+    // Running sum of lookback i over the trades seen so far
+    int sum(int i) const { return sums_[i]; }
+    int lookback(int i) const { return lookbacks_[i]; }
+    int num_lookbacks() const { return num_lookbacks_; }
+
+    // Whether lookback i has a full window of directions
+    bool full(int i) const { return valid_ >= static_cast<uint64_t>(lookbacks_[i]); }
+
+    // Ups minus downs over the last lookback trades, or as many as are known
+    int Sum(int lookback) const
+    {
+        uint64_t n = lookback > 0 ? static_cast<uint64_t>(lookback) : 0;
+        if (n > valid_) n = valid_;
+
+        uint64_t begin = count_ - n;
+        int sum = 0;
+        while (begin < count_) {
+            uint64_t end = (begin | 63) + 1;
+            if (end > count_) end = count_;
+            std::size_t word = static_cast<std::size_t>(begin >> 6) & word_mask_;
+            uint64_t mask = BitRange(begin & 63, end - begin);
+            sum += __builtin_popcountll(up_[word] & mask) - __builtin_popcountll(down_[word] & mask);
+            begin = end;
+        }
+        return sum;
+    }
+
+    // Longest lookback the history can answer
+    uint64_t history() const { return up_.size() * 64 - 64; }
+
+    void clear()
+    {
+        count_ = 0;
+        valid_ = 0;
+        for (int i = 0; i < num_lookbacks_; ++i) {
+            sums_[i] = 0;
+        }
+    }
+
+private:
+    // length bits starting at bit first, length >= 1
+    static uint64_t BitRange(uint64_t first, uint64_t length)
+    {
+        uint64_t bits = length >= 64 ? ~uint64_t(0) : (uint64_t(1) << length) - 1;
+        return bits << first;
+    }
+
+    int Direction(uint64_t pos) const
+    {
+        std::size_t word = static_cast<std::size_t>(pos >> 6) & word_mask_;
+        return static_cast<int>((up_[word] >> (pos & 63)) & 1) - static_cast<int>((down_[word] >> (pos & 63)) & 1);
+    }
+
+    // Moves the kept history to a larger power-of-two number of words
+    void Grow(std::size_t words)
+    {
+        std::vector<uint64_t> up(words, 0);
+        std::vector<uint64_t> down(words, 0);
+        if (valid_ > 0) {
+            for (uint64_t w = (count_ - valid_) >> 6; w <= (count_ - 1) >> 6; ++w) {
+                up[static_cast<std::size_t>(w) & (words - 1)] = up_[static_cast<std::size_t>(w) & word_mask_];
+                down[static_cast<std::size_t>(w) & (words - 1)] = down_[static_cast<std::size_t>(w) & word_mask_];
+            }
+        }
+        up_.swap(up);
+        down_.swap(down);
+        word_mask_ = words - 1;
+    }
+
+    int lookbacks_[kMaxLookbacks];
+    int sums_[kMaxLookbacks];
+    int num_lookbacks_;
+    uint64_t count_;            // Directions pushed since the last clear
+    uint64_t valid_;            // Newest directions still held, at most history()
+    std::size_t word_mask_;
+    std::vector<uint64_t> up_;
+    std::vector<uint64_t> down_;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_TICK_PRICE_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_TICK_PRICE_H_
+
+#include <cmath>
+#include <cstdint>
+
+// Fixed-point price: a whole number of the instrument's ticks. Prices are
+// converted once on the way in, so level comparisons, spreads and targets are
+// exact integer arithmetic instead of double math with rounding slop.
+typedef int64_t TickPrice;
+
+// Converts between double prices and TickPrice for one instrument
+class TickScale {
+public:
+    static constexpr double kDefaultTickSize = 0.01;
+
+    explicit TickScale(double tick_size = kDefaultTickSize) { set_tick_size(tick_size); }
+
+    // Nearest tick; use for prices that are already on the grid
+    TickPrice ToTicks(double price) const { return llround(price * ticks_per_unit_); }
+
+    // Highest tick at or below / lowest tick at or above price. A price within
+    // kGridTolerance of a tick counts as on it, so 100.03 / 0.01 computing to
+    // 10002.999... still floors to 10003.
+    TickPrice FloorTicks(double price) const
+    {
+        return static_cast<TickPrice>(floor(price * ticks_per_unit_ + kGridTolerance));
+    }
+
+    TickPrice CeilTicks(double price) const
+    {
+        return static_cast<TickPrice>(ceil(price * ticks_per_unit_ - kGridTolerance));
+    }
+
+    double ToPrice(TickPrice ticks) const { return ticks * tick_size_; }
+
+    // Falls back to the default for instruments that report no tick size
+    void set_tick_size(double tick_size)
+    {
+        tick_size_ = tick_size > 0 ? tick_size : kDefaultTickSize;
+        ticks_per_unit_ = 1.0 / tick_size_;
+    }
+
+    double tick_size() const { return tick_size_; }
+
+private:
+    static constexpr double kGridTolerance = 1e-6;
+
+    double tick_size_;
+    double ticks_per_unit_;
+};
+
+// Tick-count parameters are doubles; these give the whole-tick threshold to
+// compare an integer distance against.
+// distance <= ticks  <=>  distance <= TickCountFloor(ticks)
+inline TickPrice TickCountFloor(double ticks) { return static_cast<TickPrice>(floor(ticks + 1e-9)); }
+// distance >= ticks  <=>  distance >= TickCountCeil(ticks)
+inline TickPrice TickCountCeil(double ticks) { return static_cast<TickPrice>(ceil(ticks - 1e-9)); }
+
+#endif
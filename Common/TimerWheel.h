@@ -0,0 +1,252 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_COMMON_TIMER_WHEEL_H_
+#define _STRATEGY_STUDIO_LIB_COMMON_TIMER_WHEEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Deadlines for a fixed set of timer IDs (e.g. instrument slots), driven by
+// event time. A hierarchical timing wheel: kLevels levels of 64 buckets, the
+// buckets of level k spanning 64^k ticks of resolution_us. A timer sits in
+// the level where its deadline first differs from the current tick and moves
+// down a level each time the wheel reaches its bucket, so scheduling and
+// cancelling are O(1) list operations. A 64-bit occupancy mask per level lets
+// Advance jump straight to the next occupied bucket, however far event time
+// moves. Deadlines are kept in microseconds and a timer fires only once event
+// time reaches it; ticks only decide which bucket to look in.
+//
+// Deadlines past the top level's span wait in an overflow list that is
+// redistributed whenever the wheel enters a new top-level block.
+class TimerWheel {
+public:
+    static const int kLevels = 4;
+    static const int kNone = -1;
+
+    explicit TimerWheel(int64_t resolution_us = 1000) :
+        resolution_us_(resolution_us > 0 ? resolution_us : 1)
+    {
+        Reset(0);
+    }
+
+    // Cancels everything; IDs run 0..num_timers-1
+    void Reset(int num_timers)
+    {
+        timers_.assign(num_timers, Timer());
+        for (int b = 0; b < kBuckets; ++b) {
+            heads_[b] = kNone;
+        }
+        for (int level = 0; level < kLevels; ++level) {
+            occupied_[level] = 0;
+        }
+        current_tick_ = 0;
+        overflow_block_ = 0;
+        started_ = false;
+        advancing_ = false;
+        size_ = 0;
+    }
+
+    // Sets or moves the deadline of id
+    void Schedule(int id, int64_t deadline_us)
+    {
+        Cancel(id);
+        timers_[id].deadline_us = deadline_us;
+        Insert(id);
+        ++size_;
+    }
+
+    void Cancel(int id)
+    {
+        if (timers_[id].bucket == kNone) return;
+        Unlink(id);
+        --size_;
+    }
+
+    bool pending(int id) const { return timers_[id].bucket != kNone; }
+    int64_t deadline(int id) const { return timers_[id].deadline_us; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Call on entry to every event handler. Runs fire(id) for each timer whose
+    // deadline is at or before now_us, in tick order. fire may schedule and
+    // cancel timers; one due within this call fires before it returns.
+    template <typename FireFn>
+    void Advance(int64_t now_us, FireFn fire)
+    {
+        if (advancing_) return;
+        uint64_t target = TickOf(now_us);
+        if (!started_) {
+            current_tick_ = target;
+            started_ = true;
+        }
+        if (target < current_tick_) return;
+
+        advancing_ = true;
+        while (size_ > 0) {
+            uint64_t tick = NextTick();
+            if (tick > target) break;
+            current_tick_ = tick;
+            Cascade(tick);
+            if (FireBucket(tick & 63, now_us, fire) > 0) continue;  // fire may have scheduled more
+            if (tick == target) break;  // The rest are due later this tick; checked again next call
+            current_tick_ = tick + 1;
+        }
+        current_tick_ = target;
+        advancing_ = false;
+    }
+
+private:
+    static const int kBuckets = kLevels * 64 + 1;
+    static const int kOverflow = kLevels * 64;
+    static const int kTopShift = 6 * kLevels;
+
+    struct Timer {
+        Timer() : deadline_us(0), bucket(kNone), prev(kNone), next(kNone) {}
+
+        int64_t deadline_us;
+        int bucket;     // Index into heads_, kNone when not scheduled
+        int prev;
+        int next;
+    };
+
+    uint64_t TickOf(int64_t time_us) const
+    {
+        return time_us > 0 ? static_cast<uint64_t>(time_us / resolution_us_) : 0;
+    }
+
+    // Level where the deadline first differs from the current tick; a
+    // deadline already due goes into the current tick's bucket
+    void Insert(int id)
+    {
+        uint64_t tick = TickOf(timers_[id].deadline_us);
+        if (tick < current_tick_) tick = current_tick_;
+
+        int bucket = kOverflow;
+        for (int level = 0; level < kLevels; ++level) {
+            int shift = 6 * (level + 1);
+            if ((tick >> shift) == (current_tick_ >> shift)) {
+                bucket = level * 64 + static_cast<int>((tick >> (6 * level)) & 63);
+                break;
+            }
+        }
+        Link(id, bucket);
+    }
+
+    void Link(int id, int bucket)
+    {
+        Timer& timer = timers_[id];
+        timer.bucket = bucket;
+        timer.prev = kNone;
+        timer.next = heads_[bucket];
+        if (timer.next != kNone) timers_[timer.next].prev = id;
+        heads_[bucket] = id;
+        if (bucket != kOverflow) {
+            occupied_[bucket >> 6] |= uint64_t(1) << (bucket & 63);
+        }
+    }
+
+    void Unlink(int id)
+    {
+        Timer& timer = timers_[id];
+        if (timer.prev != kNone) {
+            timers_[timer.prev].next = timer.next;
+        } else {
+            heads_[timer.bucket] = timer.next;
+        }
+        if (timer.next != kNone) timers_[timer.next].prev = timer.prev;
+        if (heads_[timer.bucket] == kNone && timer.bucket != kOverflow) {
+            occupied_[timer.bucket >> 6] &= ~(uint64_t(1) << (timer.bucket & 63));
+        }
+        timer.bucket = kNone;
+        timer.prev = kNone;
+        timer.next = kNone;
+    }
+
+    // Earliest tick at or after current_tick_ with a bucket to fire or cascade
+    uint64_t NextTick() const
+    {
+        uint64_t next = ~uint64_t(0);
+        for (int level = 0; level < kLevels; ++level) {
+            int shift = 6 * level;
+            uint64_t digit = (current_tick_ >> shift) & 63;
+            uint64_t mask = occupied_[level] & (~uint64_t(0) << digit);
+            if (mask == 0) continue;
+
+            uint64_t block = current_tick_ >> (shift + 6) << (shift + 6);
+            uint64_t tick = block | (static_cast<uint64_t>(__builtin_ctzll(mask)) << shift);
+            if (tick < current_tick_) tick = current_tick_;     // Entered, not yet cascaded
+            if (tick < next) next = tick;
+        }
+        if (heads_[kOverflow] != kNone) {
+            uint64_t tick = (current_tick_ >> kTopShift) != overflow_block_ ?
+                current_tick_ : (overflow_block_ + 1) << kTopShift;
+            if (tick < next) next = tick;
+        }
+        return next;
+    }
+
+    // Moves the timers of every bucket the tick has entered down the levels
+    void Cascade(uint64_t tick)
+    {
+        if (heads_[kOverflow] != kNone && (tick >> kTopShift) != overflow_block_) {
+            overflow_block_ = tick >> kTopShift;
+            Redistribute(kOverflow);
+        }
+        for (int level = kLevels - 1; level > 0; --level) {
+            int bucket = level * 64 + static_cast<int>((tick >> (6 * level)) & 63);
+            if (heads_[bucket] != kNone) Redistribute(bucket);
+        }
+    }
+
+    void Redistribute(int bucket)
+    {
+        int id = heads_[bucket];
+        while (id != kNone) {
+            int next = timers_[id].next;
+            Unlink(id);
+            Insert(id);
+            id = next;
+        }
+    }
+
+    // Returns how many timers fired
+    template <typename FireFn>
+    int FireBucket(uint64_t bucket, int64_t now_us, FireFn& fire)
+    {
+        // Detach the due timers first, so fire can reschedule freely
+        int due = kNone;
+        int id = heads_[bucket];
+        while (id != kNone) {
+            int next = timers_[id].next;
+            if (timers_[id].deadline_us <= now_us) {
+                Unlink(id);
+                --size_;
+                timers_[id].next = due;
+                due = id;
+            }
+            id = next;
+        }
+        int fired = 0;
+        while (due != kNone) {
+            int next = timers_[due].next;
+            timers_[due].next = kNone;
+            fire(due);
+            ++fired;
+            due = next;
+        }
+        return fired;
+    }
+
+    std::vector<Timer> timers_;
+    int heads_[kBuckets];               // [level * 64 + digit], then the overflow list
+    uint64_t occupied_[kLevels];        // Non-empty buckets per level
+    int64_t resolution_us_;
+    uint64_t current_tick_;
+    uint64_t overflow_block_;           // Top-level block the overflow list was last sorted in
+    bool started_;
+    bool advancing_;
+    std::size_t size_;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_BOOK_LADDER_H_
+#define _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_BOOK_LADDER_H_
+
+// Compact top-N price-level ladder for one instrument. Each side keeps its
+// levels best-first together with a running cumulative size, so the liquidity
+// resting in the top k levels is a single array read.
+class BookLadder {
+public:
+    static const int kMaxLevels = 16;
+
+    BookLadder() : num_bids_(0), num_asks_(0) {}
+
+    void ClearBids() { num_bids_ = 0; }
+    void ClearAsks() { num_asks_ = 0; }
+    void clear() { num_bids_ = num_asks_ = 0; }
+
+    // Levels must be pushed best-first; anything beyond kMaxLevels is ignored
+    void PushBid(double price, double size) { Push(bid_price_, bid_cum_size_, num_bids_, price, size); }
+    void PushAsk(double price, double size) { Push(ask_price_, ask_cum_size_, num_asks_, price, size); }
+
+    // Total displayed size over the first `levels` levels of the side
+    double BidDepth(int levels) const { return Depth(bid_cum_size_, num_bids_, levels); }
+    double AskDepth(int levels) const { return Depth(ask_cum_size_, num_asks_, levels); }
+
+    int num_bids() const { return num_bids_; }
+    int num_asks() const { return num_asks_; }
+    bool empty() const { return num_bids_ == 0 && num_asks_ == 0; }
+
+    double bid_price(int level) const { return bid_price_[level]; }
+    double ask_price(int level) const { return ask_price_[level]; }
+    double bid_size(int level) const { return LevelSize(bid_cum_size_, level); }
+    double ask_size(int level) const { return LevelSize(ask_cum_size_, level); }
+
+private:
+    static void Push(double* prices, double* cum_sizes, int& count, double price, double size)
+    {
+        if (count >= kMaxLevels) return;
+        prices[count] = price;
+        cum_sizes[count] = size + (count > 0 ? cum_sizes[count - 1] : 0.0);
+        ++count;
+    }
+
+    static double LevelSize(const double* cum_sizes, int level)
+    {
+        return cum_sizes[level] - (level > 0 ? cum_sizes[level - 1] : 0.0);
+    }
+
+    static double Depth(const double* cum_sizes, int count, int levels)
+    {
+        int n = levels < count ? levels : count;
+        return n > 0 ? cum_sizes[n - 1] : 0.0;
+    }
+
+    double bid_price_[kMaxLevels];
+    double bid_cum_size_[kMaxLevels];
+    double ask_price_[kMaxLevels];
+    double ask_cum_size_[kMaxLevels];
+    int num_bids_;
+    int num_asks_;
+};
+
+#endif
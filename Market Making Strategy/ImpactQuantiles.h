@@ -0,0 +1,238 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_IMPACT_QUANTILES_H_
+#define _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_IMPACT_QUANTILES_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Order-statistic treap over doubles, backed by a preallocated node pool.
+// Insert and Erase are O(log n) expected, Kth is O(log n). Nodes are recycled
+// through a free list, so nothing is allocated once the pool covers the window.
+class OrderStatisticTree {
+public:
+    OrderStatisticTree() : root_(kNil), free_(kNil), seed_(0x9E3779B9u) {}
+
+    // Grows the node pool to hold at least `capacity` values; never shrinks
+    void Reserve(std::size_t capacity)
+    {
+        std::size_t old_capacity = nodes_.size();
+        if (capacity <= old_capacity) return;
+
+        nodes_.resize(capacity);
+        for (std::size_t i = capacity; i > old_capacity; --i) {
+            int32_t idx = static_cast<int32_t>(i - 1);
+            nodes_[idx].left = free_;
+            free_ = idx;
+        }
+    }
+
+    void Insert(double value)
+    {
+        if (free_ == kNil) {
+            Reserve(nodes_.empty() ? 16 : nodes_.size() * 2);
+        }
+
+        int32_t idx = free_;
+        free_ = nodes_[idx].left;
+
+        Node& node = nodes_[idx];
+        node.value = value;
+        node.priority = NextPriority();
+        node.left = kNil;
+        node.right = kNil;
+        node.size = 1;
+
+        root_ = InsertAt(root_, idx);
+    }
+
+    // Removes one occurrence of `value`; returns false if it is not present
+    bool Erase(double value)
+    {
+        bool erased = false;
+        root_ = EraseAt(root_, value, erased);
+        return erased;
+    }
+
+    // k-th smallest value, 0-based. Requires k < size()
+    double Kth(std::size_t k) const
+    {
+        int32_t t = root_;
+        while (t != kNil) {
+            std::size_t left_size = Size(nodes_[t].left);
+            if (k < left_size) {
+                t = nodes_[t].left;
+            } else if (k == left_size) {
+                return nodes_[t].value;
+            } else {
+                k -= left_size + 1;
+                t = nodes_[t].right;
+            }
+        }
+        return 0.0;
+    }
+
+    std::size_t size() const { return Size(root_); }
+    bool empty() const { return root_ == kNil; }
+    std::size_t capacity() const { return nodes_.size(); }
+
+    void clear()
+    {
+        std::size_t capacity = nodes_.size();
+        nodes_.clear();
+        root_ = kNil;
+        free_ = kNil;
+        Reserve(capacity);
+    }
+
+private:
+    static const int32_t kNil = -1;
+
+    struct Node {
+        double value;
+        uint32_t priority;
+        uint32_t size;
+        int32_t left;
+        int32_t right;
+    };
+
+    uint32_t Size(int32_t t) const { return t == kNil ? 0 : nodes_[t].size; }
+
+    void Update(int32_t t)
+    {
+        nodes_[t].size = 1 + Size(nodes_[t].left) + Size(nodes_[t].right);
+    }
+
+    uint32_t NextPriority()
+    {
+        // xorshift32
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        return seed_;
+    }
+
+    // Splits t into values < key (left) and values >= key (right)
+    void Split(int32_t t, double key, int32_t& left, int32_t& right)
+    {
+        if (t == kNil) {
+            left = right = kNil;
+        } else if (nodes_[t].value < key) {
+            Split(nodes_[t].right, key, nodes_[t].right, right);
+            left = t;
+            Update(t);
+        } else {
+            Split(nodes_[t].left, key, left, nodes_[t].left);
+            right = t;
+            Update(t);
+        }
+    }
+
+    int32_t Merge(int32_t left, int32_t right)
+    {
+        if (left == kNil) return right;
+        if (right == kNil) return left;
+        if (nodes_[left].priority > nodes_[right].priority) {
+            nodes_[left].right = Merge(nodes_[left].right, right);
+            Update(left);
+            return left;
+        }
+        nodes_[right].left = Merge(left, nodes_[right].left);
+        Update(right);
+        return right;
+    }
+
+    int32_t InsertAt(int32_t t, int32_t idx)
+    {
+        if (t == kNil) return idx;
+        if (nodes_[idx].priority > nodes_[t].priority) {
+            Split(t, nodes_[idx].value, nodes_[idx].left, nodes_[idx].right);
+            Update(idx);
+            return idx;
+        }
+        if (nodes_[idx].value < nodes_[t].value) {
+            nodes_[t].left = InsertAt(nodes_[t].left, idx);
+        } else {
+            nodes_[t].right = InsertAt(nodes_[t].right, idx);
+        }
+        Update(t);
+        return t;
+    }
+
+    int32_t EraseAt(int32_t t, double value, bool& erased)
+    {
+        if (t == kNil) return kNil;
+        if (nodes_[t].value == value) {
+            int32_t merged = Merge(nodes_[t].left, nodes_[t].right);
+            nodes_[t].left = free_;
+            free_ = t;
+            erased = true;
+            return merged;
+        }
+        if (value < nodes_[t].value) {
+            nodes_[t].left = EraseAt(nodes_[t].left, value, erased);
+        } else {
+            nodes_[t].right = EraseAt(nodes_[t].right, value, erased);
+        }
+        Update(t);
+        return t;
+    }
+
+    std::vector<Node> nodes_;
+    int32_t root_;
+    int32_t free_;      // Free list threaded through Node::left
+    uint32_t seed_;
+};
+
+// Buy- and sell-side impact distributions for one instrument. Positive impacts
+// are buys; everything else is a sell, stored as its absolute value.
+class ImpactQuantiles {
+public:
+    void Reserve(std::size_t window)
+    {
+        buy_.Reserve(window);
+        sell_.Reserve(window);
+    }
+
+    void Add(double impact)
+    {
+        if (impact > 0) {
+            buy_.Insert(impact);
+        } else {
+            sell_.Insert(std::fabs(impact));
+        }
+    }
+
+    void Remove(double impact)
+    {
+        if (impact > 0) {
+            buy_.Erase(impact);
+        } else {
+            sell_.Erase(std::fabs(impact));
+        }
+    }
+
+    // Same index rule as sorting the side and reading max(0, n * q - 1)
+    static double Quantile(const OrderStatisticTree& side, double q)
+    {
+        int idx = static_cast<int>(side.size() * q) - 1;
+        return side.Kth(idx > 0 ? idx : 0);
+    }
+
+    const OrderStatisticTree& buy() const { return buy_; }
+    const OrderStatisticTree& sell() const { return sell_; }
+
+    void clear()
+    {
+        buy_.clear();
+        sell_.clear();
+    }
+
+private:
+    OrderStatisticTree buy_;
+    OrderStatisticTree sell_;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_QUEUE_POSITION_H_
+#define _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_QUEUE_POSITION_H_
+
+#include <cmath>
+#include <cstdint>
+
+// Estimated place of one resting order in the displayed queue at its price.
+// The displayed size is taken as all ahead of us when the order is
+// acknowledged; trades at our price eat into it front-first, while other
+// size decreases at the level are cancels spread evenly through the queue.
+// Size added later joins behind us.
+struct QueuePosition {
+    QueuePosition() :
+        ahead(-1),
+        level_size(0) {}
+
+    bool known() const { return ahead >= 0; }
+    void Reset() { *this = QueuePosition(); }
+
+    // displayed_size < 0 means the level is not visible and stays unknown
+    void Snapshot(double displayed_size)
+    {
+        ahead = displayed_size;
+        level_size = displayed_size > 0 ? displayed_size : 0;
+    }
+
+    // Volume traded at our price
+    void OnTradeAtPrice(double size)
+    {
+        if (!known()) return;
+        ahead = ahead > size ? ahead - size : 0;
+        level_size = level_size > size ? level_size - size : 0;
+    }
+
+    // The market traded through our price, so nothing is left ahead
+    void OnTradeThrough()
+    {
+        if (!known()) return;
+        ahead = 0;
+    }
+
+    // New displayed size at our price
+    void OnLevelSize(double size)
+    {
+        if (!known()) return;
+        if (size < level_size && level_size > 0) {
+            ahead -= (level_size - size) * ahead / level_size;
+        }
+        if (ahead > size) ahead = size;
+        level_size = size;
+    }
+
+    double ahead;           // Displayed size ahead of us, < 0 when unknown
+    double level_size;      // Displayed size at our price when last seen
+};
+
+// Exponentially decayed rate of volume traded into one side of the book
+class TradeFlowRate {
+public:
+    TradeFlowRate() :
+        time_constant_us_(10000000),
+        volume_(0),
+        last_us_(0) {}
+
+    void OnTrade(int64_t now_us, double size)
+    {
+        volume_ = Decayed(now_us) + size;
+        last_us_ = now_us;
+    }
+
+    // Expected volume over the next horizon_us at the current rate
+    double ExpectedVolume(int64_t now_us, int64_t horizon_us) const
+    {
+        return Decayed(now_us) * horizon_us / time_constant_us_;
+    }
+
+    void set_time_constant_us(int64_t time_constant_us)
+    {
+        time_constant_us_ = time_constant_us > 0 ? time_constant_us : 1;
+    }
+
+    void clear()
+    {
+        volume_ = 0;
+        last_us_ = 0;
+    }
+
+private:
+    double Decayed(int64_t now_us) const
+    {
+        if (now_us <= last_us_) return volume_;
+        return volume_ * exp(-static_cast<double>(now_us - last_us_) / time_constant_us_);
+    }
+
+    int64_t time_constant_us_;
+    double volume_;         // Sum of sizes, each decayed by its age
+    int64_t last_us_;
+};
+
+// Chance that an order starts filling within the horizon, modelling the
+// volume traded at our price as exponential with the expected mean. Unknown
+// queue positions count as no chance, so they are never worth keeping.
+inline double FillProbability(const QueuePosition& queue, double expected_volume)
+{
+    if (!queue.known()) return 0;
+    if (queue.ahead <= 0) return 1;
+    if (expected_volume <= 0) return 0;
+    return exp(-queue.ahead / expected_volume);
+}
+
+#endif
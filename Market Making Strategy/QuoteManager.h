@@ -0,0 +1,353 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_QUOTE_MANAGER_H_
+#define _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_QUOTE_MANAGER_H_
+
+#include "ExecutionTypes.h"
+#include "QueuePosition.h"
+#include <TickPrice.h>
+
+#include <cstdint>
+
+using namespace RCM::StrategyStudio;
+
+// Message the caller should send to bring a resting order to its target
+enum QuoteAction {
+    QUOTE_ACTION_NONE,      // Nothing to send
+    QUOTE_ACTION_NEW,       // Level has no live order
+    QUOTE_ACTION_REPLACE,   // Live order moves to another price or size bucket
+    QUOTE_ACTION_CANCEL     // Live order is no longer needed
+};
+
+// Live order resting on the book
+struct RestingQuote {
+    enum Pending {
+        PENDING_NONE,       // Acknowledged, free to modify
+        PENDING_NEW,        // Sent, waiting for the open ack
+        PENDING_REPLACE,    // Cancel/replace sent, waiting for the modify ack
+        PENDING_CANCEL      // Cancel sent, waiting for the cancel ack
+    };
+
+    RestingQuote() :
+        order_id(0),
+        price_ticks(0),
+        price(0),
+        size(0),
+        pending(PENDING_NONE),
+        replace_price_ticks(0),
+        replace_price(0),
+        replace_size(0) {}
+
+    bool live() const { return order_id != 0; }
+    void Reset() { *this = RestingQuote(); }
+
+    // Price the order is resting at or, with a replace in flight, moving to
+    TickPrice target_ticks() const { return pending == PENDING_REPLACE ? replace_price_ticks : price_ticks; }
+
+    OrderID order_id;
+    TickPrice price_ticks;  // Price on the instrument's tick grid
+    double price;
+    int size;               // Remaining size
+    Pending pending;
+    TickPrice replace_price_ticks;  // Requested by the replace in flight, applied on its ack
+    double replace_price;
+    int replace_size;
+    QueuePosition queue;    // Where the order sits at its price
+};
+
+struct QuoteStats {
+    QuoteStats() :
+        sent_new(0),
+        sent_replace(0),
+        sent_cancel(0),
+        suppressed(0),
+        kept_stale(0) {}
+
+    uint64_t sent() const { return sent_new + sent_replace + sent_cancel; }
+
+    uint64_t sent_new;
+    uint64_t sent_replace;
+    uint64_t sent_cancel;
+    uint64_t suppressed;    // Updates that needed no message
+    uint64_t kept_stale;    // ...of which kept an order off its target for its queue position
+};
+
+// Target level of a quote ladder
+struct LadderLevel {
+    TickPrice price_ticks;
+    double price;
+    int size;
+};
+
+// Resting orders on one side of the book, up to kMaxLevels ladder levels.
+// There is room for twice that many so orders still waiting on their cancel
+// ack never block the levels replacing them.
+struct QuoteLadder {
+    static const int kMaxLevels = 8;
+    static const int kMaxOrders = 2 * kMaxLevels;
+
+    // Resting order with the given ID, or nullptr
+    RestingQuote* Find(OrderID order_id) {
+        for (int i = 0; i < kMaxOrders; ++i) {
+            if (orders[i].live() && orders[i].order_id == order_id) return &orders[i];
+        }
+        return nullptr;
+    }
+
+    // Unused order slot, or nullptr if every slot is live
+    RestingQuote* FreeOrder() {
+        for (int i = 0; i < kMaxOrders; ++i) {
+            if (!orders[i].live()) return &orders[i];
+        }
+        return nullptr;
+    }
+
+    RestingQuote orders[kMaxOrders];
+};
+
+// Keep-stale policy that never keeps an order off its target price
+struct NeverKeepStale {
+    bool operator()(const RestingQuote&, const LadderLevel&) const { return false; }
+};
+
+// One message of a ladder update
+struct LadderStep {
+    QuoteAction action;
+    int order;      // Index into QuoteLadder::orders, -1 for NEW
+    int level;      // Index into the target levels, -1 for CANCEL
+};
+
+// Diffs target ladders against what is resting and plans the fewest messages
+// that bring each side to its target. Sizes are compared by bucket so small
+// inventory driven size drift does not cost a cancel/replace and our queue
+// position.
+class QuoteManager {
+public:
+    static const int kMaxSteps = QuoteLadder::kMaxOrders + QuoteLadder::kMaxLevels;
+
+    QuoteManager() : size_bucket_(1) {}
+
+    // Fills steps (room for kMaxSteps) with the messages for one side, cancels
+    // first, and returns how many there are. Levels must have distinct prices
+    // and a positive size; num_levels == 0 pulls the whole side.
+    //
+    // Orders already resting at a target price stay put. So does an order
+    // keep_stale(order, level) accepts for a free level near it, which lets
+    // the caller trade a slightly stale price for queue priority. Each
+    // remaining order is moved onto a remaining level with one
+    // cancel/replace, so shifting a ladder by its spacing moves only the order
+    // falling off the far end. An order still waiting on its ack can't move
+    // and holds the free level nearest it. Orders left over are cancelled,
+    // levels left over get new orders.
+    int PlanLadder(const QuoteLadder& ladder, const LadderLevel* levels, int num_levels, LadderStep* steps)
+    {
+        return PlanLadder(ladder, levels, num_levels, steps, NeverKeepStale());
+    }
+
+    template <typename KeepStale>
+    int PlanLadder(const QuoteLadder& ladder, const LadderLevel* levels, int num_levels, LadderStep* steps,
+                   KeepStale keep_stale)
+    {
+        bool level_taken[QuoteLadder::kMaxLevels] = {};
+        int unmatched[QuoteLadder::kMaxOrders];
+        int num_unmatched = 0;
+        int num_free = 0;
+
+        LadderStep replaces[QuoteLadder::kMaxOrders];
+        int num_replaces = 0;
+
+        for (int i = 0; i < QuoteLadder::kMaxOrders; ++i) {
+            const RestingQuote& quote = ladder.orders[i];
+            if (!quote.live()) {
+                ++num_free;
+                continue;
+            }
+            if (quote.pending == RestingQuote::PENDING_CANCEL) {
+                ++stats_.suppressed;
+                continue;
+            }
+
+            int level = FindLevel(levels, num_levels, level_taken, quote.target_ticks());
+            if (level < 0) {
+                unmatched[num_unmatched++] = i;
+                continue;
+            }
+            level_taken[level] = true;
+
+            // Never stack a second message on an unacknowledged one. Only the
+            // top level is resized in place; deeper orders keep their size
+            // until they move, so a shifted ladder's decaying sizes do not
+            // turn into a replace per level.
+            if (level == 0 && quote.pending == RestingQuote::PENDING_NONE &&
+                Bucket(quote.size) != Bucket(levels[level].size)) {
+                replaces[num_replaces++] = MakeStep(QUOTE_ACTION_REPLACE, i, level);
+            } else {
+                ++stats_.suppressed;
+            }
+        }
+
+        // An unacknowledged order can't be moved yet but will rest, so it
+        // holds the free level nearest its price and no new order is stacked
+        // there. It moves or is cancelled on a requote after its ack.
+        for (int u = 0; u < num_unmatched; ++u) {
+            const RestingQuote& quote = ladder.orders[unmatched[u]];
+            if (quote.pending == RestingQuote::PENDING_NONE) continue;
+            int level = FindNearestLevel(levels, num_levels, level_taken, quote.target_ticks());
+            if (level >= 0) level_taken[level] = true;
+            ++stats_.suppressed;
+        }
+
+        int num_steps = 0;
+        int next_level = 0;
+        for (int u = 0; u < num_unmatched; ++u) {
+            const RestingQuote& quote = ladder.orders[unmatched[u]];
+            if (quote.pending != RestingQuote::PENDING_NONE) continue;
+
+            int kept_level = FindStaleLevel(levels, num_levels, level_taken, quote, keep_stale);
+            if (kept_level >= 0) {
+                level_taken[kept_level] = true;
+                ++stats_.suppressed;
+                ++stats_.kept_stale;
+                continue;
+            }
+
+            while (next_level < num_levels && level_taken[next_level]) ++next_level;
+            if (next_level < num_levels) {
+                level_taken[next_level] = true;
+                replaces[num_replaces++] = MakeStep(QUOTE_ACTION_REPLACE, unmatched[u], next_level);
+            } else {
+                steps[num_steps++] = MakeStep(QUOTE_ACTION_CANCEL, unmatched[u], -1);
+            }
+        }
+
+        for (int r = 0; r < num_replaces; ++r) {
+            steps[num_steps++] = replaces[r];
+        }
+
+        for (int level = 0; level < num_levels && num_free > 0; ++level) {
+            if (level_taken[level]) continue;
+            steps[num_steps++] = MakeStep(QUOTE_ACTION_NEW, -1, level);
+            --num_free;
+        }
+
+        return num_steps;
+    }
+
+    void RecordNew(RestingQuote& quote, OrderID order_id, TickPrice price_ticks, double price, int size)
+    {
+        quote.order_id = order_id;
+        quote.price_ticks = price_ticks;
+        quote.price = price;
+        quote.size = size;
+        quote.pending = RestingQuote::PENDING_NEW;
+        ++stats_.sent_new;
+    }
+
+    // Cancel/replace keeps the order ID. The order keeps its old price and
+    // size until the modify ack, so a rejected replace leaves it as it was.
+    void RecordReplace(RestingQuote& quote, TickPrice price_ticks, double price, int size)
+    {
+        quote.replace_price_ticks = price_ticks;
+        quote.replace_price = price;
+        quote.replace_size = size;
+        quote.pending = RestingQuote::PENDING_REPLACE;
+        ++stats_.sent_replace;
+    }
+
+    void RecordCancel(RestingQuote& quote)
+    {
+        quote.pending = RestingQuote::PENDING_CANCEL;
+        ++stats_.sent_cancel;
+    }
+
+    static void OnAcknowledged(RestingQuote& quote)
+    {
+        if (quote.pending == RestingQuote::PENDING_NEW) {
+            quote.pending = RestingQuote::PENDING_NONE;
+        }
+    }
+
+    // Modify ack: the replace is applied and the order goes to the back of
+    // its new queue, which the caller snapshots
+    static void OnReplaced(RestingQuote& quote)
+    {
+        if (quote.pending != RestingQuote::PENDING_REPLACE) return;
+        quote.price_ticks = quote.replace_price_ticks;
+        quote.price = quote.replace_price;
+        quote.size = quote.replace_size;
+        quote.pending = RestingQuote::PENDING_NONE;
+        quote.queue.Reset();
+    }
+
+    // Cancel reject: a rejected cancel or replace leaves the order working
+    // unchanged and free to modify again
+    static void OnCancelRejected(RestingQuote& quote)
+    {
+        if (quote.pending == RestingQuote::PENDING_REPLACE || quote.pending == RestingQuote::PENDING_CANCEL) {
+            quote.pending = RestingQuote::PENDING_NONE;
+        }
+    }
+
+    static void OnPartialFill(RestingQuote& quote, int fill_size)
+    {
+        OnAcknowledged(quote);
+        quote.size -= fill_size;
+        if (quote.size < 0) quote.size = 0;
+    }
+
+    void set_size_bucket(int size_bucket) { size_bucket_ = size_bucket > 0 ? size_bucket : 1; }
+
+    const QuoteStats& stats() const { return stats_; }
+    void ResetStats() { stats_ = QuoteStats(); }
+
+private:
+    int Bucket(int size) const { return size / size_bucket_; }
+
+    static int FindLevel(const LadderLevel* levels, int num_levels, const bool* level_taken, TickPrice price_ticks)
+    {
+        for (int level = 0; level < num_levels; ++level) {
+            if (!level_taken[level] && levels[level].price_ticks == price_ticks) return level;
+        }
+        return -1;
+    }
+
+    static int FindNearestLevel(const LadderLevel* levels, int num_levels, const bool* level_taken, TickPrice price_ticks)
+    {
+        int nearest = -1;
+        TickPrice nearest_distance = 0;
+        for (int level = 0; level < num_levels; ++level) {
+            if (level_taken[level]) continue;
+            TickPrice distance = levels[level].price_ticks > price_ticks ? levels[level].price_ticks - price_ticks
+                                                                         : price_ticks - levels[level].price_ticks;
+            if (nearest < 0 || distance < nearest_distance) {
+                nearest = level;
+                nearest_distance = distance;
+            }
+        }
+        return nearest;
+    }
+
+    template <typename KeepStale>
+    static int FindStaleLevel(const LadderLevel* levels, int num_levels, const bool* level_taken,
+                              const RestingQuote& quote, KeepStale& keep_stale)
+    {
+        for (int level = 0; level < num_levels; ++level) {
+            if (!level_taken[level] && keep_stale(quote, levels[level])) return level;
+        }
+        return -1;
+    }
+
+    static LadderStep MakeStep(QuoteAction action, int order, int level)
+    {
+        LadderStep step;
+        step.action = action;
+        step.order = order;
+        step.level = level;
+        return step;
+    }
+
+    int size_bucket_;
+    QuoteStats stats_;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_REQUOTE_SCHEDULER_H_
+#define _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_REQUOTE_SCHEDULER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct RequoteStats {
+    RequoteStats() :
+        marked(0),
+        coalesced(0),
+        requotes(0),
+        max_staleness_us(0) {}
+
+    uint64_t marked;            // Events that asked for a requote
+    uint64_t coalesced;         // ...of which found the instrument already dirty
+    uint64_t requotes;          // Requotes actually run
+    int64_t max_staleness_us;   // Longest wait from first dirty mark to requote
+};
+
+// Coalesces requote requests. Events only mark an instrument slot dirty; the
+// dirty slots are requoted once when the burst ends, i.e. when an event with a
+// later timestamp arrives. A slot requoted less than min_interval_us ago
+// stays dirty until a later flush.
+class RequoteScheduler {
+public:
+    RequoteScheduler() :
+        min_interval_us_(0),
+        burst_time_us_(std::numeric_limits<int64_t>::min()),
+        flushing_(false) {}
+
+    void Reset(int num_slots)
+    {
+        slots_.assign(num_slots, Slot());
+        dirty_.clear();
+        dirty_.reserve(num_slots);
+        flushing_slots_.clear();
+        flushing_slots_.reserve(num_slots);
+        burst_time_us_ = std::numeric_limits<int64_t>::min();
+    }
+
+    void MarkDirty(int slot, int64_t now_us)
+    {
+        ++stats_.marked;
+        Slot& entry = slots_[slot];
+        if (entry.dirty) {
+            ++stats_.coalesced;
+            return;
+        }
+        entry.dirty = true;
+        entry.first_dirty_us = now_us;
+        dirty_.push_back(slot);
+    }
+
+    // Call on entry to every event handler. Runs requote(slot) for each dirty
+    // slot that is due once the event time has moved past the current burst.
+    template <typename RequoteFn>
+    void Flush(int64_t now_us, RequoteFn requote)
+    {
+        if (now_us <= burst_time_us_ || flushing_) return;
+        burst_time_us_ = now_us;
+        if (dirty_.empty()) return;
+
+        // Requotes can trigger nested order updates; they must not re-enter.
+        // They can also mark slots dirty, so the list is swapped out first and
+        // those marks land in dirty_ for the next flush.
+        flushing_ = true;
+        flushing_slots_.swap(dirty_);
+        for (std::size_t i = 0; i < flushing_slots_.size(); ++i) {
+            int slot = flushing_slots_[i];
+            Slot& entry = slots_[slot];
+            if (now_us - entry.last_requote_us < min_interval_us_) {
+                dirty_.push_back(slot);
+                continue;
+            }
+
+            int64_t staleness = now_us - entry.first_dirty_us;
+            if (staleness > stats_.max_staleness_us) {
+                stats_.max_staleness_us = staleness;
+            }
+            entry.dirty = false;
+            entry.last_requote_us = now_us;
+            ++stats_.requotes;
+            requote(slot);
+        }
+        flushing_slots_.clear();
+        flushing_ = false;
+    }
+
+    void set_min_interval_us(int64_t min_interval_us) { min_interval_us_ = min_interval_us; }
+
+    const RequoteStats& stats() const { return stats_; }
+    void ResetStats() { stats_ = RequoteStats(); }
+
+private:
+    struct Slot {
+        Slot() :
+            dirty(false),
+            first_dirty_us(0),
+            last_requote_us(std::numeric_limits<int64_t>::min() / 2) {}
+
+        bool dirty;
+        int64_t first_dirty_us;
+        int64_t last_requote_us;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<int> dirty_;
+    std::vector<int> flushing_slots_;   // dirty_ as it stood when the running flush began
+    int64_t min_interval_us_;
+    int64_t burst_time_us_;
+    bool flushing_;
+    RequoteStats stats_;
+};
+
+#endif
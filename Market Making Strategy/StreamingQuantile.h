@@ -0,0 +1,225 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_STREAMING_QUANTILE_H_
+#define _STRATEGY_STUDIO_LIB_TRADE_IMPACT_MM_STREAMING_QUANTILE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// How TradeImpactMM estimates its impact quantiles
+enum QuantileMode {
+    QUANTILE_MODE_EXACT = 0,    // Exact over the last rolling_window trades
+    QUANTILE_MODE_P2 = 1,       // P-square estimate over every trade seen
+    QUANTILE_MODE_DECAYED = 2   // Exponentially decayed estimate, memory ~rolling_window trades
+};
+
+// P-square streaming estimate of one quantile (Jain & Chlamtac, 1985). Five
+// markers track the minimum, the p/2, p and (1+p)/2 quantiles and the maximum;
+// each sample moves the marker heights by piecewise-parabolic interpolation.
+// O(1) time and memory per sample, no window kept.
+class P2Quantile {
+public:
+    explicit P2Quantile(double p = 0.5) { Reset(p); }
+
+    void Reset(double p)
+    {
+        p_ = p;
+        count_ = 0;
+        increment_[0] = 0;
+        increment_[1] = p / 2;
+        increment_[2] = p;
+        increment_[3] = (1 + p) / 2;
+        increment_[4] = 1;
+    }
+
+    void Add(double x)
+    {
+        if (count_ < 5) {
+            height_[count_++] = x;
+            if (count_ == 5) {
+                std::sort(height_, height_ + 5);
+                for (int i = 0; i < 5; ++i) {
+                    position_[i] = i + 1;
+                    desired_[i] = 1 + 4 * increment_[i];
+                }
+            }
+            return;
+        }
+        ++count_;
+
+        // Cell the sample falls in, stretching the extremes if needed
+        int k;
+        if (x < height_[0]) {
+            height_[0] = x;
+            k = 0;
+        } else if (x >= height_[4]) {
+            height_[4] = x;
+            k = 3;
+        } else {
+            k = 0;
+            while (k < 3 && x >= height_[k + 1]) ++k;
+        }
+
+        for (int i = k + 1; i < 5; ++i) {
+            ++position_[i];
+        }
+        for (int i = 0; i < 5; ++i) {
+            desired_[i] += increment_[i];
+        }
+
+        // Nudge the middle markers towards their desired positions
+        for (int i = 1; i < 4; ++i) {
+            double d = desired_[i] - position_[i];
+            if ((d >= 1 && position_[i + 1] - position_[i] > 1) ||
+                (d <= -1 && position_[i - 1] - position_[i] < -1)) {
+                int step = d > 0 ? 1 : -1;
+                double height = Parabolic(i, step);
+                if (height_[i - 1] < height && height < height_[i + 1]) {
+                    height_[i] = height;
+                } else {
+                    height_[i] = Linear(i, step);
+                }
+                position_[i] += step;
+            }
+        }
+    }
+
+    // Until five samples arrive this is the exact sample quantile
+    double Estimate() const
+    {
+        if (count_ >= 5) return height_[2];
+        if (count_ == 0) return 0;
+
+        double sorted[5];
+        std::copy(height_, height_ + count_, sorted);
+        std::sort(sorted, sorted + count_);
+        int idx = static_cast<int>(count_ * p_) - 1;
+        return sorted[idx > 0 ? idx : 0];
+    }
+
+    uint64_t count() const { return count_; }
+
+private:
+    double Parabolic(int i, int d) const
+    {
+        double n_prev = position_[i - 1];
+        double n = position_[i];
+        double n_next = position_[i + 1];
+        return height_[i] + d / (n_next - n_prev) *
+               ((n - n_prev + d) * (height_[i + 1] - height_[i]) / (n_next - n) +
+                (n_next - n - d) * (height_[i] - height_[i - 1]) / (n - n_prev));
+    }
+
+    double Linear(int i, int d) const
+    {
+        return height_[i] + d * (height_[i + d] - height_[i]) / (position_[i + d] - position_[i]);
+    }
+
+    double p_;
+    uint64_t count_;
+    double height_[5];      // Marker heights (first five samples until count_ == 5)
+    double position_[5];    // Actual marker positions, 1-based
+    double desired_[5];     // Desired marker positions
+    double increment_[5];   // Desired position increment per sample
+};
+
+// Exponentially decayed quantile estimate by stochastic approximation: every
+// sample nudges the estimate up by p or down by 1 - p, scaled by a decayed
+// mean absolute deviation so the step follows the data's spread. Recent
+// samples dominate with an effective memory of about `window` samples, so it
+// tracks a drifting distribution the way a rolling window would.
+class DecayedQuantile {
+public:
+    explicit DecayedQuantile(double p = 0.5, int window = 100) { Reset(p, window); }
+
+    void Reset(double p, int window)
+    {
+        p_ = p;
+        count_ = 0;
+        estimate_ = 0;
+        deviation_ = 0;
+        set_window(window);
+    }
+
+    void Add(double x)
+    {
+        ++count_;
+        if (count_ == 1) {
+            estimate_ = x;
+            return;
+        }
+
+        // Plain averaging while warming up, then a fixed decay
+        double alpha = std::max(alpha_, 1.0 / count_);
+        deviation_ += alpha * (std::fabs(x - estimate_) - deviation_);
+        estimate_ += kStepScale * alpha * deviation_ * (x < estimate_ ? p_ - 1 : p_);
+    }
+
+    double Estimate() const { return estimate_; }
+    uint64_t count() const { return count_; }
+
+    void set_window(int window) { alpha_ = 1.0 / std::max(window, 1); }
+
+private:
+    static constexpr double kStepScale = 2.0;  // Tuned on the QuantileBench streams
+
+    double p_;
+    double alpha_;
+    uint64_t count_;
+    double estimate_;
+    double deviation_;      // Decayed mean |x - estimate|
+};
+
+// Streaming counterpart of ImpactQuantiles: buy and sell impact quantiles in
+// constant memory. Positive impacts are buys; everything else is a sell,
+// stored as its absolute value.
+class StreamingImpactQuantiles {
+public:
+    StreamingImpactQuantiles() : mode_(QUANTILE_MODE_P2) {}
+
+    // Starts over; P-square tracks a fixed quantile, so a new q needs this too
+    void Reset(QuantileMode mode, double q, int window)
+    {
+        mode_ = mode;
+        buy_p2_.Reset(q);
+        sell_p2_.Reset(q);
+        buy_decayed_.Reset(q, SideWindow(window));
+        sell_decayed_.Reset(q, SideWindow(window));
+    }
+
+    void Add(double impact)
+    {
+        bool is_buy = impact > 0;
+        double value = std::fabs(impact);
+        if (mode_ == QUANTILE_MODE_DECAYED) {
+            (is_buy ? buy_decayed_ : sell_decayed_).Add(value);
+        } else {
+            (is_buy ? buy_p2_ : sell_p2_).Add(value);
+        }
+    }
+
+    double BuyQuantile() const { return mode_ == QUANTILE_MODE_DECAYED ? buy_decayed_.Estimate() : buy_p2_.Estimate(); }
+    double SellQuantile() const { return mode_ == QUANTILE_MODE_DECAYED ? sell_decayed_.Estimate() : sell_p2_.Estimate(); }
+
+    uint64_t buy_count() const { return mode_ == QUANTILE_MODE_DECAYED ? buy_decayed_.count() : buy_p2_.count(); }
+    uint64_t sell_count() const { return mode_ == QUANTILE_MODE_DECAYED ? sell_decayed_.count() : sell_p2_.count(); }
+
+    void set_window(int window)
+    {
+        buy_decayed_.set_window(SideWindow(window));
+        sell_decayed_.set_window(SideWindow(window));
+    }
+
+private:
+    // The window counts trades on both sides; each side sees about half
+    static int SideWindow(int window) { return window / 2 > 1 ? window / 2 : 1; }
+
+    QuantileMode mode_;
+    P2Quantile buy_p2_;
+    P2Quantile sell_p2_;
+    DecayedQuantile buy_decayed_;
+    DecayedQuantile sell_decayed_;
+};
+
+#endif
@@ -14,11 +14,13 @@ using namespace RCM::StrategyStudio::MarketModels;
 using namespace RCM::StrategyStudio::Utilities;
 using namespace std;
 
-TradeImpactMM::TradeImpactMM(StrategyID strategyID, const std::string& strategyName, const std::string& groupName):
+template <typename Policy>
+TradeImpactMMT<Policy>::TradeImpactMMT(StrategyID strategyID, const std::string& strategyName, const std::string& groupName):
     Strategy(strategyID, strategyName, groupName),
     impact_multiplier_(2.5),
     rolling_window_(50),
     quantile_threshold_(0.1),
+    quantile_mode_(QUANTILE_MODE_EXACT),
     levels_to_consider_(4),
     tick_size_(0.01),
     max_position_(100),
@@ -28,30 +30,68 @@ TradeImpactMM::TradeImpactMM(StrategyID strategyID, const std::string& strategyN
     quote_size_(100),
     min_quote_size_(10),
     max_quote_size_(1000),
-    debug_(true)
+    size_bucket_(10),
+    ladder_levels_(1),
+    ladder_spacing_ticks_(1),
+    ladder_size_decay_(0.5),
+    coalesce_quotes_(false),
+    min_requote_interval_us_(0),
+    queue_keep_probability_(0),
+    queue_keep_ticks_(1),
+    queue_horizon_ms_(1000),
+    latency_stats_(false),
+    decision_journal_(false),
+    debug_(true),
+    log_path_(strategyName + ".log"),
+    latency_path_(strategyName + "_latency.csv"),
+    journal_path_(strategyName + ".journal")
 {
+    quote_manager_.set_size_bucket(size_bucket_);
+    requote_scheduler_.set_min_interval_us(min_requote_interval_us_);
 }
 
-TradeImpactMM::~TradeImpactMM()
+template <typename Policy>
+TradeImpactMMT<Policy>::~TradeImpactMMT()
 {
+    // The last day has no reset after it
+    if (Policy::kInstrumentation && latency_stats_) {
+        latency_.Dump(latency_path_, instrument_index_, "final");
+    }
 }
 
-void TradeImpactMM::OnResetStrategyState()
+template <typename Policy>
+void TradeImpactMMT<Policy>::OnResetStrategyState()
 {
     try {
-        trade_impacts_.clear();
-        instrument_states_.clear();
+        ReportQuoteStats();
+        quote_manager_.ResetStats();
+        requote_scheduler_.ResetStats();
+        requote_scheduler_.Reset(instrument_index_.size());
+        if (Policy::kInstrumentation && latency_stats_) {
+            ReportLatencyStats("eod");
+        }
+        ReconcilePositions();
+        position_book_.ResetRealized();
+        latency_.ClearHistograms();
+        // Slots stay assigned; only the per-instrument state is reset
+        for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+            ResetImpactState(slot);
+            book_ladders_[slot].clear();
+            instrument_states_[slot] = InstrumentState();
+        }
         LogDebug("Strategy state reset");
     } catch (const std::exception& e) {
         logger().LogToClient(LOGLEVEL_ERROR, std::string("Error in reset: ") + e.what());
     }
 }
 
-void TradeImpactMM::DefineStrategyParams()
+template <typename Policy>
+void TradeImpactMMT<Policy>::DefineStrategyParams()
 {
     params().CreateParam(CreateStrategyParamArgs("impact_multiplier", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, impact_multiplier_));
     params().CreateParam(CreateStrategyParamArgs("rolling_window", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, rolling_window_));
     params().CreateParam(CreateStrategyParamArgs("quantile_threshold", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, quantile_threshold_));
+    params().CreateParam(CreateStrategyParamArgs("quantile_mode", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, quantile_mode_));
     params().CreateParam(CreateStrategyParamArgs("levels_to_consider", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, levels_to_consider_));
     params().CreateParam(CreateStrategyParamArgs("tick_size", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, tick_size_));
     params().CreateParam(CreateStrategyParamArgs("max_position", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, max_position_));
@@ -61,36 +101,78 @@ void TradeImpactMM::DefineStrategyParams()
     params().CreateParam(CreateStrategyParamArgs("quote_size", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, quote_size_));
     params().CreateParam(CreateStrategyParamArgs("min_quote_size", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, min_quote_size_));
     params().CreateParam(CreateStrategyParamArgs("max_quote_size", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, max_quote_size_));
+    params().CreateParam(CreateStrategyParamArgs("size_bucket", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, size_bucket_));
+    params().CreateParam(CreateStrategyParamArgs("ladder_levels", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, ladder_levels_));
+    params().CreateParam(CreateStrategyParamArgs("ladder_spacing_ticks", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, ladder_spacing_ticks_));
+    params().CreateParam(CreateStrategyParamArgs("ladder_size_decay", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, ladder_size_decay_));
+    params().CreateParam(CreateStrategyParamArgs("coalesce_quotes", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_BOOL, coalesce_quotes_));
+    params().CreateParam(CreateStrategyParamArgs("min_requote_interval_us", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, min_requote_interval_us_));
+    params().CreateParam(CreateStrategyParamArgs("queue_keep_probability", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, queue_keep_probability_));
+    params().CreateParam(CreateStrategyParamArgs("queue_keep_ticks", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, queue_keep_ticks_));
+    params().CreateParam(CreateStrategyParamArgs("queue_horizon_ms", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, queue_horizon_ms_));
+    params().CreateParam(CreateStrategyParamArgs("latency_stats", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_BOOL, latency_stats_));
+    params().CreateParam(CreateStrategyParamArgs("decision_journal", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_BOOL, decision_journal_));
     params().CreateParam(CreateStrategyParamArgs("debug", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_BOOL, debug_));
 }
 
-void TradeImpactMM::RegisterForStrategyEvents(StrategyEventRegister* eventRegister, DateType currDate)
+template <typename Policy>
+void TradeImpactMMT<Policy>::RegisterForStrategyEvents(StrategyEventRegister* eventRegister, DateType currDate)
 {
     for (SymbolSetConstIter it = symbols_begin(); it != symbols_end(); ++it) {
         eventRegister->RegisterForMarketData(*it);
     }
 
     for (InstrumentSetConstIter it = instrument_begin(); it != instrument_end(); ++it) {
-        instrument_states_.emplace(it->second, InstrumentState());
+        instrument_index_.Add(it->second);
+    }
+
+    int num_slots = instrument_index_.size();
+    trade_impacts_.resize(num_slots);
+    impact_quantiles_.resize(num_slots);
+    streaming_quantiles_.resize(num_slots);
+    book_ladders_.resize(num_slots);
+    instrument_states_.resize(num_slots);
+    tick_scales_.resize(num_slots);
+    UpdateTickScales();
+    position_book_.Reset(num_slots);
+    for (int slot = 0; slot < num_slots; ++slot) {
+        ResetImpactState(slot);
+    }
+    requote_scheduler_.Reset(num_slots);
+    latency_.Reset(num_slots);
+    latency_.set_enabled(Policy::kInstrumentation && latency_stats_);
+
+    if (Policy::kDebugLog && debug_) {
+        log_.Start(log_path_);
+    }
+    if (decision_journal_) {
+        StartJournal();
     }
     
     LogDebug("Strategy events registered");
 }
 
-double TradeImpactMM::CalculateTradeImpact(const Instrument* instrument, double trade_size, bool is_buy)
+template <typename Policy>
+double TradeImpactMMT<Policy>::CalculateTradeImpact(int slot, double trade_size, bool is_buy)
 {
     double total_bid_size = 0;
     double total_ask_size = 0;
-    
-    const Quote& quote = instrument->top_quote();
-    
-    // Sum up liquidity for top levels
-    if (quote.bid_side().IsValid()) {
-        total_bid_size = quote.bid_side().size();
-    }
-    
-    if (quote.ask_side().IsValid()) {
-        total_ask_size = quote.ask_side().size();
+
+    // Sum up liquidity for top levels, falling back to the top of book until depth arrives
+    const BookLadder& ladder = book_ladders_[slot];
+    if (!ladder.empty()) {
+        total_bid_size = ladder.BidDepth(levels_to_consider_);
+        total_ask_size = ladder.AskDepth(levels_to_consider_);
+    } else {
+        const Quote& quote = instrument_index_.instrument(slot)->top_quote();
+
+        if (quote.bid_side().IsValid()) {
+            total_bid_size = quote.bid_side().size();
+        }
+
+        if (quote.ask_side().IsValid()) {
+            total_ask_size = quote.ask_side().size();
+        }
     }
     
     if (total_bid_size + total_ask_size == 0) return 0;
@@ -99,87 +181,96 @@ double TradeImpactMM::CalculateTradeImpact(const Instrument* instrument, double
            (trade_size / (total_bid_size + total_ask_size));
 }
 
-std::pair<double, double> TradeImpactMM::CalculateQuotes(const Instrument* instrument)
+template <typename Policy>
+std::pair<TickPrice, TickPrice> TradeImpactMMT<Policy>::CalculateQuotes(const Instrument* instrument, int slot)
 {
-    auto& impacts = trade_impacts_[instrument];
-    if (impacts.size() < rolling_window_) {
-        return std::make_pair(0.0, 0.0);
-    }    
+    const std::pair<TickPrice, TickPrice> no_quotes(0, 0);
 
-    vector<double> buy_impacts, sell_impacts;
-    for (const auto& impact : impacts) {
-        if (impact > 0) {
-            buy_impacts.push_back(impact);
-        } else {
-            sell_impacts.push_back(abs(impact));
-        }
+    // An empty window has no quantiles to quote from
+    if (rolling_window_ <= 0) {
+        return no_quotes;
     }
 
-    if (buy_impacts.empty() || sell_impacts.empty()) {
-        return std::make_pair(0.0, 0.0);
-    }
+    double buy_quantile;
+    double sell_quantile;
+    if (quantile_mode_ == QUANTILE_MODE_EXACT) {
+        const auto& impacts = trade_impacts_[slot];
+        if (!impacts.full()) {
+            return no_quotes;
+        }    
 
-    sort(buy_impacts.begin(), buy_impacts.end());
-    sort(sell_impacts.begin(), sell_impacts.end());
+        const auto& quantiles = impact_quantiles_[slot];
+        if (quantiles.buy().empty() || quantiles.sell().empty()) {
+            return no_quotes;
+        }
 
-    int buy_idx = max(0, (int)(buy_impacts.size() * quantile_threshold_) - 1);
-    int sell_idx = max(0, (int)(sell_impacts.size() * quantile_threshold_) - 1);
+        buy_quantile = ImpactQuantiles::Quantile(quantiles.buy(), quantile_threshold_);
+        sell_quantile = ImpactQuantiles::Quantile(quantiles.sell(), quantile_threshold_);
+    } else {
+        // Streaming estimates warm up over one window's worth of trades
+        const auto& streaming = streaming_quantiles_[slot];
+        if (streaming.buy_count() == 0 || streaming.sell_count() == 0 ||
+            streaming.buy_count() + streaming.sell_count() < static_cast<uint64_t>(max(rolling_window_, 0))) {
+            return no_quotes;
+        }
 
-    double buy_quantile = buy_impacts[buy_idx];
-    double sell_quantile = sell_impacts[sell_idx];
+        buy_quantile = streaming.BuyQuantile();
+        sell_quantile = streaming.SellQuantile();
+    }
 
     const Quote& quote = instrument->top_quote();
     if (!quote.ask_side().IsValid() || !quote.bid_side().IsValid()) {
-        return std::make_pair(0.0, 0.0);
+        return no_quotes;
     }
 
     double mid_price = (quote.ask() + quote.bid()) / 2.0;
 
     // Position adjustment
-    double position_factor = (portfolio().position(instrument) / max_position_) * risk_limit_pct_;
+    double position_factor = (position_book_.position(slot) / max_position_) * risk_limit_pct_;
 
     // Calculate theoretical prices
     double theo_bid = mid_price - sell_quantile - (position_factor * mid_price);
     double theo_ask = mid_price + buy_quantile - (position_factor * mid_price);
 
+    // Round outwards onto the tick grid; from here on prices are whole ticks
+    const TickScale& scale = tick_scales_[slot];
+    TickPrice bid_ticks = scale.FloorTicks(theo_bid);
+    TickPrice ask_ticks = scale.CeilTicks(theo_ask);
+
     // Apply spread constraints
-    double min_spread = min_spread_ticks_ * tick_size_;
-    double max_spread = max_spread_ticks_ * tick_size_;
-    if (theo_ask - theo_bid < min_spread) {
-        double mid = (theo_ask + theo_bid) / 2.0;
-        theo_bid = mid - min_spread / 2.0;
-        theo_ask = mid + min_spread / 2.0;
-    } else if (theo_ask - theo_bid > max_spread) {
-        double mid = (theo_ask + theo_bid) / 2.0;
-        theo_bid = mid - max_spread / 2.0;
-        theo_ask = mid + max_spread / 2.0;
+    TickPrice min_spread = TickCountCeil(min_spread_ticks_);
+    TickPrice max_spread = TickCountFloor(max_spread_ticks_);
+    TickPrice spread = ask_ticks - bid_ticks;
+    if (spread < min_spread) {
+        TickPrice widen = min_spread - spread;
+        bid_ticks -= widen / 2;
+        ask_ticks += widen - widen / 2;
+    } else if (spread > max_spread) {
+        TickPrice narrow = spread - max_spread;
+        bid_ticks += narrow / 2;
+        ask_ticks -= narrow - narrow / 2;
     }
 
-    // Round to tick size
-    theo_bid = floor(theo_bid / tick_size_) * tick_size_;
-    theo_ask = ceil(theo_ask / tick_size_) * tick_size_;
-
-    return std::make_pair(theo_bid, theo_ask);
+    return std::make_pair(bid_ticks, ask_ticks);
 }
 
-void TradeImpactMM::UpdateQuotes(const Instrument* instrument)
+template <typename Policy>
+void TradeImpactMMT<Policy>::UpdateQuotes(const Instrument* instrument, int slot)
 {
     try {
-        auto& state = instrument_states_[instrument];
-
-        // Cancel existing orders
-        CancelAllOrders(instrument);
+        auto& state = instrument_states_[slot];
 
-        std::pair<double, double> quotes = CalculateQuotes(instrument);
-        double bid_price = quotes.first;
-        double ask_price = quotes.second;
+        std::pair<TickPrice, TickPrice> quotes = CalculateQuotes(instrument, slot);
+        TickPrice bid_ticks = quotes.first;
+        TickPrice ask_ticks = quotes.second;
 
-        if (bid_price <= 0 || ask_price <= 0 || !IsSafeToQuote(instrument, bid_price, ask_price)) {
+        if (bid_ticks <= 0 || ask_ticks <= 0 || !IsSafeToQuote(instrument, slot, bid_ticks, ask_ticks)) {
+            CancelAllOrders(instrument, slot);
             return;
         }
 
         // Calculate position-adjusted sizes
-        double current_pos = portfolio().position(instrument);
+        double current_pos = position_book_.position(slot);
         double position_ratio = current_pos / max_position_;
 
         // Base quote size adjusted by position
@@ -194,60 +285,266 @@ void TradeImpactMM::UpdateQuotes(const Instrument* instrument)
                             max(min_quote_size_,
                                 base_size * (1.0 + position_ratio)));
 
-        // Place orders
-        if (bid_size >= min_quote_size_) {
-            OrderParams bid_params(*instrument,
-                                 bid_size,
-                                 bid_price,
-                                 MARKET_CENTER_ID_IEX,
-                                 ORDER_SIDE_BUY,
-                                 ORDER_TIF_DAY,
-                                 ORDER_TYPE_LIMIT);
-            OrderID order_id = trade_actions()->SendNewOrder(bid_params);
-            if (order_id > 0) {
-                state.active_orders.insert(order_id);
-                state.current_bid = bid_price;
-            }
+        // Hard limit: a side's whole ladder never fills past max_position
+        double bid_room = max(0.0, max_position_ - current_pos);
+        double ask_room = max(0.0, max_position_ + current_pos);
+        bid_size = min(bid_size, bid_room);
+        ask_size = min(ask_size, ask_room);
+
+        journal_.Signal(slot, JOURNAL_SIGNAL_QUOTE, tick_scales_[slot].ToPrice(bid_ticks),
+                        tick_scales_[slot].ToPrice(ask_ticks), bid_size, ask_size);
+
+        // Whole ladder in one pass; only what differs from the resting orders is sent
+        LadderLevel bid_levels[QuoteLadder::kMaxLevels];
+        LadderLevel ask_levels[QuoteLadder::kMaxLevels];
+        int num_bid_levels = BuildLadder(slot, bid_ticks, bid_size, bid_room, ORDER_SIDE_BUY, bid_levels);
+        int num_ask_levels = BuildLadder(slot, ask_ticks, ask_size, ask_room, ORDER_SIDE_SELL, ask_levels);
+        SyncLadder(instrument, slot, state.bids, ORDER_SIDE_BUY, bid_levels, num_bid_levels);
+        SyncLadder(instrument, slot, state.asks, ORDER_SIDE_SELL, ask_levels, num_ask_levels);
+
+        if (Policy::kDebugLog && debug_) {
+            log_.Log("Updated quotes for {} Bid: {} x {} Ask: {} x {} Pos: {}",
+                     instrument->symbol(), tick_scales_[slot].ToPrice(bid_ticks), bid_size,
+                     tick_scales_[slot].ToPrice(ask_ticks), ask_size, current_pos);
         }
 
-        if (ask_size >= min_quote_size_) {
-            OrderParams ask_params(*instrument,
-                                 ask_size,
-                                 ask_price,
+    } catch (const std::exception& e) {
+        logger().LogToClient(LOGLEVEL_ERROR,
+            std::string("Error updating quotes: ") + e.what());
+    }
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::RequestRequote(const Instrument* instrument, int slot, TimeType now)
+{
+    if (coalesce_quotes_) {
+        requote_scheduler_.MarkDirty(slot, ToEpochMicros(now));
+    } else {
+        UpdateQuotes(instrument, slot);
+    }
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::FlushRequotes(TimeType now)
+{
+    requote_scheduler_.Flush(ToEpochMicros(now), [this](int slot) {
+        UpdateQuotes(instrument_index_.instrument(slot), slot);
+    });
+}
+
+template <typename Policy>
+int TradeImpactMMT<Policy>::BuildLadder(int slot, TickPrice top_ticks, double top_size, double room, OrderSide side, LadderLevel* levels)
+{
+    const TickScale& scale = tick_scales_[slot];
+    int num_levels = min(max(ladder_levels_, 1), static_cast<int>(QuoteLadder::kMaxLevels));
+    TickPrice spacing = max(ladder_spacing_ticks_, 1) * (side == ORDER_SIDE_BUY ? -1 : 1);
+    TickPrice price_ticks = top_ticks;
+    double size = top_size;
+
+    // Levels step away from the top and stop once they would be too small;
+    // together they never exceed room
+    int count = 0;
+    for (; count < num_levels; ++count) {
+        size = min(size, room);
+        if (size < min_quote_size_ || size < 1 || price_ticks <= 0) break;
+        levels[count].price_ticks = price_ticks;
+        levels[count].price = scale.ToPrice(price_ticks);
+        levels[count].size = static_cast<int>(size);
+        room -= levels[count].size;
+        price_ticks += spacing;
+        size *= ladder_size_decay_;
+    }
+    return count;
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::SyncLadder(const Instrument* instrument, int slot, QuoteLadder& ladder, OrderSide side,
+                               const LadderLevel* levels, int num_levels)
+{
+    LadderStep steps[QuoteManager::kMaxSteps];
+    int num_steps = 0;
+    if (queue_keep_probability_ > 0) {
+        const InstrumentState& state = instrument_states_[slot];
+        const TradeFlowRate& flow = side == ORDER_SIDE_BUY ? state.bid_flow : state.ask_flow;
+        double expected_volume = flow.ExpectedVolume(state.last_event_us, static_cast<int64_t>(queue_horizon_ms_) * 1000);
+
+        // An order just behind its target keeps its place if it is likely to
+        // fill anyway; one ahead of its target is never kept
+        auto keep_stale = [&](const RestingQuote& quote, const LadderLevel& level) {
+            TickPrice behind = side == ORDER_SIDE_BUY ? level.price_ticks - quote.price_ticks
+                                                      : quote.price_ticks - level.price_ticks;
+            if (behind <= 0 || behind > queue_keep_ticks_) return false;
+            return FillProbability(quote.queue, expected_volume) >= queue_keep_probability_;
+        };
+        num_steps = quote_manager_.PlanLadder(ladder, levels, num_levels, steps, keep_stale);
+    } else {
+        num_steps = quote_manager_.PlanLadder(ladder, levels, num_levels, steps);
+    }
+
+    int sign = side == ORDER_SIDE_BUY ? 1 : -1;
+    for (int i = 0; i < num_steps; ++i) {
+        const LadderStep& step = steps[i];
+        switch (step.action) {
+            case QUOTE_ACTION_NEW: {
+                const LadderLevel& level = levels[step.level];
+                RestingQuote* quote = ladder.FreeOrder();
+                if (quote == nullptr) break;
+                OrderParams params(*instrument,
+                                 level.size,
+                                 level.price,
                                  MARKET_CENTER_ID_IEX,
-                                 ORDER_SIDE_SELL,
+                                 side,
                                  ORDER_TIF_DAY,
                                  ORDER_TYPE_LIMIT);
-            OrderID order_id = trade_actions()->SendNewOrder(ask_params);
-            if (order_id > 0) {
-                state.active_orders.insert(order_id);
-                state.current_ask = ask_price;
+                OrderID order_id = trade_actions()->SendNewOrder(params);
+                RecordOrderAction(slot);
+                journal_.Order(slot, JOURNAL_ORDER_NEW, order_id, static_cast<int64_t>(sign * level.size), level.price);
+                if (order_id > 0) {
+                    quote_manager_.RecordNew(*quote, order_id, level.price_ticks, level.price, level.size);
+                }
+                break;
+            }
+            case QUOTE_ACTION_REPLACE: {
+                const LadderLevel& level = levels[step.level];
+                RestingQuote& quote = ladder.orders[step.order];
+                bool sent = trade_actions()->SendCancelReplaceOrder(quote.order_id, level.size, level.price);
+                RecordOrderAction(slot);
+                journal_.Order(slot, JOURNAL_ORDER_REPLACE, quote.order_id, static_cast<int64_t>(sign * level.size), level.price);
+                // An unsent replace leaves the order as it was, to be retried on the next requote
+                if (sent) {
+                    quote_manager_.RecordReplace(quote, level.price_ticks, level.price, level.size);
+                }
+                break;
             }
+            case QUOTE_ACTION_CANCEL: {
+                RestingQuote& quote = ladder.orders[step.order];
+                bool sent = trade_actions()->SendCancelOrder(quote.order_id);
+                RecordOrderAction(slot);
+                journal_.Order(slot, JOURNAL_ORDER_CANCEL, quote.order_id, static_cast<int64_t>(sign * quote.size), quote.price);
+                if (sent) {
+                    quote_manager_.RecordCancel(quote);
+                }
+                break;
+            }
+            case QUOTE_ACTION_NONE:
+                break;
         }
+    }
+}
 
-        if (debug_) {
-            cout << "Updated quotes for " << instrument->symbol()
-               << " Bid: " << bid_price << " x " << bid_size
-               << " Ask: " << ask_price << " x " << ask_size
-               << " Pos: " << current_pos << endl;
+template <typename Policy>
+void TradeImpactMMT<Policy>::CancelAllOrders(const Instrument* instrument, int slot)
+{
+    auto& state = instrument_states_[slot];
+    SyncLadder(instrument, slot, state.bids, ORDER_SIDE_BUY, nullptr, 0);
+    SyncLadder(instrument, slot, state.asks, ORDER_SIDE_SELL, nullptr, 0);
+}
+
+template <typename Policy>
+double TradeImpactMMT<Policy>::DisplayedSize(int slot, OrderSide side, TickPrice price_ticks)
+{
+    // Better than every visible level is an empty level; deeper than the
+    // visible levels is unknown
+    const TickScale& scale = tick_scales_[slot];
+    int sign = side == ORDER_SIDE_BUY ? 1 : -1;
+    const BookLadder& ladder = book_ladders_[slot];
+    if (!ladder.empty()) {
+        bool is_bid = side == ORDER_SIDE_BUY;
+        int num_levels = is_bid ? ladder.num_bids() : ladder.num_asks();
+        for (int i = 0; i < num_levels; ++i) {
+            TickPrice level_ticks = scale.ToTicks(is_bid ? ladder.bid_price(i) : ladder.ask_price(i));
+            if (level_ticks == price_ticks) return is_bid ? ladder.bid_size(i) : ladder.ask_size(i);
+            if (sign * (price_ticks - level_ticks) > 0) return 0;
         }
+        return -1;
+    }
 
-    } catch (const std::exception& e) {
-        logger().LogToClient(LOGLEVEL_ERROR,
-            std::string("Error updating quotes: ") + e.what());
+    const Quote& quote = instrument_index_.instrument(slot)->top_quote();
+    const auto& top = side == ORDER_SIDE_BUY ? quote.bid_side() : quote.ask_side();
+    if (!top.IsValid()) return -1;
+    TickPrice top_ticks = scale.ToTicks(top.price());
+    if (top_ticks == price_ticks) return top.size();
+    return sign * (price_ticks - top_ticks) > 0 ? 0 : -1;
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::UpdateQueuePositions(int slot)
+{
+    auto& state = instrument_states_[slot];
+    for (int i = 0; i < QuoteLadder::kMaxOrders; ++i) {
+        RestingQuote& bid = state.bids.orders[i];
+        if (bid.live() && bid.queue.known()) {
+            double size = DisplayedSize(slot, ORDER_SIDE_BUY, bid.price_ticks);
+            if (size >= 0) bid.queue.OnLevelSize(size);
+        }
+        RestingQuote& ask = state.asks.orders[i];
+        if (ask.live() && ask.queue.known()) {
+            double size = DisplayedSize(slot, ORDER_SIDE_SELL, ask.price_ticks);
+            if (size >= 0) ask.queue.OnLevelSize(size);
+        }
+    }
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::ApplyTradeToQueues(int slot, TickPrice trade_ticks, double trade_size, bool is_buy)
+{
+    // A buyer lifts asks, a seller hits bids
+    auto& state = instrument_states_[slot];
+    (is_buy ? state.ask_flow : state.bid_flow).OnTrade(state.last_event_us, trade_size);
+
+    QuoteLadder& ladder = is_buy ? state.asks : state.bids;
+    int sign = is_buy ? -1 : 1;
+    for (int i = 0; i < QuoteLadder::kMaxOrders; ++i) {
+        RestingQuote& quote = ladder.orders[i];
+        if (!quote.live()) continue;
+        if (quote.price_ticks == trade_ticks) {
+            quote.queue.OnTradeAtPrice(trade_size);
+        } else if (sign * (quote.price_ticks - trade_ticks) > 0) {
+            quote.queue.OnTradeThrough();
+        }
+    }
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::UpdateTickScales()
+{
+    // The instrument's own tick size wins; tick_size_ covers instruments without one
+    for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+        double min_tick_size = instrument_index_.instrument(slot)->min_tick_size();
+        tick_scales_[slot].set_tick_size(min_tick_size > 0 ? min_tick_size : tick_size_);
+    }
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::ResetImpactState(int slot)
+{
+    // Only the active mode holds samples; the streaming modes never size the window
+    trade_impacts_[slot].clear();
+    impact_quantiles_[slot].clear();
+    streaming_quantiles_[slot].Reset(static_cast<QuantileMode>(quantile_mode_), quantile_threshold_, rolling_window_);
+    if (quantile_mode_ == QUANTILE_MODE_EXACT) {
+        ResizeImpactWindow(slot);
     }
 }
 
-void TradeImpactMM::CancelAllOrders(const Instrument* instrument)
+template <typename Policy>
+void TradeImpactMMT<Policy>::ResizeImpactWindow(int slot)
 {
-    auto& state = instrument_states_[instrument];
-    for (const OrderID& order_id : state.active_orders) {
-        trade_actions()->SendCancelOrder(order_id);
+    auto& impacts = trade_impacts_[slot];
+    auto& quantiles = impact_quantiles_[slot];
+    int window = max(rolling_window_, 0);
+
+    // Impacts that fall out of a shrinking window leave the quantile trees too
+    while (impacts.size() > static_cast<size_t>(window)) {
+        quantiles.Remove(impacts.front());
+        impacts.pop_front();
     }
-    state.active_orders.clear();
+    impacts.SetWindow(window);
+    quantiles.Reserve(window);
 }
 
-bool TradeImpactMM::IsSafeToQuote(const Instrument* instrument, double bid_price, double ask_price)
+template <typename Policy>
+bool TradeImpactMMT<Policy>::IsSafeToQuote(const Instrument* instrument, int slot, TickPrice bid_ticks, TickPrice ask_ticks)
 {
     const Quote& quote = instrument->top_quote();
     if (!quote.ask_side().IsValid() || !quote.bid_side().IsValid()) {
@@ -255,43 +552,63 @@ bool TradeImpactMM::IsSafeToQuote(const Instrument* instrument, double bid_price
     }
 
     // Don't cross the market
-    if (bid_price >= quote.ask() || ask_price <= quote.bid()) {
+    const TickScale& scale = tick_scales_[slot];
+    if (bid_ticks >= scale.ToTicks(quote.ask()) || ask_ticks <= scale.ToTicks(quote.bid())) {
         return false;
     }
 
     // Check spread is reasonable
-    double spread = ask_price - bid_price;
-    if (spread < min_spread_ticks_ * tick_size_ || spread > max_spread_ticks_ * tick_size_) {
+    TickPrice spread = ask_ticks - bid_ticks;
+    if (spread < TickCountCeil(min_spread_ticks_) || spread > TickCountFloor(max_spread_ticks_)) {
         return false;
     }
 
     return true;
 }
 
-void TradeImpactMM::OnTrade(const TradeDataEventMsg& msg)
+template <typename Policy>
+void TradeImpactMMT<Policy>::OnTrade(const TradeDataEventMsg& msg)
 {
+    OptionalLatencyScope<Policy::kInstrumentation> latency_scope(latency_, LATENCY_HANDLER_ON_TRADE);
     try {
+        journal_.set_time(msg.event_time());
+        FlushRequotes(msg.event_time());
+
         const Instrument* instrument = &msg.instrument();
+        int slot = instrument_index_.Find(instrument);
+        if (slot == InstrumentIndex::kNotFound) return;
+
         double trade_size = msg.trade().size();
         bool is_buy = msg.trade().side() == TRADE_SIDE_BUY;  // Changed from ORDER_SIDE_BUY
 
+        instrument_states_[slot].last_event_us = ToEpochMicros(msg.event_time());
+        ApplyTradeToQueues(slot, tick_scales_[slot].ToTicks(msg.trade().price()), trade_size, is_buy);
+
         // Calculate and store trade impact
-        double impact = CalculateTradeImpact(instrument, trade_size, is_buy);
+        double impact = CalculateTradeImpact(slot, trade_size, is_buy);
+        journal_.Signal(slot, JOURNAL_SIGNAL_IMPACT, impact, is_buy ? trade_size : -trade_size, msg.trade().price());
 
-        auto& impacts = trade_impacts_[instrument];
-        impacts.push_back(impact);
-        if (impacts.size() > rolling_window_) {
-            impacts.pop_front();
+        if (quantile_mode_ == QUANTILE_MODE_EXACT) {
+            // An empty window keeps nothing; the trees must not collect what the ring drops
+            if (rolling_window_ > 0) {
+                auto& impacts = trade_impacts_[slot];
+                auto& quantiles = impact_quantiles_[slot];
+                if (impacts.full()) {
+                    quantiles.Remove(impacts.front());
+                }
+                impacts.push_back(impact);
+                quantiles.Add(impact);
+            }
+        } else {
+            streaming_quantiles_[slot].Add(impact);
         }
 
         // Update quotes
-        UpdateQuotes(instrument);
+        RequestRequote(instrument, slot, msg.event_time());
 
-        if (debug_) {
-            cout << "Trade processed: " << instrument->symbol()
-               << " Size: " << trade_size
-               << " Side: " << (is_buy ? "BUY" : "SELL")
-               << " Impact: " << impact << endl;
+        if (Policy::kDebugLog && debug_) {
+            log_.Log("Trade processed: {} Size: {} Side: {} Impact: {}",
+                     instrument->symbol(), trade_size, is_buy ? "BUY" : "SELL", impact);
         }
     } catch (const std::exception& e) {
         logger().LogToClient(LOGLEVEL_ERROR,
@@ -299,43 +616,97 @@ void TradeImpactMM::OnTrade(const TradeDataEventMsg& msg)
     }
 }
 
-void TradeImpactMM::OnOrderUpdate(const OrderUpdateEventMsg& msg)
+template <typename Policy>
+void TradeImpactMMT<Policy>::OnOrderUpdate(const OrderUpdateEventMsg& msg)
 {
+    OptionalLatencyScope<Policy::kInstrumentation> latency_scope(latency_, LATENCY_HANDLER_ON_ORDER_UPDATE);
     try {
-        auto& state = instrument_states_[msg.order().instrument()];
+        journal_.set_time(msg.event_time());
+        FlushRequotes(msg.event_time());
+
+        const Instrument* instrument = msg.order().instrument();
+        int slot = instrument_index_.Find(instrument);
+        if (slot == InstrumentIndex::kNotFound) return;
+
+        auto& state = instrument_states_[slot];
+        RestingQuote* quote = state.FindQuote(msg.order().order_id());
 
         switch (msg.update_type()) {
+            case ORDER_UPDATE_TYPE_OPEN: {
+                if (quote) {
+                    // Join the queue behind everything displayed at our price
+                    if (quote->pending == RestingQuote::PENDING_NEW) {
+                        quote->queue.Snapshot(DisplayedSize(slot, msg.order().order_side(), quote->price_ticks));
+                    }
+                    QuoteManager::OnAcknowledged(*quote);
+                }
+                break;
+            }
+            case ORDER_UPDATE_TYPE_MODIFY: {
+                if (quote && quote->pending == RestingQuote::PENDING_REPLACE) {
+                    // The replaced order goes to the back of the queue at its new price
+                    QuoteManager::OnReplaced(*quote);
+                    quote->queue.Snapshot(DisplayedSize(slot, msg.order().order_side(), quote->price_ticks));
+                }
+                break;
+            }
+            case ORDER_UPDATE_TYPE_REJECT: {
+                // A rejected new order never rested, so its slot and ladder level are free again
+                if (quote) {
+                    quote->Reset();
+                }
+                break;
+            }
+            case ORDER_UPDATE_TYPE_CANCEL_REJECT: {
+                // The order is still working as it was before the cancel or replace
+                if (quote) {
+                    QuoteManager::OnCancelRejected(*quote);
+                }
+                break;
+            }
+            case ORDER_UPDATE_TYPE_PARTIAL_FILL: {
+                int fill_size = abs(msg.fill()->fill_size());
+                position_book_.OnFill(slot, msg.order().order_side() == ORDER_SIDE_BUY ? fill_size : -fill_size,
+                                      msg.fill()->fill_price());
+                journal_.Fill(slot, msg.order().order_id(), msg.order().order_side() == ORDER_SIDE_BUY ? fill_size : -fill_size,
+                              msg.fill()->fill_price());
+                if (quote) {
+                    QuoteManager::OnPartialFill(*quote, fill_size);
+                }
+                break;
+            }
             case ORDER_UPDATE_TYPE_FILL: {
                 // Update position tracking
                 double fill_price = msg.fill()->fill_price();
-                double fill_size = msg.fill()->fill_size();
+                int fill_size = abs(msg.fill()->fill_size());
+                position_book_.OnFill(slot, msg.order().order_side() == ORDER_SIDE_BUY ? fill_size : -fill_size,
+                                      fill_price);
+                journal_.Fill(slot, msg.order().order_id(), msg.order().order_side() == ORDER_SIDE_BUY ? fill_size : -fill_size,
+                              fill_price);
+                int current_pos = position_book_.position(slot);
 
-                // Update average position price
-                double current_pos = portfolio().position(msg.order().instrument());
-                if (current_pos != 0) {
-                    state.avg_position_price = fill_price;
+                // Filled order no longer rests on the book
+                if (quote) {
+                    quote->Reset();
                 }
 
-                // Remove filled order from tracking
-                state.active_orders.erase(msg.order().order_id());
-
                 // Update quotes after fill
-                UpdateQuotes(msg.order().instrument());
-
-                if (debug_) {
-                    stringstream ss;
-                    ss << "Fill: " << msg.order().instrument()->symbol()
-                       << " Price: " << fill_price
-                       << " Size: " << fill_size
-                       << " Current Pos: " << current_pos;
-                    LogDebug(ss.str());
+                UpdateQuotes(instrument, slot);
+
+                if (Policy::kDebugLog && debug_) {
+                    log_.Log("Fill: {} Price: {} Size: {} Current Pos: {}",
+                             instrument->symbol(), fill_price, fill_size, current_pos);
                 }
                 break;
             }
             case ORDER_UPDATE_TYPE_CANCEL: {
-                state.active_orders.erase(msg.order().order_id());
+                if (quote) {
+                    quote->Reset();
+                }
                 break;
             }
+            default:
+                break;
         }
     } catch (const std::exception& e) {
         logger().LogToClient(LOGLEVEL_ERROR,
@@ -343,37 +714,203 @@ void TradeImpactMM::OnOrderUpdate(const OrderUpdateEventMsg& msg)
     }
 }
 
-void TradeImpactMM::OnTopQuote(const QuoteEventMsg& msg)
+template <typename Policy>
+void TradeImpactMMT<Policy>::OnTopQuote(const QuoteEventMsg& msg)
 {
+    OptionalLatencyScope<Policy::kInstrumentation> latency_scope(latency_, LATENCY_HANDLER_ON_TOP_QUOTE);
     try {
+        journal_.set_time(msg.event_time());
+        FlushRequotes(msg.event_time());
+
         const Instrument* instrument = &msg.instrument();
-        auto& state = instrument_states_[instrument];
+        int slot = instrument_index_.Find(instrument);
+        if (slot == InstrumentIndex::kNotFound) return;
+
+        auto& state = instrument_states_[slot];
         state.last_quote_update = msg.event_time();
-        UpdateQuotes(instrument);
+        state.last_event_us = ToEpochMicros(msg.event_time());
+        UpdateQueuePositions(slot);
+
+        const Quote& quote = msg.quote();
+        if (quote.bid_side().IsValid() && quote.ask_side().IsValid()) {
+            position_book_.Mark(slot, (quote.bid() + quote.ask()) / 2.0);
+        }
+        RequestRequote(instrument, slot, msg.event_time());
     } catch (const std::exception& e) {
         logger().LogToClient(LOGLEVEL_ERROR,
             std::string("Error in quote update: ") + e.what());
     }
 }
 
-void TradeImpactMM::OnBar(const BarEventMsg& msg)
+template <typename Policy>
+void TradeImpactMMT<Policy>::OnDepth(const MarketDepthEventMsg& msg)
+{
+    OptionalLatencyScope<Policy::kInstrumentation> latency_scope(latency_, LATENCY_HANDLER_ON_DEPTH);
+    try {
+        journal_.set_time(msg.event_time());
+        FlushRequotes(msg.event_time());
+
+        const Instrument* instrument = &msg.instrument();
+        int slot = instrument_index_.Find(instrument);
+        if (slot == InstrumentIndex::kNotFound) return;
+
+        const IAggrOrderBook& book = instrument->aggregate_order_book();
+        auto& ladder = book_ladders_[slot];
+        int levels = min(levels_to_consider_, static_cast<int>(BookLadder::kMaxLevels));
+
+        // Only the levels the impact calculation reads are copied out of the book
+        ladder.ClearBids();
+        for (int i = 0; i < levels && i < book.NumBidLevels(); ++i) {
+            const IAggrPriceLevel* level = book.BidPriceLevelAtLevel(i);
+            if (level == nullptr) break;
+            ladder.PushBid(level->price(), level->size());
+        }
+
+        ladder.ClearAsks();
+        for (int i = 0; i < levels && i < book.NumAskLevels(); ++i) {
+            const IAggrPriceLevel* level = book.AskPriceLevelAtLevel(i);
+            if (level == nullptr) break;
+            ladder.PushAsk(level->price(), level->size());
+        }
+
+        UpdateQueuePositions(slot);
+    } catch (const std::exception& e) {
+        logger().LogToClient(LOGLEVEL_ERROR,
+            std::string("Error in depth update: ") + e.what());
+    }
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::OnBar(const BarEventMsg& msg)
 {
     // Not using bars for this strategy
 }
 
-void TradeImpactMM::DefineStrategyCommands()
+template <typename Policy>
+void TradeImpactMMT<Policy>::DefineStrategyCommands()
+{
+    commands().AddCommand(StrategyCommand(1, "Report Quote Stats"));
+    commands().AddCommand(StrategyCommand(2, "Dump Latency Stats"));
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::OnStrategyCommand(const StrategyCommandEventMsg& msg)
 {
-    // Strategy commands removed as per header changes
+    switch (msg.command_id()) {
+        case 1:
+            ReportQuoteStats();
+            break;
+        case 2:
+            ReportLatencyStats("command");
+            break;
+        default:
+            logger().LogToClient(LOGLEVEL_DEBUG, "Unknown strategy command received");
+            break;
+    }
 }
 
-void TradeImpactMM::LogDebug(const std::string& message)
+template <typename Policy>
+void TradeImpactMMT<Policy>::LogDebug(const char* message)
 {
-    if (debug_) {
+    if (Policy::kDebugLog && debug_) {
         logger().LogToClient(LOGLEVEL_DEBUG, message);
     }
 }
 
-void TradeImpactMM::OnParamChanged(StrategyParam& param)
+template <typename Policy>
+void TradeImpactMMT<Policy>::ReportQuoteStats()
+{
+    const QuoteStats& stats = quote_manager_.stats();
+    stringstream ss;
+    ss << "Quote stats:"
+       << " Sent: " << stats.sent()
+       << " (New: " << stats.sent_new
+       << " Replace: " << stats.sent_replace
+       << " Cancel: " << stats.sent_cancel << ")"
+       << " Suppressed: " << stats.suppressed
+       << " (Kept for queue position: " << stats.kept_stale << ")";
+    logger().LogToClient(LOGLEVEL_INFO, ss.str());
+
+    const RequoteStats& requotes = requote_scheduler_.stats();
+    stringstream rs;
+    rs << "Requote stats:"
+       << " Requested: " << requotes.marked
+       << " Coalesced: " << requotes.coalesced
+       << " Run: " << requotes.requotes
+       << " Max staleness (us): " << requotes.max_staleness_us;
+    logger().LogToClient(LOGLEVEL_INFO, rs.str());
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::StartJournal()
+{
+    if (!journal_.Open(journal_path_, "TradeImpactMM")) {
+        logger().LogToClient(LOGLEVEL_ERROR, "Could not write " + journal_path_);
+        return;
+    }
+    for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+        journal_.SetSymbol(slot, instrument_index_.instrument(slot)->symbol());
+    }
+    journal_.DefineLabel(JOURNAL_SIGNAL, JOURNAL_SIGNAL_IMPACT, "impact", "impact", "size", "price");
+    journal_.DefineLabel(JOURNAL_SIGNAL, JOURNAL_SIGNAL_QUOTE, "quote", "bid", "ask", "bid_size", "ask_size");
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::ReconcilePositions()
+{
+    int mismatches = 0;
+    for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+        const Instrument* instrument = instrument_index_.instrument(slot);
+        int book_position = position_book_.position(slot);
+        int portfolio_position = portfolio().position(instrument);
+        if (!position_book_.Reconcile(slot, portfolio_position)) {
+            ++mismatches;
+            stringstream ss;
+            ss << "Position mismatch for " << instrument->symbol()
+               << " Book: " << book_position
+               << " Portfolio: " << portfolio_position;
+            logger().LogToClient(LOGLEVEL_WARNING, ss.str());
+        }
+    }
+
+    stringstream ss;
+    ss << "Position book:"
+       << " Realized PnL: " << position_book_.TotalRealizedPnl()
+       << " Unrealized PnL: " << position_book_.TotalUnrealizedPnl()
+       << " Mismatches: " << mismatches;
+    logger().LogToClient(LOGLEVEL_INFO, ss.str());
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::RecordOrderAction(int slot)
+{
+    if (Policy::kInstrumentation) {
+        latency_.RecordOrderAction(slot);
+    }
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::ReportLatencyStats(const std::string& reason)
+{
+    if (!Policy::kInstrumentation) {
+        logger().LogToClient(LOGLEVEL_INFO, "Latency stats are only recorded by the diagnostic build");
+        return;
+    }
+
+    for (int handler = 0; handler < LATENCY_HANDLER_COUNT; ++handler) {
+        std::string summary = latency_.Summary(handler);
+        if (!summary.empty()) {
+            logger().LogToClient(LOGLEVEL_INFO, summary);
+        }
+    }
+
+    if (!latency_.Dump(latency_path_, instrument_index_, reason)) {
+        logger().LogToClient(LOGLEVEL_ERROR, "Could not write " + latency_path_);
+    }
+}
+
+template <typename Policy>
+void TradeImpactMMT<Policy>::OnParamChanged(StrategyParam& param)
 {
     if (param.param_name() == "impact_multiplier") {
         if (!param.Get(&impact_multiplier_))
@@ -382,10 +919,34 @@ void TradeImpactMM::OnParamChanged(StrategyParam& param)
     else if (param.param_name() == "rolling_window") {
         if (!param.Get(&rolling_window_))
             throw StrategyStudioException("Could not get rolling_window");
+        for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+            if (quantile_mode_ == QUANTILE_MODE_EXACT) {
+                ResizeImpactWindow(slot);
+            } else {
+                streaming_quantiles_[slot].set_window(rolling_window_);
+            }
+        }
     }
     else if (param.param_name() == "quantile_threshold") {
         if (!param.Get(&quantile_threshold_))
             throw StrategyStudioException("Could not get quantile_threshold");
+        // P-square tracks one fixed quantile, so the streaming estimates start over
+        if (quantile_mode_ != QUANTILE_MODE_EXACT) {
+            for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+                ResetImpactState(slot);
+            }
+        }
+    }
+    else if (param.param_name() == "quantile_mode") {
+        int quantile_mode;
+        if (!param.Get(&quantile_mode))
+            throw StrategyStudioException("Could not get quantile_mode");
+        if (quantile_mode < QUANTILE_MODE_EXACT || quantile_mode > QUANTILE_MODE_DECAYED)
+            throw StrategyStudioException("quantile_mode must be 0 (exact), 1 (P-square) or 2 (decayed)");
+        quantile_mode_ = quantile_mode;
+        for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+            ResetImpactState(slot);
+        }
     }
     else if (param.param_name() == "levels_to_consider") {
         if (!param.Get(&levels_to_consider_))
@@ -394,6 +955,7 @@ void TradeImpactMM::OnParamChanged(StrategyParam& param)
     else if (param.param_name() == "tick_size") {
         if (!param.Get(&tick_size_))
             throw StrategyStudioException("Could not get tick_size");
+        UpdateTickScales();
     }
     else if (param.param_name() == "max_position") {
         if (!param.Get(&max_position_))
@@ -423,8 +985,66 @@ void TradeImpactMM::OnParamChanged(StrategyParam& param)
         if (!param.Get(&max_quote_size_))
             throw StrategyStudioException("Could not get max_quote_size");
     }
+    else if (param.param_name() == "size_bucket") {
+        if (!param.Get(&size_bucket_))
+            throw StrategyStudioException("Could not get size_bucket");
+        quote_manager_.set_size_bucket(size_bucket_);
+    }
+    else if (param.param_name() == "ladder_levels") {
+        if (!param.Get(&ladder_levels_))
+            throw StrategyStudioException("Could not get ladder_levels");
+    }
+    else if (param.param_name() == "ladder_spacing_ticks") {
+        if (!param.Get(&ladder_spacing_ticks_))
+            throw StrategyStudioException("Could not get ladder_spacing_ticks");
+    }
+    else if (param.param_name() == "ladder_size_decay") {
+        if (!param.Get(&ladder_size_decay_))
+            throw StrategyStudioException("Could not get ladder_size_decay");
+    }
+    else if (param.param_name() == "coalesce_quotes") {
+        if (!param.Get(&coalesce_quotes_))
+            throw StrategyStudioException("Could not get coalesce_quotes");
+    }
+    else if (param.param_name() == "min_requote_interval_us") {
+        if (!param.Get(&min_requote_interval_us_))
+            throw StrategyStudioException("Could not get min_requote_interval_us");
+        requote_scheduler_.set_min_interval_us(min_requote_interval_us_);
+    }
+    else if (param.param_name() == "queue_keep_probability") {
+        if (!param.Get(&queue_keep_probability_))
+            throw StrategyStudioException("Could not get queue_keep_probability");
+    }
+    else if (param.param_name() == "queue_keep_ticks") {
+        if (!param.Get(&queue_keep_ticks_))
+            throw StrategyStudioException("Could not get queue_keep_ticks");
+    }
+    else if (param.param_name() == "queue_horizon_ms") {
+        if (!param.Get(&queue_horizon_ms_))
+            throw StrategyStudioException("Could not get queue_horizon_ms");
+    }
+    else if (param.param_name() == "latency_stats") {
+        if (!param.Get(&latency_stats_))
+            throw StrategyStudioException("Could not get latency_stats");
+        latency_.set_enabled(Policy::kInstrumentation && latency_stats_);
+    }
+    else if (param.param_name() == "decision_journal") {
+        if (!param.Get(&decision_journal_))
+            throw StrategyStudioException("Could not get decision_journal");
+        if (decision_journal_) {
+            StartJournal();
+        } else {
+            journal_.Close();
+        }
+    }
     else if (param.param_name() == "debug") {
         if (!param.Get(&debug_))
             throw StrategyStudioException("Could not get debug");
+        if (Policy::kDebugLog && debug_) {
+            log_.Start(log_path_);
+        }
     }
 }
+
+// The variant this library is built as (see StrategyPolicy.h)
+template class TradeImpactMMT<StrategyPolicy>;
@@ -18,9 +18,22 @@
 #include "FillInfo.h"
 #include "AllEventMsg.h"
 #include "ExecutionTypes.h"
-#include <deque>
-#include <set>
-#include <unordered_map>
+#include "BookLadder.h"
+#include "ImpactQuantiles.h"
+#include "QueuePosition.h"
+#include "QuoteManager.h"
+#include "RequoteScheduler.h"
+#include "StreamingQuantile.h"
+#include <AsyncLogger.h>
+#include <CacheAligned.h>
+#include <DecisionJournal.h>
+#include <EventTime.h>
+#include <InstrumentIndex.h>
+#include <LatencyRecorder.h>
+#include <PositionBook.h>
+#include <RingBuffer.h>
+#include <StrategyPolicy.h>
+#include <TickPrice.h>
 
 using namespace RCM::StrategyStudio;
 using namespace RCM::StrategyStudio::MarketModels;
@@ -28,28 +41,45 @@ using namespace RCM::StrategyStudio::MarketModels;
 // Trading state for each instrument
 struct InstrumentState {
     InstrumentState() : 
-        current_bid(0),
-        current_ask(0),
-        avg_position_price(0),
-        last_quote_update(boost::posix_time::not_a_date_time) {}
-
-    std::set<OrderID> active_orders;  // Changed from string to OrderID
-    double current_bid;
-    double current_ask;
-    double avg_position_price;
+        last_quote_update(boost::posix_time::not_a_date_time),
+        last_event_us(0) {}
+
+    // Resting quote owning the given order, or nullptr
+    RestingQuote* FindQuote(OrderID order_id) {
+        RestingQuote* quote = bids.Find(order_id);
+        return quote ? quote : asks.Find(order_id);
+    }
+
+    QuoteLadder bids;
+    QuoteLadder asks;
+    TradeFlowRate bid_flow;     // Seller-initiated volume, which fills our bids
+    TradeFlowRate ask_flow;     // Buyer-initiated volume, which fills our asks
     TimeType last_quote_update;
+    int64_t last_event_us;
 };
 
-class TradeImpactMM : public Strategy {
+// Policy is a StrategyPolicy.h policy: which debug and instrumentation code
+// is compiled in
+template <typename Policy>
+class TradeImpactMMT : public Strategy {
+    template <typename> friend class TradeImpactMMBench;   // Tools/Bench drives the private kernels directly
+
 public:
-    TradeImpactMM(StrategyID strategyID, const std::string& strategyName, const std::string& groupName);
-    ~TradeImpactMM();
+    enum JournalSignal {
+        JOURNAL_SIGNAL_IMPACT,   // impact, signed trade size, trade price
+        JOURNAL_SIGNAL_QUOTE     // bid, ask, bid size, ask size
+    };
+
+    TradeImpactMMT(StrategyID strategyID, const std::string& strategyName, const std::string& groupName);
+    ~TradeImpactMMT();
 
 public: // Event handlers
     virtual void OnTrade(const TradeDataEventMsg& msg);
     virtual void OnTopQuote(const QuoteEventMsg& msg);
+    virtual void OnDepth(const MarketDepthEventMsg& msg);
     virtual void OnBar(const BarEventMsg& msg);
     virtual void OnOrderUpdate(const OrderUpdateEventMsg& msg);
+    virtual void OnStrategyCommand(const StrategyCommandEventMsg& msg);
     virtual void OnResetStrategyState();
     virtual void OnParamChanged(StrategyParam& param);
 
@@ -59,19 +89,36 @@ private: // Strategy setup
     virtual void DefineStrategyCommands();
 
 private: // Trading logic
-    double CalculateTradeImpact(const Instrument* instrument, double trade_size, bool is_buy);
-    std::pair<double, double> CalculateQuotes(const Instrument* instrument);
-    void UpdateQuotes(const Instrument* instrument);
-    void CancelAllOrders(const Instrument* instrument);
-    bool IsSafeToQuote(const Instrument* instrument, double bid_price, double ask_price);
-    void LogDebug(const std::string& message);
+    double CalculateTradeImpact(int slot, double trade_size, bool is_buy);
+    std::pair<TickPrice, TickPrice> CalculateQuotes(const Instrument* instrument, int slot);
+    void UpdateQuotes(const Instrument* instrument, int slot);
+    void RequestRequote(const Instrument* instrument, int slot, TimeType now);
+    void FlushRequotes(TimeType now);
+    int BuildLadder(int slot, TickPrice top_ticks, double top_size, double room, OrderSide side, LadderLevel* levels);
+    void SyncLadder(const Instrument* instrument, int slot, QuoteLadder& ladder, OrderSide side,
+                    const LadderLevel* levels, int num_levels);
+    void CancelAllOrders(const Instrument* instrument, int slot);
+    double DisplayedSize(int slot, OrderSide side, TickPrice price_ticks);
+    void UpdateQueuePositions(int slot);
+    void ApplyTradeToQueues(int slot, TickPrice trade_ticks, double trade_size, bool is_buy);
+    void UpdateTickScales();
+    void ResizeImpactWindow(int slot);
+    void ResetImpactState(int slot);
+    bool IsSafeToQuote(const Instrument* instrument, int slot, TickPrice bid_ticks, TickPrice ask_ticks);
+    void LogDebug(const char* message);
+    void ReportQuoteStats();
+    void StartJournal();
+    void ReconcilePositions();
+    void RecordOrderAction(int slot);
+    void ReportLatencyStats(const std::string& reason);
 
 private: // Strategy parameters
     double impact_multiplier_;      // Trade impact scaling factor
     int rolling_window_;           // Number of trades to consider
     double quantile_threshold_;    // Quantile for quote calculation
+    int quantile_mode_;            // QuantileMode: exact window, P-square or decayed
     int levels_to_consider_;       // Order book depth to consider
-    double tick_size_;            // Minimum price increment
+    double tick_size_;            // Price increment for instruments without a min_tick_size()
     double max_position_;         // Maximum allowed position
     double risk_limit_pct_;       // Risk limit percentage
     double min_spread_ticks_;     // Minimum quote spread in ticks
@@ -79,13 +126,41 @@ private: // Strategy parameters
     int quote_size_;             // Base quote size
     double min_quote_size_;      // Minimum quote size
     double max_quote_size_;      // Maximum quote size
+    int size_bucket_;            // Size changes within a bucket do not requote
+    int ladder_levels_;          // Quote levels per side, 1 quotes the top only
+    int ladder_spacing_ticks_;   // Ticks between ladder levels
+    double ladder_size_decay_;   // Size of each level relative to the one above
+    bool coalesce_quotes_;       // Requote once per event burst instead of per event
+    int min_requote_interval_us_; // Minimum time between coalesced requotes of an instrument
+    double queue_keep_probability_; // Keep a near-target quote whose fill probability is at least this, 0 disables
+    int queue_keep_ticks_;       // Furthest a kept quote may sit behind its target
+    int queue_horizon_ms_;       // Horizon of the fill probability
+    bool latency_stats_;         // Record tick-to-order latency histograms
+    bool decision_journal_;      // Write the binary decision journal
     bool debug_;                 // Debug mode flag
 
-private: // Strategy state
-    std::unordered_map<const Instrument*, std::deque<double>> trade_impacts_;
-    std::unordered_map<const Instrument*, InstrumentState> instrument_states_;
+private: // Strategy state, one entry per instrument slot
+    InstrumentIndex instrument_index_;
+    CacheAlignedVector<RingBuffer<double>> trade_impacts_;
+    CacheAlignedVector<ImpactQuantiles> impact_quantiles_;  // Sorted view of trade_impacts_
+    CacheAlignedVector<StreamingImpactQuantiles> streaming_quantiles_;  // Used instead in the streaming modes
+    CacheAlignedVector<BookLadder> book_ladders_;
+    CacheAlignedVector<InstrumentState> instrument_states_;
+    CacheAlignedVector<TickScale> tick_scales_;
+    PositionBook position_book_;  // Our own fills; reconciled with portfolio() at day end
+    QuoteManager quote_manager_;
+    RequoteScheduler requote_scheduler_;
+    std::string log_path_;
+    AsyncLogger log_;            // Debug output, formatted off the event thread
+    std::string latency_path_;
+    LatencyRecorder latency_;
+    std::string journal_path_;
+    DecisionJournal journal_;    // Impacts, quote decisions, orders and fills
 };
 
+// The variant selected by the build; the diagnostic .so defines STRATEGY_DIAGNOSTIC
+typedef TradeImpactMMT<StrategyPolicy> TradeImpactMM;
+
 extern "C" {
     _STRATEGY_EXPORTS const char* GetType() { return "TradeImpactMM"; }
     _STRATEGY_EXPORTS const char* GetAuthor() { return "##"; }
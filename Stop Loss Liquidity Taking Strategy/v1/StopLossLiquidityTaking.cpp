@@ -7,6 +7,7 @@
 #include <Utilities/utils.h>
 
 #include <math.h>
+#include <stdlib.h>
 #include <iostream>
 #include <sstream>
 #include <cassert>
@@ -16,126 +17,174 @@ using namespace RCM::StrategyStudio::MarketModels;
 using namespace RCM::StrategyStudio::Utilities;
 using namespace std;
 
-StopLossHunter::StopLossHunter(StrategyID strategyID, const std::string& strategyName, const std::string& groupName):
+template <typename Policy>
+StopLossHunterT<Policy>::StopLossHunterT(StrategyID strategyID, const std::string& strategyName, const std::string& groupName):
    Strategy(strategyID, strategyName, groupName),
    entry_range_ticks_(3),         
    target_ticks_(5),           
    max_loss_ticks_(3),         
    lookback_period_(1000),       
    volatility_period_(20),      
+   volatility_mode_(VOLATILITY_MODE_PRICE),
    volatility_threshold_(0.0001),
    account_risk_per_trade_(0.001), // 0.1% risk per trade
-   debug_(true)
+   latency_stats_(false),
+   decision_journal_(false),
+   debug_(true),
+   log_path_(strategyName + ".log"),
+   latency_path_(strategyName + "_latency.csv"),
+   journal_path_(strategyName + ".journal")
 {
 }
 
-StopLossHunter::~StopLossHunter()
+template <typename Policy>
+StopLossHunterT<Policy>::~StopLossHunterT()
 {
+   // The last day has no reset after it
+   if (Policy::kInstrumentation && latency_stats_) {
+       latency_.Dump(latency_path_, instrument_index_, "final");
+   }
 }
 
-void StopLossHunter::OnResetStrategyState()
+template <typename Policy>
+void StopLossHunterT<Policy>::OnResetStrategyState()
 {
-   instrument_states_.clear();
-   price_windows_.clear();
-   volatility_windows_.clear();
+   if (Policy::kInstrumentation && latency_stats_) {
+       ReportLatencyStats("eod");
+   }
+   latency_.ClearHistograms();
+   ReconcilePositions();
+   position_book_.ResetRealized();
+
+   // Slots stay assigned; only the per-instrument state is reset
+   for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+       instrument_states_[slot] = InstrumentState();
+       level_trackers_[slot].clear();
+       volatility_trackers_[slot].clear();
+   }
 }
 
-void StopLossHunter::DefineStrategyParams()
+template <typename Policy>
+void StopLossHunterT<Policy>::DefineStrategyParams()
 {
    params().CreateParam(CreateStrategyParamArgs("entry_range_ticks", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, entry_range_ticks_));
    params().CreateParam(CreateStrategyParamArgs("target_ticks", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, target_ticks_));
    params().CreateParam(CreateStrategyParamArgs("max_loss_ticks", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, max_loss_ticks_));
    params().CreateParam(CreateStrategyParamArgs("lookback_period", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, lookback_period_));
+   params().CreateParam(CreateStrategyParamArgs("level_horizons", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_STRING, level_horizons_));
    params().CreateParam(CreateStrategyParamArgs("volatility_period", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, volatility_period_));
+   params().CreateParam(CreateStrategyParamArgs("volatility_mode", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, volatility_mode_));
    params().CreateParam(CreateStrategyParamArgs("volatility_threshold", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, volatility_threshold_));
    params().CreateParam(CreateStrategyParamArgs("account_risk_per_trade", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, account_risk_per_trade_));
+   params().CreateParam(CreateStrategyParamArgs("latency_stats", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_BOOL, latency_stats_));
+   params().CreateParam(CreateStrategyParamArgs("decision_journal", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_BOOL, decision_journal_));
    params().CreateParam(CreateStrategyParamArgs("debug", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_BOOL, debug_));
 }
 
-void StopLossHunter::RegisterForStrategyEvents(StrategyEventRegister* eventRegister, DateType currDate)
+template <typename Policy>
+void StopLossHunterT<Policy>::RegisterForStrategyEvents(StrategyEventRegister* eventRegister, DateType currDate)
 {
     for (SymbolSetConstIter it = symbols_begin(); it != symbols_end(); ++it) {
         eventRegister->RegisterForMarketData(*it);
     }
 
-    // Initialize state for each instrument
+    // Assign each instrument a dense slot and size its state
     for (InstrumentSetConstIter it = instrument_begin(); it != instrument_end(); ++it) {
-        const Instrument* instrument = it->second;
-        
-        instrument_states_.emplace(instrument, InstrumentState());
-        
-        // Correctly specify both key and value construction tuples
-
-        // price_windows[instrument] = ScalarRollingWindow()
-
-        price_windows_.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(instrument),
-            std::forward_as_tuple(lookback_period_)  // Constructor argument for ScalarRollingWindow
-        );
-        
-        volatility_windows_.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(instrument),
-            std::forward_as_tuple(volatility_period_)  // Constructor argument for ScalarRollingWindow
-        );
+        instrument_index_.Add(it->second);
+    }
+
+    int num_slots = instrument_index_.size();
+    instrument_states_.resize(num_slots);
+    tick_scales_.resize(num_slots);
+    for (int slot = 0; slot < num_slots; ++slot) {
+        tick_scales_[slot].set_tick_size(instrument_index_.instrument(slot)->min_tick_size());
+    }
+    level_trackers_.resize(num_slots);
+    UpdateLevelHorizons();
+    volatility_trackers_.resize(num_slots);
+    for (int slot = 0; slot < num_slots; ++slot) {
+        volatility_trackers_[slot].SetWindow(volatility_period_);
+        volatility_trackers_[slot].set_mode(static_cast<VolatilityMode>(volatility_mode_));
+    }
+    position_book_.Reset(num_slots);
+    latency_.Reset(num_slots);
+    latency_.set_enabled(Policy::kInstrumentation && latency_stats_);
+
+    if (Policy::kDebugLog && debug_) {
+        log_.Start(log_path_);
+    }
+    if (decision_journal_) {
+        StartJournal();
     }
 }
 
 
-void StopLossHunter::OnTrade(const TradeDataEventMsg& msg)
+template <typename Policy>
+void StopLossHunterT<Policy>::OnTrade(const TradeDataEventMsg& msg)
 {
+   OptionalLatencyScope<Policy::kInstrumentation> latency_scope(latency_, LATENCY_HANDLER_ON_TRADE);
+   journal_.set_time(msg.event_time());
+
    const Instrument* instrument = &msg.instrument();
-   double price = msg.trade().price();
+   int slot = instrument_index_.Find(instrument);
+   if (slot == InstrumentIndex::kNotFound) return;
+
+   TickPrice price = tick_scales_[slot].ToTicks(msg.trade().price());
   
-   UpdateHighLow(instrument, price);
+   UpdateHighLow(slot, ToEpochMicros(msg.event_time()), price);
   
-   auto& state = instrument_states_[instrument];
+   auto& state = instrument_states_[slot];
+   Bracket::Phase phase = state.bracket.phase();
   
-   switch(state.status) {
-       case InstrumentState::IDLE:
+   switch(phase) {
+       case Bracket::FLAT:
        {
            // Look For entries
            bool is_near_high;
-           if (IsNearSignificantLevel(instrument, price, is_near_high)) {
-               // state.status = InstrumentState::HUNTING;
-               ProcessPotentialEntry(instrument, price);
+           if (IsNearSignificantLevel(slot, price, is_near_high)) {
+               ProcessPotentialEntry(instrument, slot, price);
            }
            break;
        }
-       case InstrumentState::HUNTING:
-           // Already hunting - handled by ProcessPotentialEntry in previous state
-           break;
-          
-       case InstrumentState::IN_POSITION:
-           ManagePosition(instrument, price);
+       case Bracket::ENTERING:
+           // Entry working - the target and stop follow its first fill
            break;
           
-       case InstrumentState::EXITING:
+       case Bracket::OPEN:
+       case Bracket::EXITING:
        {
-           if (portfolio().position(instrument) == 0) {
-               state.status = InstrumentState::IDLE;
-               state.position_side = 0;
-               state.entry_price = 0;
+           // Fires the stop, or retries an exit the venue rejected
+           bool was_open = state.bracket.phase() == Bracket::OPEN;
+           BracketStep steps[Bracket::kMaxSteps];
+           int num_steps = state.bracket.OnPrice(price, steps);
+           if (Policy::kDebugLog && debug_ && was_open && state.bracket.phase() == Bracket::EXITING) {
+               log_.Log("Stop hit for {} at price: {}", instrument->symbol(), msg.trade().price());
            }
+           SendBracketSteps(instrument, slot, steps, num_steps);
            break;
        }
    }
+
+   if (state.bracket.phase() != phase) {
+       journal_.State(slot, phase, state.bracket.phase());
+   }
 }
 
-void StopLossHunter::UpdateHighLow(const Instrument* instrument, double price)
+template <typename Policy>
+void StopLossHunterT<Policy>::UpdateHighLow(int slot, int64_t time_us, TickPrice price)
 {
-   auto& price_window = price_windows_[instrument];
-   price_window.push_back(price);
+   // One update feeds every horizon
+   auto& tracker = level_trackers_[slot];
+   tracker.OnPrice(time_us, price);
   
-   if (!price_window.full()) {
+   if (lookback_period_ <= 0 || !tracker.ready(0)) {
        return;
    }
 
-   auto& state = instrument_states_[instrument];
+   auto& state = instrument_states_[slot];
   
-   state.last_high = *(std::max_element(price_window.begin(), price_window.end()));
-   state.last_low = *(std::min_element(price_window.begin(), price_window.end()));
+   state.last_high = tracker.high(0);
+   state.last_low = tracker.low(0);
   
    // if (debug_) {
    //     std::stringstream ss;
@@ -147,26 +196,17 @@ void StopLossHunter::UpdateHighLow(const Instrument* instrument, double price)
   
 }
 
-bool StopLossHunter::IsNearSignificantLevel(const Instrument* instrument, double price, bool& is_near_high)
+template <typename Policy>
+bool StopLossHunterT<Policy>::IsNearSignificantLevel(int slot, TickPrice price, bool& is_near_high)
 {
-   const auto& state = instrument_states_[instrument];
-   double tick_size = instrument->min_tick_size();
-  
-   double high_distance = fabs(price - state.last_high);
-   double low_distance = fabs(price - state.last_low);
-  
-   if (high_distance <= entry_range_ticks_ * tick_size) {
-       is_near_high = true;
-       return true;
-   } else if (low_distance <= entry_range_ticks_ * tick_size) {
-       is_near_high = false; // Is near low = True
-       return true;
-   }
-  
-   return false;
+   // Horizons with a full window, lookback_period first; the first with a level
+   // in range decides, its high before its low
+   TickPrice entry_range = TickCountFloor(entry_range_ticks_);
+   return level_trackers_[slot].FindNear(price, entry_range, is_near_high) != LevelTracker::kNone;
 }
 
-bool StopLossHunter::IsSafeToTrade(const Instrument* instrument)
+template <typename Policy>
+bool StopLossHunterT<Policy>::IsSafeToTrade(const Instrument* instrument, int slot)
 {
    // Check if we have valid quote
    const auto& quote = instrument->top_quote();
@@ -174,9 +214,8 @@ bool StopLossHunter::IsSafeToTrade(const Instrument* instrument)
        return false;
    }
   
-   // Check volatility
-   double vol = CalculateVolatility(instrument);
-   if (vol < volatility_threshold_) {
+   // Check volatility, cached by OnTopQuote
+   if (CalculateVolatility(slot) < volatility_threshold_) {
        // It means that the price is revolving around the region and we might not have good momentum to break the high/low
        return false;
    }
@@ -184,54 +223,50 @@ bool StopLossHunter::IsSafeToTrade(const Instrument* instrument)
    return true;
 }
 
-double StopLossHunter::CalculateVolatility(const Instrument* instrument)
+template <typename Policy>
+double StopLossHunterT<Policy>::CalculateVolatility(int slot)
 {
-   auto& vol_window = volatility_windows_[instrument];
-   if (!vol_window.full()) {
-       return 0.0;
-   }
-  
-   return vol_window.StdDev();
+   // 0 until a full volatility_period has been seen
+   return volatility_trackers_[slot].volatility();
 }
 
-void StopLossHunter::ProcessPotentialEntry(const Instrument* instrument, double price)
+template <typename Policy>
+void StopLossHunterT<Policy>::ProcessPotentialEntry(const Instrument* instrument, int slot, TickPrice price)
 {
-   auto& state = instrument_states_[instrument];
+   auto& state = instrument_states_[slot];
   
-   if (!IsSafeToTrade(instrument)) {
+   // One bracket at a time: no entry while the last one still has an order or a position
+   if (state.bracket.phase() != Bracket::FLAT) {
+       return;
+   }
+
+   if (!IsSafeToTrade(instrument, slot)) {
        return;
    }
   
    bool is_near_high;
-   if (!IsNearSignificantLevel(instrument, price, is_near_high)) {
-       state.status = InstrumentState::IDLE;
+   if (!IsNearSignificantLevel(slot, price, is_near_high)) {
        return;
    }
   
-   state.status = InstrumentState::HUNTING;
-  
    // Calculate position size based on risk
    double risk_amount = portfolio().cash_balance() * account_risk_per_trade_;
-   double risk_per_share = max_loss_ticks_ * instrument->min_tick_size();
+   double risk_per_share = max_loss_ticks_ * tick_scales_[slot].tick_size();
    int position_size = static_cast<int>(risk_amount / risk_per_share);
   
-   // Enter long near high, short near low
-   if (is_near_high) {
-       SendOrder(instrument, true, 1);  // Buy at market when near high
-       state.position_side = 1;
-   } else {
-       SendOrder(instrument, false, 1); // Sell at market when near low
-       state.position_side = -1;
-   }
-  
-   // state.entry_price = price;
-   // state.entry_time = GetCurrentTime();
-   // state.status = InstrumentState::IN_POSITION;
+   const TickScale& scale = tick_scales_[slot];
+   journal_.Signal(slot, JOURNAL_SIGNAL_ENTRY, CalculateVolatility(slot), scale.ToPrice(state.last_high),
+                   scale.ToPrice(state.last_low), scale.ToPrice(price));
+
+   // Buy at market when near high, sell at market when near low
+   state.bracket.Open(is_near_high ? 1 : -1, 1, TickCountCeil(target_ticks_), TickCountCeil(max_loss_ticks_));
+   state.bracket.OnEntrySent(SendOrder(instrument, slot, is_near_high, 1));
 }
 
-void StopLossHunter::SendOrder(const Instrument* instrument, bool is_buy, int quantity)
+template <typename Policy>
+OrderID StopLossHunterT<Policy>::SendOrder(const Instrument* instrument, int slot, bool is_buy, int quantity)
 {
-   if (quantity <= 0) return;
+   if (quantity <= 0) return 0;
 
    OrderParams params(*instrument,
                      quantity,
@@ -241,89 +276,268 @@ void StopLossHunter::SendOrder(const Instrument* instrument, bool is_buy, int qu
                      ORDER_TIF_DAY,
                      ORDER_TYPE_MARKET);
 
-   if (debug_) {
-       cout << "Sending Market " << (is_buy ? "Buy" : "Sell")
-          << " order for " << instrument->symbol()
-          << " Qty: " << quantity << endl;
+   if (Policy::kDebugLog && debug_) {
+       log_.Log("Sending Market {} order for {} Qty: {}",
+                is_buy ? "Buy" : "Sell", instrument->symbol(), quantity);
    }
 
-   trade_actions()->SendNewOrder(params);
+   OrderID order_id = trade_actions()->SendNewOrder(params);
+   RecordOrderAction(slot);
+   journal_.Order(slot, JOURNAL_ORDER_NEW, order_id, is_buy ? quantity : -quantity, 0.0);
+   return order_id;
 }
 
-void StopLossHunter::ManagePosition(const Instrument* instrument, double price)
+template <typename Policy>
+OrderID StopLossHunterT<Policy>::SendLimitOrder(const Instrument* instrument, int slot, bool is_buy, int quantity, double price)
 {
-   auto& state = instrument_states_[instrument];
-   double tick_size = 0.01; 
-  
-   // Calculate profit in ticks
-   double profit_ticks = state.position_side * (price - state.entry_price) / tick_size;
-  
-   if (profit_ticks >= target_ticks_ || profit_ticks <= -max_loss_ticks_) {
-       state.status = InstrumentState::EXITING;
-      
-       // Exit position
-       int current_position = portfolio().position(instrument);
-       if (current_position != 0) {
-           SendOrder(instrument, current_position < 0, abs(current_position));
+   if (quantity <= 0) return 0;
+
+   OrderParams params(*instrument,
+                     quantity,
+                     price,
+                     MARKET_CENTER_ID_IEX,
+                     is_buy ? ORDER_SIDE_BUY : ORDER_SIDE_SELL,
+                     ORDER_TIF_DAY,
+                     ORDER_TYPE_LIMIT);
+
+   if (Policy::kDebugLog && debug_) {
+       log_.Log("Sending Limit {} order for {} Qty: {} Price: {}",
+                is_buy ? "Buy" : "Sell", instrument->symbol(), quantity, price);
+   }
+
+   OrderID order_id = trade_actions()->SendNewOrder(params);
+   RecordOrderAction(slot);
+   journal_.Order(slot, JOURNAL_ORDER_NEW, order_id, is_buy ? quantity : -quantity, price);
+   return order_id;
+}
+
+template <typename Policy>
+void StopLossHunterT<Policy>::SendBracketSteps(const Instrument* instrument, int slot, const BracketStep* steps, int num_steps)
+{
+   Bracket& bracket = instrument_states_[slot].bracket;
+   double target_price = tick_scales_[slot].ToPrice(bracket.target_ticks());
+
+   for (int i = 0; i < num_steps; ++i) {
+       const BracketStep& step = steps[i];
+       switch (step.action) {
+           case BRACKET_ACTION_NEW_TARGET:
+               bracket.OnTargetSent(SendLimitOrder(instrument, slot, step.is_buy, step.quantity, target_price), step.quantity);
+               break;
+           case BRACKET_ACTION_RESIZE_TARGET:
+               trade_actions()->SendCancelReplaceOrder(bracket.target_order_id(), step.quantity, target_price);
+               RecordOrderAction(slot);
+               journal_.Order(slot, JOURNAL_ORDER_REPLACE, bracket.target_order_id(),
+                              step.is_buy ? step.quantity : -step.quantity, target_price);
+               break;
+           case BRACKET_ACTION_CANCEL_TARGET:
+               trade_actions()->SendCancelOrder(bracket.target_order_id());
+               RecordOrderAction(slot);
+               journal_.Order(slot, JOURNAL_ORDER_CANCEL, bracket.target_order_id(),
+                              step.is_buy ? step.quantity : -step.quantity, target_price);
+               break;
+           case BRACKET_ACTION_EXIT:
+               bracket.OnExitSent(SendOrder(instrument, slot, step.is_buy, step.quantity), step.quantity);
+               break;
        }
    }
 }
 
-void StopLossHunter::OnOrderUpdate(const OrderUpdateEventMsg& msg) {
-  if (debug_) {
-      std::stringstream ss;
-      ss << "Order Update: " << msg.order().instrument()->symbol()
-         << " Status: " << msg.order().order_state();
-      logger().LogToClient(LOGLEVEL_DEBUG, ss.str());
+template <typename Policy>
+void StopLossHunterT<Policy>::OnOrderUpdate(const OrderUpdateEventMsg& msg) {
+  OptionalLatencyScope<Policy::kInstrumentation> latency_scope(latency_, LATENCY_HANDLER_ON_ORDER_UPDATE);
+  journal_.set_time(msg.event_time());
+
+  if (Policy::kDebugLog && debug_) {
+      log_.Log("Order Update: {} Status: {}",
+               msg.order().instrument()->symbol(), static_cast<int>(msg.order().order_state()));
   }
 
-  if (msg.update_type() == ORDER_UPDATE_TYPE_FILL) {
-      auto& state = instrument_states_[msg.order().instrument()];
+  int slot = instrument_index_.Find(msg.order().instrument());
+  if (slot == InstrumentIndex::kNotFound) return;
+
+  auto& state = instrument_states_[slot];
+  Bracket::Phase phase = state.bracket.phase();
+  OrderID order_id = msg.order().order_id();
+  BracketStep steps[Bracket::kMaxSteps];
+  int num_steps = 0;
+
+  // The sibling order is cancelled or resized from here, not on the next trade
+  switch (msg.update_type()) {
+      case ORDER_UPDATE_TYPE_OPEN:
+      case ORDER_UPDATE_TYPE_MODIFY:
+          num_steps = state.bracket.OnAcknowledged(order_id, steps);
+          break;
+      case ORDER_UPDATE_TYPE_PARTIAL_FILL:
+      case ORDER_UPDATE_TYPE_FILL: {
+          int fill_size = abs(msg.fill()->fill_size());
+          position_book_.OnFill(slot, msg.order().order_side() == ORDER_SIDE_BUY ? fill_size : -fill_size,
+                                msg.fill()->fill_price());
+          journal_.Fill(slot, order_id, msg.order().order_side() == ORDER_SIDE_BUY ? fill_size : -fill_size,
+                        msg.fill()->fill_price());
+          num_steps = state.bracket.OnFill(order_id, fill_size, tick_scales_[slot].ToTicks(msg.fill()->fill_price()), steps);
+          break;
+      }
+      case ORDER_UPDATE_TYPE_CANCEL:
+      case ORDER_UPDATE_TYPE_REJECT:
+          num_steps = state.bracket.OnOrderGone(order_id, steps);
+          break;
+      case ORDER_UPDATE_TYPE_CANCEL_REJECT:
+          num_steps = state.bracket.OnCancelRejected(order_id, steps);
+          break;
+      default:
+          break;
+  }
+  SendBracketSteps(msg.order().instrument(), slot, steps, num_steps);
+
+  if (state.bracket.phase() != phase) {
+      journal_.State(slot, phase, state.bracket.phase());
+  }
 
-      if (state.status == InstrumentState::HUNTING) {
-          // We have successfully filled the entry orders
-          state.status = InstrumentState::IN_POSITION;
-          state.entry_price = msg.fill()->fill_price();
-          state.entry_time = msg.event_time();
+  if (phase == Bracket::ENTERING && state.bracket.phase() != Bracket::ENTERING) {
+      state.entry_time = msg.event_time();
 
-          if (debug_) {
-              cout << "Entry filled for " << msg.order().instrument()->symbol()
-                 << " at price: " << state.entry_price << endl;
-          }
+      if (Policy::kDebugLog && debug_) {
+          const TickScale& scale = tick_scales_[slot];
+          log_.Log("Entry filled for {} at price: {} Target: {} Stop: {}",
+                   msg.order().instrument()->symbol(), scale.ToPrice(state.bracket.entry_ticks()),
+                   scale.ToPrice(state.bracket.target_ticks()), scale.ToPrice(state.bracket.stop_ticks()));
       }
+  }
 
-      if (state.status == InstrumentState::EXITING) {
-          state.status = InstrumentState::IDLE;
-          state.position_side = 0;
-          state.entry_price = 0;
-          state.entry_time = boost::posix_time::not_a_date_time;
+  if (phase != Bracket::FLAT && state.bracket.phase() == Bracket::FLAT) {
+      state.entry_time = boost::posix_time::not_a_date_time;
 
-          if (debug_) {
-              cout  << "Exit complete for " << msg.order().instrument()->symbol() << endl;
-          }
+      if (Policy::kDebugLog && debug_) {
+          log_.Log("Exit complete for {}", msg.order().instrument()->symbol());
       }
   }
 }
 
-void StopLossHunter::OnTopQuote(const QuoteEventMsg& msg)
+template <typename Policy>
+void StopLossHunterT<Policy>::OnTopQuote(const QuoteEventMsg& msg)
 {
+   int slot = instrument_index_.Find(&msg.instrument());
+   if (slot == InstrumentIndex::kNotFound) return;
+
    // Update volatility using mid price
-   auto& vol_window = volatility_windows_[&msg.instrument()];
    double mid_price = (msg.quote().ask() + msg.quote().bid()) / 2.0;
-   vol_window.push_back(mid_price);
+   volatility_trackers_[slot].OnPrice(mid_price);
+   position_book_.Mark(slot, mid_price);
 }
 
-void StopLossHunter::OnBar(const BarEventMsg& msg)
+template <typename Policy>
+void StopLossHunterT<Policy>::OnBar(const BarEventMsg& msg)
 {
    // Not using bars for this strategy
 }
 
-void StopLossHunter::DefineStrategyCommands()
+template <typename Policy>
+void StopLossHunterT<Policy>::DefineStrategyCommands()
+{
+   commands().AddCommand(StrategyCommand(1, "Dump Latency Stats"));
+}
+
+template <typename Policy>
+void StopLossHunterT<Policy>::OnStrategyCommand(const StrategyCommandEventMsg& msg)
+{
+   switch (msg.command_id()) {
+       case 1:
+           ReportLatencyStats("command");
+           break;
+       default:
+           logger().LogToClient(LOGLEVEL_DEBUG, "Unknown strategy command received");
+           break;
+   }
+}
+
+template <typename Policy>
+void StopLossHunterT<Policy>::UpdateLevelHorizons()
+{
+   std::vector<LevelHorizon> horizons;
+   if (lookback_period_ > 0) {
+       horizons.push_back(LevelHorizon(LevelHorizon::TRADES, lookback_period_));
+   }
+   ParseLevelHorizons(level_horizons_, horizons);
+
+   // The trackers start over; last_high/last_low hold until the lookback window refills
+   for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+       level_trackers_[slot].SetHorizons(horizons);
+   }
+}
+
+template <typename Policy>
+void StopLossHunterT<Policy>::StartJournal()
 {
-   // No custom commands needed for now
+   if (!journal_.Open(journal_path_, "StopLossHunter")) {
+       logger().LogToClient(LOGLEVEL_ERROR, "Could not write " + journal_path_);
+       return;
+   }
+   for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+       journal_.SetSymbol(slot, instrument_index_.instrument(slot)->symbol());
+   }
+   journal_.DefineLabel(JOURNAL_STATE, Bracket::FLAT, "FLAT");
+   journal_.DefineLabel(JOURNAL_STATE, Bracket::ENTERING, "ENTERING");
+   journal_.DefineLabel(JOURNAL_STATE, Bracket::OPEN, "OPEN");
+   journal_.DefineLabel(JOURNAL_STATE, Bracket::EXITING, "EXITING");
+   journal_.DefineLabel(JOURNAL_SIGNAL, JOURNAL_SIGNAL_ENTRY, "entry", "volatility", "high", "low", "price");
 }
 
-void StopLossHunter::OnParamChanged(StrategyParam& param)
+template <typename Policy>
+void StopLossHunterT<Policy>::ReconcilePositions()
+{
+   int mismatches = 0;
+   for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+       const Instrument* instrument = instrument_index_.instrument(slot);
+       int book_position = position_book_.position(slot);
+       int portfolio_position = portfolio().position(instrument);
+       if (!position_book_.Reconcile(slot, portfolio_position)) {
+           ++mismatches;
+           std::stringstream ss;
+           ss << "Position mismatch for " << instrument->symbol()
+              << " Book: " << book_position
+              << " Portfolio: " << portfolio_position;
+           logger().LogToClient(LOGLEVEL_WARNING, ss.str());
+       }
+   }
+
+   std::stringstream ss;
+   ss << "Position book:"
+      << " Realized PnL: " << position_book_.TotalRealizedPnl()
+      << " Unrealized PnL: " << position_book_.TotalUnrealizedPnl()
+      << " Mismatches: " << mismatches;
+   logger().LogToClient(LOGLEVEL_INFO, ss.str());
+}
+
+template <typename Policy>
+void StopLossHunterT<Policy>::RecordOrderAction(int slot)
+{
+   if (Policy::kInstrumentation) {
+      latency_.RecordOrderAction(slot);
+   }
+}
+
+template <typename Policy>
+void StopLossHunterT<Policy>::ReportLatencyStats(const std::string& reason)
+{
+   if (!Policy::kInstrumentation) {
+      logger().LogToClient(LOGLEVEL_INFO, "Latency stats are only recorded by the diagnostic build");
+      return;
+   }
+
+   for (int handler = 0; handler < LATENCY_HANDLER_COUNT; ++handler) {
+       std::string summary = latency_.Summary(handler);
+       if (!summary.empty()) {
+           logger().LogToClient(LOGLEVEL_INFO, summary);
+       }
+   }
+
+   if (!latency_.Dump(latency_path_, instrument_index_, reason)) {
+       logger().LogToClient(LOGLEVEL_ERROR, "Could not write " + latency_path_);
+   }
+}
+
+template <typename Policy>
+void StopLossHunterT<Policy>::OnParamChanged(StrategyParam& param)
 {
    if (param.param_name() == "entry_range_ticks") {
        if (!param.Get(&entry_range_ticks_))
@@ -337,22 +551,58 @@ void StopLossHunter::OnParamChanged(StrategyParam& param)
    } else if (param.param_name() == "lookback_period") {
        if (!param.Get(&lookback_period_))
            throw StrategyStudioException("Could not get lookback_period");
+       UpdateLevelHorizons();
+   } else if (param.param_name() == "level_horizons") {
+       std::string level_horizons;
+       std::vector<LevelHorizon> horizons;
+       if (!param.Get(&level_horizons))
+           throw StrategyStudioException("Could not get level_horizons");
+       if (!ParseLevelHorizons(level_horizons, horizons))
+           throw StrategyStudioException("level_horizons must be a list like 10000t,15m,60m (t trades, s/m/h time)");
+       level_horizons_ = level_horizons;
+       UpdateLevelHorizons();
    } else if (param.param_name() == "volatility_period") {
        if (!param.Get(&volatility_period_))
            throw StrategyStudioException("Could not get volatility_period");
+       for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+           volatility_trackers_[slot].SetWindow(volatility_period_);
+       }
+   } else if (param.param_name() == "volatility_mode") {
+       int volatility_mode;
+       if (!param.Get(&volatility_mode))
+           throw StrategyStudioException("Could not get volatility_mode");
+       if (volatility_mode < VOLATILITY_MODE_PRICE || volatility_mode > VOLATILITY_MODE_EWMA)
+           throw StrategyStudioException("volatility_mode must be 0 (price), 1 (log return) or 2 (EWMA)");
+       volatility_mode_ = volatility_mode;
+       for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+           volatility_trackers_[slot].set_mode(static_cast<VolatilityMode>(volatility_mode_));
+       }
    } else if (param.param_name() == "volatility_threshold") {
        if (!param.Get(&volatility_threshold_))
            throw StrategyStudioException("Could not get volatility_threshold");
    } else if (param.param_name() == "account_risk_per_trade") {
        if (!param.Get(&account_risk_per_trade_))
            throw StrategyStudioException("Could not get account_risk_per_trade");
+   } else if (param.param_name() == "latency_stats") {
+       if (!param.Get(&latency_stats_))
+           throw StrategyStudioException("Could not get latency_stats");
+       latency_.set_enabled(Policy::kInstrumentation && latency_stats_);
+   } else if (param.param_name() == "decision_journal") {
+       if (!param.Get(&decision_journal_))
+           throw StrategyStudioException("Could not get decision_journal");
+       if (decision_journal_) {
+           StartJournal();
+       } else {
+           journal_.Close();
+       }
    } else if (param.param_name() == "debug") {
        if (!param.Get(&debug_))
            throw StrategyStudioException("Could not get debug");
+       if (Policy::kDebugLog && debug_) {
+           log_.Start(log_path_);
+       }
    }
 }
 
-
-
-
-
+// The variant this library is built as (see StrategyPolicy.h)
+template class StopLossHunterT<StrategyPolicy>;
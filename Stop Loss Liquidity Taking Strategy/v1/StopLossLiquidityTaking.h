@@ -39,51 +39,59 @@
 #include <Analytics/ScalarRollingWindow.h>
 #include <MarketModels/Instrument.h>
 #include <Utilities/ParseConfig.h>
-
+#include <AsyncLogger.h>
+#include <BracketOrder.h>
+#include <CacheAligned.h>
+#include <DecisionJournal.h>
+#include <EventTime.h>
+#include <InstrumentIndex.h>
+#include <LatencyRecorder.h>
+#include <LevelTracker.h>
+#include <PositionBook.h>
+#include <RollingVolatility.h>
+#include <StrategyPolicy.h>
+#include <TickPrice.h>
 
 #include <algorithm>
-#include <unordered_map>
-#include <tuple>
 
 using namespace RCM::StrategyStudio;
 
 // Trading state for each instrument
 struct InstrumentState {
-    enum Status {
-        IDLE,           // Idle, waiting for something favorable in markets
-        HUNTING,        // Near significant level, ready to enter
-        IN_POSITION,    // Have an active position
-        EXITING         // Exit orders working
-    };
-
-    // Status: IDLE ---> HUNTING (Price in our target region, send orders) ---> IN_POSITION (Entered trade) ---> EXITING (Sending exit orders) ---> IDLE (Exit Orders Executed)
+    // Status is bracket.phase(): FLAT (waiting for something favorable in markets) ---> ENTERING (Price in our target region, entry sent)
+    // ---> OPEN (Entered trade, target resting and stop armed) ---> EXITING (Stop hit, flattening) ---> FLAT (Target or exit filled)
 
     InstrumentState() : 
-        status(IDLE),
         last_high(0),
         last_low(0),
-        entry_price(0),
-        entry_time(boost::posix_time::not_a_date_time),
-        position_side(0) {}  // 1 for long, -1 for short, 0 for flat
-
-    Status status;
-    double last_high;
-    double last_low;
-    double entry_price;
+        entry_time(boost::posix_time::not_a_date_time) {}
+
+    TickPrice last_high;
+    TickPrice last_low;
     TimeType entry_time;
-    int position_side;
+    Bracket bracket;           // Entry, target and stop orders
 };
 
-class StopLossHunter : public Strategy {
+// Policy is a StrategyPolicy.h policy: which debug and instrumentation code
+// is compiled in
+template <typename Policy>
+class StopLossHunterT : public Strategy {
+    friend class StopLossHunterBench;   // Tools/Bench drives the private kernels directly
+
 public:
-    StopLossHunter(StrategyID strategyID, const std::string& strategyName, const std::string& groupName);
-    ~StopLossHunter();
+    enum JournalSignal {
+        JOURNAL_SIGNAL_ENTRY     // volatility, lookback high, lookback low, price
+    };
+
+    StopLossHunterT(StrategyID strategyID, const std::string& strategyName, const std::string& groupName);
+    ~StopLossHunterT();
 
 public: // Event handlers
     virtual void OnTrade(const TradeDataEventMsg& msg);
     virtual void OnTopQuote(const QuoteEventMsg& msg);
     virtual void OnBar(const BarEventMsg& msg);
     virtual void OnOrderUpdate(const OrderUpdateEventMsg& msg);
+    virtual void OnStrategyCommand(const StrategyCommandEventMsg& msg);
     virtual void OnResetStrategyState();
     virtual void OnParamChanged(StrategyParam& param);
 
@@ -93,30 +101,52 @@ private: // Strategy setup
     virtual void DefineStrategyCommands();
 
 private: // Trading logic
-    void UpdateHighLow(const Instrument* instrument, double price);
-    bool IsNearSignificantLevel(const Instrument* instrument, double price, bool& is_near_high);
-    bool IsSafeToTrade(const Instrument* instrument);
-    double CalculateVolatility(const Instrument* instrument);
-    void ProcessPotentialEntry(const Instrument* instrument, double price);
-    void ManagePosition(const Instrument* instrument, double price);
-    void SendOrder(const Instrument* instrument, bool is_buy, int quantity);
+    void UpdateHighLow(int slot, int64_t time_us, TickPrice price);
+    bool IsNearSignificantLevel(int slot, TickPrice price, bool& is_near_high);
+    bool IsSafeToTrade(const Instrument* instrument, int slot);
+    double CalculateVolatility(int slot);
+    void ProcessPotentialEntry(const Instrument* instrument, int slot, TickPrice price);
+    void SendBracketSteps(const Instrument* instrument, int slot, const BracketStep* steps, int num_steps);
+    OrderID SendOrder(const Instrument* instrument, int slot, bool is_buy, int quantity);
+    OrderID SendLimitOrder(const Instrument* instrument, int slot, bool is_buy, int quantity, double price);
+    void UpdateLevelHorizons();
+    void StartJournal();
+    void ReconcilePositions();
+    void RecordOrderAction(int slot);
+    void ReportLatencyStats(const std::string& reason);
 
 private: // Strategy parameters
     double entry_range_ticks_;     // Range around highs/lows to enter
     double target_ticks_;          // Profit target in ticks from entry price
     double max_loss_ticks_;        // Stop loss in ticks from entry price
     int lookback_period_;          // Period for high/low calculation
+    std::string level_horizons_;   // Further high/low horizons, e.g. "10000t,15m,60m"
     int volatility_period_;        // Period for volatility check
+    int volatility_mode_;          // VolatilityMode: mid price, log-return or EWMA std dev
     double volatility_threshold_;  // Minimum rolling volatility needed
     double account_risk_per_trade_; // Risk per trade (0.1%)
+    bool latency_stats_;           // Record tick-to-order latency histograms
+    bool decision_journal_;        // Write the binary decision journal
     bool debug_;                   // Debug mode flag
 
-private: // Strategy state
-    std::unordered_map<const Instrument*, InstrumentState> instrument_states_;
-    std::unordered_map<const Instrument*, Analytics::ScalarRollingWindow<double>> price_windows_;
-    std::unordered_map<const Instrument*, Analytics::ScalarRollingWindow<double>> volatility_windows_;
+private: // Strategy state, one entry per instrument slot
+    InstrumentIndex instrument_index_;
+    CacheAlignedVector<InstrumentState> instrument_states_;
+    CacheAlignedVector<TickScale> tick_scales_;    // From each instrument's min_tick_size()
+    CacheAlignedVector<LevelTracker> level_trackers_;   // lookback_period trades first, then level_horizons
+    CacheAlignedVector<VolatilityTracker> volatility_trackers_;      // Fed with every mid price
+    PositionBook position_book_;   // Our own fills; reconciled with portfolio() at day end
+    std::string log_path_;
+    AsyncLogger log_;              // Debug output, formatted off the event thread
+    std::string latency_path_;
+    LatencyRecorder latency_;
+    std::string journal_path_;
+    DecisionJournal journal_;      // Bracket phases, entry signals, orders and fills
 };
 
+// The variant selected by the build; the diagnostic .so defines STRATEGY_DIAGNOSTIC
+typedef StopLossHunterT<StrategyPolicy> StopLossHunter;
+
 extern "C" {
     _STRATEGY_EXPORTS const char* GetType() { return "StopLossHunter"; }
     _STRATEGY_EXPORTS const char* GetAuthor() { return "##"; }
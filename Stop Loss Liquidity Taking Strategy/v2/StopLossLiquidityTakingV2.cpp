@@ -7,79 +7,166 @@
 #include <Utilities/utils.h>
 
 #include <math.h>
+#include <stdlib.h>
 #include <iostream>
 #include <sstream>
 #include <cassert>
-#include <numeric>
 
 using namespace RCM::StrategyStudio;
 using namespace RCM::StrategyStudio::MarketModels;
 using namespace RCM::StrategyStudio::Utilities;
 using namespace std;
 
-StopLossHunterV2::StopLossHunterV2(StrategyID strategyID, const std::string& strategyName, const std::string& groupName):
+// Name of the recurring scheduled event that advances the hold timers
+static const char* const kHoldTimerEvent = "HoldTimers";
+
+template <typename Policy>
+StopLossHunterV2T<Policy>::StopLossHunterV2T(StrategyID strategyID, const std::string& strategyName, const std::string& groupName):
    Strategy(strategyID, strategyName, groupName),
    entry_range_ticks_(3),         
    target_ticks_(1),           
+   max_loss_ticks_(0),
    tick_lookback_(11),
+   bar_specs_("1h"),
+   rolling_level_minutes_(60),
+   min_level_seconds_(60),
    momentum_threshold_(0),
    max_hold_seconds_(15),
+   hold_timer_ms_(100),
    account_risk_per_trade_(0.001),
+   latency_stats_(false),
+   decision_journal_(false),
    debug_(true),
-   current_strategy_time_(boost::posix_time::not_a_date_time)  // Initialize time
+   log_path_(strategyName + ".log"),
+   latency_path_(strategyName + "_latency.csv"),
+   journal_path_(strategyName + ".journal")
 {
 }
 
-StopLossHunterV2::~StopLossHunterV2()
+template <typename Policy>
+StopLossHunterV2T<Policy>::~StopLossHunterV2T()
 {
+    // The last day has no reset after it
+    if (Policy::kInstrumentation && latency_stats_) {
+        latency_.Dump(latency_path_, instrument_index_, "final");
+    }
 }
 
-void StopLossHunterV2::OnResetStrategyState()
+template <typename Policy>
+void StopLossHunterV2T<Policy>::OnResetStrategyState()
 {
-   instrument_states_.clear();
+   if (Policy::kInstrumentation && latency_stats_) {
+       ReportLatencyStats("eod");
+   }
+   latency_.ClearHistograms();
+   ReconcilePositions();
+   position_book_.ResetRealized();
+
+   // Slots stay assigned; only the per-instrument state is reset
+   for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+       instrument_states_[slot] = InstrumentState();
+       instrument_states_[slot].tick_momentum.SetLookback(tick_lookback_);
+       bar_aggregators_[slot].clear();
+       level_trackers_[slot].clear();
+   }
+   hold_timers_.Reset(instrument_index_.size());
 }
 
-void StopLossHunterV2::DefineStrategyParams()
+template <typename Policy>
+void StopLossHunterV2T<Policy>::DefineStrategyParams()
 {
    params().CreateParam(CreateStrategyParamArgs("entry_range_ticks", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, entry_range_ticks_));
    params().CreateParam(CreateStrategyParamArgs("target_ticks", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, target_ticks_));
+   params().CreateParam(CreateStrategyParamArgs("max_loss_ticks", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, max_loss_ticks_));
    params().CreateParam(CreateStrategyParamArgs("tick_lookback", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, tick_lookback_));
+   params().CreateParam(CreateStrategyParamArgs("bar_specs", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_STRING, bar_specs_));
+   params().CreateParam(CreateStrategyParamArgs("rolling_level_minutes", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, rolling_level_minutes_));
+   params().CreateParam(CreateStrategyParamArgs("min_level_seconds", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, min_level_seconds_));
+   params().CreateParam(CreateStrategyParamArgs("level_horizons", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_STRING, level_horizons_));
    params().CreateParam(CreateStrategyParamArgs("momentum_threshold", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, momentum_threshold_));
    params().CreateParam(CreateStrategyParamArgs("max_hold_seconds", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_INT, max_hold_seconds_));
+   params().CreateParam(CreateStrategyParamArgs("hold_timer_ms", STRATEGY_PARAM_TYPE_STARTUP, VALUE_TYPE_INT, hold_timer_ms_));
    params().CreateParam(CreateStrategyParamArgs("account_risk_per_trade", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_DOUBLE, account_risk_per_trade_));
+   params().CreateParam(CreateStrategyParamArgs("latency_stats", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_BOOL, latency_stats_));
+   params().CreateParam(CreateStrategyParamArgs("decision_journal", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_BOOL, decision_journal_));
    params().CreateParam(CreateStrategyParamArgs("debug", STRATEGY_PARAM_TYPE_RUNTIME, VALUE_TYPE_BOOL, debug_));
 }
 
-void StopLossHunterV2::RegisterForStrategyEvents(StrategyEventRegister* eventRegister, DateType currDate)
+template <typename Policy>
+void StopLossHunterV2T<Policy>::RegisterForStrategyEvents(StrategyEventRegister* eventRegister, DateType currDate)
 {
     for (SymbolSetConstIter it = symbols_begin(); it != symbols_end(); ++it) {
         eventRegister->RegisterForMarketData(*it);
-        eventRegister->RegisterForBars(*it, BAR_TYPE_TIME, 3600);
     }
 
     for (InstrumentSetConstIter it = instrument_begin(); it != instrument_end(); ++it) {
-        const Instrument* instrument = it->second;
-        instrument_states_.emplace(instrument, InstrumentState());
+        instrument_index_.Add(it->second);
+    }
+    instrument_states_.resize(instrument_index_.size());
+    tick_scales_.resize(instrument_index_.size());
+    for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+        tick_scales_[slot].set_tick_size(instrument_index_.instrument(slot)->min_tick_size());
+    }
+    for (auto& state : instrument_states_) {
+        state.tick_momentum.SetLookback(tick_lookback_);
+    }
+    bar_aggregators_.resize(instrument_index_.size());
+    UpdateBarSpecs();
+    level_trackers_.resize(instrument_index_.size());
+    UpdateLevelHorizons();
+    // The wheel ticks at the scheduled event interval, so each hold timer
+    // event advances it by one tick
+    hold_timers_ = TimerWheel(hold_timer_ms_ > 0 ? hold_timer_ms_ * 1000LL : 1000);
+    hold_timers_.Reset(instrument_index_.size());
+    if (hold_timer_ms_ > 0) {
+        // Only over the regular session, plus the longest hold of a position
+        // opened at the close; outside it exits wait for market data
+        TimeType open = FromNewYorkTime(currDate, boost::posix_time::hours(9) + boost::posix_time::minutes(30));
+        TimeType close = FromNewYorkTime(currDate, boost::posix_time::hours(16));
+        eventRegister->RegisterForRecurringScheduledEvents(kHoldTimerEvent, open, close + boost::posix_time::seconds(max_hold_seconds_),
+                                                           boost::posix_time::milliseconds(hold_timer_ms_));
+    }
+    position_book_.Reset(instrument_index_.size());
+    latency_.Reset(instrument_index_.size());
+    latency_.set_enabled(Policy::kInstrumentation && latency_stats_);
+
+    if (Policy::kDebugLog && debug_) {
+        log_.Start(log_path_);
+    }
+    if (decision_journal_) {
+        StartJournal();
     }
 }
 
-void StopLossHunterV2::OnTrade(const TradeDataEventMsg& msg)
+template <typename Policy>
+void StopLossHunterV2T<Policy>::OnTrade(const TradeDataEventMsg& msg)
 {
-    current_strategy_time_ = msg.adapter_time();
+    OptionalLatencyScope<Policy::kInstrumentation> latency_scope(latency_, LATENCY_HANDLER_ON_TRADE);
+    journal_.set_time(msg.event_time());
+    FireHoldTimers(msg.event_time());
 
    const Instrument* instrument = &msg.instrument();
-   double price = msg.trade().price();
+   int slot = instrument_index_.Find(instrument);
+   if (slot == InstrumentIndex::kNotFound) return;
+
+   TickPrice price = tick_scales_[slot].ToTicks(msg.trade().price());
+
+   // Mark open positions to mid, or to the trade when there is no two-sided quote
+   const Quote& quote = instrument->top_quote();
+   bool has_mid = quote.bid_side().IsValid() && quote.ask_side().IsValid();
+   position_book_.Mark(slot, has_mid ? (quote.bid() + quote.ask()) / 2.0 : msg.trade().price());
    
-   UpdateTickMomentum(instrument, price);
+   UpdateTickMomentum(slot, price);
+   UpdateBars(instrument, slot, msg.event_time(), price, msg.trade().size());
    
-   auto& state = instrument_states_[instrument];
+   auto& state = instrument_states_[slot];
   
    switch(state.status) {
        case InstrumentState::IDLE:
        {
            bool is_near_high;
-           if (IsNearSignificantLevel(instrument, price, is_near_high)) {
-               ProcessPotentialEntry(instrument, price);
+           if (IsNearSignificantLevel(slot, price, is_near_high)) {
+               ProcessPotentialEntry(instrument, slot, price);
            }
            break;
        }
@@ -88,117 +175,154 @@ void StopLossHunterV2::OnTrade(const TradeDataEventMsg& msg)
           
        case InstrumentState::IN_POSITION:
        {
-           CheckTimeBasedExit(instrument);
+           // Stop first; the target rests on the book
+           BracketStep steps[Bracket::kMaxSteps];
+           int num_steps = state.bracket.OnPrice(price, steps);
+           if (num_steps > 0) {
+               if (Policy::kDebugLog && debug_) {
+                   log_.Log("Stop hit for {} at price: {}", instrument->symbol(), msg.trade().price());
+               }
+               SetStatus(slot, InstrumentState::EXITING);
+               hold_timers_.Cancel(slot);
+               SendBracketSteps(instrument, slot, steps, num_steps);
+           }
            break;
        }
        case InstrumentState::EXITING:
+       {
+           // Retries an exit the venue rejected
+           BracketStep steps[Bracket::kMaxSteps];
+           int num_steps = state.bracket.OnPrice(price, steps);
+           SendBracketSteps(instrument, slot, steps, num_steps);
            break;
+       }
        
        case InstrumentState::NO_TRADE:
            break;
    }
+
+   // Like the hourly levels, the level_horizons take the trade only after it was tested
+   level_trackers_[slot].OnPrice(ToEpochMicros(msg.event_time()), price);
 }
 
-void StopLossHunterV2::OnBar(const BarEventMsg& msg)
+// Bars are built here from trades rather than registered with the framework,
+// so the rolling levels are usable min_level_seconds into the session rather
+// than after the first level bar
+template <typename Policy>
+void StopLossHunterV2T<Policy>::UpdateBars(const Instrument* instrument, int slot, TimeType now, TickPrice price, double size)
 {
-    if (msg.type() != BAR_TYPE_TIME || msg.interval() != 3600) {
-        return;
+    auto& state = instrument_states_[slot];
+    BarAggregator& bars = bar_aggregators_[slot];
+
+    // The trade is tested against the rolling window as it stood before it,
+    // never against itself, once the window has min_level_seconds of trades
+    if (bars.rolling_covers(min_level_seconds_ * 1000000LL)) {
+        state.hourly_high = bars.rolling_high();
+        state.hourly_low = bars.rolling_low();
+    } else if (bars.has_rolling()) {
+        state.hourly_high = 0;
+        state.hourly_low = std::numeric_limits<TickPrice>::max();
     }
+    unsigned closed = bars.OnTrade(ToEpochMicros(now), price, size);
+    if ((closed & 1) == 0) return;
 
-    const Instrument* instrument = &msg.instrument();
-    auto& state = instrument_states_[instrument];
-
-    // New hour bar - reset to IDLE state if we were in NO_TRADE
+    // New level bar - reset to IDLE state if we were in NO_TRADE
     if (state.status == InstrumentState::NO_TRADE) {
-        state.status = InstrumentState::IDLE;
+        SetStatus(slot, InstrumentState::IDLE);
     }
 
-    state.hourly_high = msg.bar().high();
-    state.hourly_low = msg.bar().low();
-    state.last_bar_time = msg.event_time();
+    const AggregatedBar& bar = bars.bar(0);
+    if (!bars.has_rolling()) {
+        state.hourly_high = bar.high;
+        state.hourly_low = bar.low;
+    }
+    state.last_bar_time = now;
 
-    cout << "Updated hourly levels for " << instrument->symbol()
-           << " High: " << state.hourly_high
-           << " Low: " << state.hourly_low
-           << " Time: " << state.last_bar_time << endl
-           << " Status: " << state.status << endl;    
+    if (Policy::kDebugLog && debug_) {
+        const TickScale& scale = tick_scales_[slot];
+        log_.Log("Level bar closed for {} High: {} Low: {} Time: {} Status: {}",
+                 instrument->symbol(), scale.ToPrice(bar.high), scale.ToPrice(bar.low),
+                 state.last_bar_time, static_cast<int>(state.status));
+    }
 }
 
-bool StopLossHunterV2::IsNearSignificantLevel(const Instrument* instrument, double price, bool& is_near_high)
+template <typename Policy>
+bool StopLossHunterV2T<Policy>::IsNearSignificantLevel(int slot, TickPrice price, bool& is_near_high)
 {
-    const auto& state = instrument_states_[instrument];
-    
-    // Check if we have at least one completed bar
-    if (state.last_bar_time == boost::posix_time::not_a_date_time) {
-        return false;
-    }
-
-    double tick_size = instrument->min_tick_size();
-    
-    // Only proceed if we have valid hourly levels
-    if (state.hourly_high <= 0 || state.hourly_low >= std::numeric_limits<double>::max()) {
-        return false;
+    const auto& state = instrument_states_[slot];
+    TickPrice entry_range = TickCountFloor(entry_range_ticks_);
+
+    // The hourly levels come first, once they are valid
+    if (state.hourly_high > 0 && state.hourly_low < std::numeric_limits<TickPrice>::max()) {
+        TickPrice high_distance = llabs(price - state.hourly_high);
+        TickPrice low_distance = llabs(price - state.hourly_low);
+
+        if (high_distance <= entry_range) {
+            is_near_high = true;
+            return true;
+        } else if (low_distance <= entry_range) {
+            is_near_high = false;
+            return true;
+        }
     }
 
-    double high_distance = fabs(price - state.hourly_high);
-    double low_distance = fabs(price - state.hourly_low);
-
-    if (high_distance <= entry_range_ticks_ * tick_size) {
-        is_near_high = true;
-        return true;
-    } else if (low_distance <= entry_range_ticks_ * tick_size) {
-        is_near_high = false;
-        return true;
+    // Then the last closed bar of each further bar_specs entry
+    const BarAggregator& bars = bar_aggregators_[slot];
+    for (int i = 1; i < bars.num_specs(); ++i) {
+        if (!bars.has_bar(i)) continue;
+        if (llabs(price - bars.bar(i).high) <= entry_range) {
+            is_near_high = true;
+            return true;
+        }
+        if (llabs(price - bars.bar(i).low) <= entry_range) {
+            is_near_high = false;
+            return true;
+        }
     }
 
-    return false;
+    // Then the rolling level_horizons, if any are configured
+    return level_trackers_[slot].FindNear(price, entry_range, is_near_high) != LevelTracker::kNone;
 }
 
-void StopLossHunterV2::UpdateTickMomentum(const Instrument* instrument, double price)
+template <typename Policy>
+void StopLossHunterV2T<Policy>::UpdateTickMomentum(int slot, TickPrice price)
 {
-    auto& state = instrument_states_[instrument];
+    auto& state = instrument_states_[slot];
     
-    if (state.last_tick_price == 0) {
-        state.last_tick_price = price;
+    if (state.last_tick == 0) {
+        state.last_tick = price;
         return;
     }
     
-    int direction = 0;
-    if (price > state.last_tick_price) {
-        direction = 1;
-    } else if (price < state.last_tick_price) {
-        direction = -1;
-    }
-    
-    state.tick_directions.push_back(direction);
-    if (state.tick_directions.size() > tick_lookback_) {
-        state.tick_directions.pop_front();
-    }
+    // 1 up, -1 down, 0 unchanged; branch-free, as tick directions are close to random
+    int direction = (price > state.last_tick) - (price < state.last_tick);
+    state.tick_momentum.Push(direction);
     
-    state.last_tick_price = price;
+    state.last_tick = price;
 }
 
-int StopLossHunterV2::GetTickMomentumSignal(const Instrument* instrument)
+template <typename Policy>
+int StopLossHunterV2T<Policy>::GetTickMomentumSignal(int slot)
 {
-    const auto& state = instrument_states_[instrument];
+    const auto& state = instrument_states_[slot];
     
-    if (state.tick_directions.size() < tick_lookback_) {
+    if (!state.tick_momentum.full(0)) {
         return 0;
     }
     
-    int sum = std::accumulate(state.tick_directions.begin(), state.tick_directions.end(), 0);
-    
-    return sum;
+    // Kept up to date by UpdateTickMomentum
+    return state.tick_momentum.sum(0);
 }
 
-bool StopLossHunterV2::IsSafeToTrade(const Instrument* instrument)
+template <typename Policy>
+bool StopLossHunterV2T<Policy>::IsSafeToTrade(const Instrument* instrument, int slot)
 {
    const auto& quote = instrument->top_quote();
    if (!quote.ask_side().IsValid() || !quote.bid_side().IsValid()) {
        return false;
    }
    
-   int momentum = GetTickMomentumSignal(instrument);
+   int momentum = GetTickMomentumSignal(slot);
    if (momentum == 0) {
        return false;
    }
@@ -206,26 +330,32 @@ bool StopLossHunterV2::IsSafeToTrade(const Instrument* instrument)
    return true;
 }
 
-void StopLossHunterV2::ProcessPotentialEntry(const Instrument* instrument, double price)
+template <typename Policy>
+void StopLossHunterV2T<Policy>::ProcessPotentialEntry(const Instrument* instrument, int slot, TickPrice price)
 {
-   auto& state = instrument_states_[instrument];
+   auto& state = instrument_states_[slot];
   
-   if (!IsSafeToTrade(instrument)) {
+   // One bracket at a time: no entry while the last one still has an order or a position
+   if (state.bracket.phase() != Bracket::FLAT) {
+       return;
+   }
+
+   if (!IsSafeToTrade(instrument, slot)) {
        return;
    }
   
    bool is_near_high;
-   if (!IsNearSignificantLevel(instrument, price, is_near_high)) {
-       state.status = InstrumentState::IDLE;
+   if (!IsNearSignificantLevel(slot, price, is_near_high)) {
+       SetStatus(slot, InstrumentState::IDLE);
        return;
    }
   
-   int momentum = GetTickMomentumSignal(instrument);
+   int momentum = GetTickMomentumSignal(slot);
    if ((is_near_high && momentum < momentum_threshold_) || (!is_near_high && momentum > -momentum_threshold_)) {
        return;
    }
   
-   state.status = InstrumentState::HUNTING;
+   SetStatus(slot, InstrumentState::HUNTING);
   
 //    double risk_amount = portfolio().cash_balance() * account_risk_per_trade_;
 //    double risk_per_share = target_ticks_ * instrument->min_tick_size();  // Using target ticks as risk
@@ -233,22 +363,30 @@ void StopLossHunterV2::ProcessPotentialEntry(const Instrument* instrument, doubl
   
     int position_size = 1; // For trial purposes
 
-    cout << "Order Generated for " << instrument->symbol() << endl
-         << "Parameters: Current Price(LTP):" << price << " Current High/Low: " << state.hourly_high << "/" << state.hourly_low << endl
-         << "Momentum of the past " << tick_lookback_ << " ticks: " << momentum << " Min_Tick_Size for the symbol: " << instrument->min_tick_size() << endl;
+    if (Policy::kDebugLog && debug_) {
+        const TickScale& scale = tick_scales_[slot];
+        log_.Log("Order Generated for {} Parameters: Current Price(LTP):{} Current High/Low: {}/{}",
+                 instrument->symbol(), scale.ToPrice(price), scale.ToPrice(state.hourly_high),
+                 scale.ToPrice(state.hourly_low));
+        log_.Log("Momentum of the past {} ticks: {} Min_Tick_Size for the symbol: {}",
+                 tick_lookback_, momentum, scale.tick_size());
+    }
+
+   const TickScale& scale = tick_scales_[slot];
+   journal_.Signal(slot, JOURNAL_SIGNAL_ENTRY, momentum, scale.ToPrice(state.hourly_high),
+                   scale.ToPrice(state.hourly_low), scale.ToPrice(price));
 
-   if (is_near_high) {
-       SendMarketOrder(instrument, true, position_size);
-       state.position_side = 1;
-   } else {
-       SendMarketOrder(instrument, false, position_size);
-       state.position_side = -1;
+   state.bracket.Open(is_near_high ? 1 : -1, position_size, TickCountCeil(target_ticks_), TickCountCeil(max_loss_ticks_));
+   state.bracket.OnEntrySent(SendMarketOrder(instrument, slot, is_near_high, position_size));
+   if (state.bracket.phase() == Bracket::FLAT) {
+       SetStatus(slot, InstrumentState::IDLE);
    }
 }
 
-void StopLossHunterV2::SendMarketOrder(const Instrument* instrument, bool is_buy, int quantity)
+template <typename Policy>
+OrderID StopLossHunterV2T<Policy>::SendMarketOrder(const Instrument* instrument, int slot, bool is_buy, int quantity)
 {
-   if (quantity <= 0) return;
+   if (quantity <= 0) return 0;
 
    OrderParams params(*instrument,
                      quantity,
@@ -258,16 +396,21 @@ void StopLossHunterV2::SendMarketOrder(const Instrument* instrument, bool is_buy
                      ORDER_TIF_DAY,
                      ORDER_TYPE_MARKET);
 
-   cout << "Sending Market " << (is_buy ? "Buy" : "Sell")
-          << " order for " << instrument->symbol()
-          << " Qty: " << quantity << endl;
+   if (Policy::kDebugLog && debug_) {
+       log_.Log("Sending Market {} order for {} Qty: {}",
+                is_buy ? "Buy" : "Sell", instrument->symbol(), quantity);
+   }
 
-   trade_actions()->SendNewOrder(params);
+   OrderID order_id = trade_actions()->SendNewOrder(params);
+   RecordOrderAction(slot);
+   journal_.Order(slot, JOURNAL_ORDER_NEW, order_id, is_buy ? quantity : -quantity, 0.0);
+   return order_id;
 }
 
-void StopLossHunterV2::SendLimitOrder(const Instrument* instrument, bool is_buy, int quantity, double price)
+template <typename Policy>
+OrderID StopLossHunterV2T<Policy>::SendLimitOrder(const Instrument* instrument, int slot, bool is_buy, int quantity, double price)
 {
-   if (quantity < 0) return;
+   if (quantity <= 0) return 0;
 
    OrderParams params(*instrument,
                      quantity,
@@ -277,128 +420,308 @@ void StopLossHunterV2::SendLimitOrder(const Instrument* instrument, bool is_buy,
                      ORDER_TIF_DAY,
                      ORDER_TYPE_LIMIT);
 
-   cout << "Sending Limit " << (is_buy ? "Buy" : "Sell")
-          << " order for " << instrument->symbol()
-          << " Qty: " << quantity
-          << " Price: " << price << endl;
+   if (Policy::kDebugLog && debug_) {
+       log_.Log("Sending Limit {} order for {} Qty: {} Price: {}",
+                is_buy ? "Buy" : "Sell", instrument->symbol(), quantity, price);
+   }
+
+   OrderID order_id = trade_actions()->SendNewOrder(params);
+   RecordOrderAction(slot);
+   journal_.Order(slot, JOURNAL_ORDER_NEW, order_id, is_buy ? quantity : -quantity, price);
+   return order_id;
+}
+
+template <typename Policy>
+void StopLossHunterV2T<Policy>::SendBracketSteps(const Instrument* instrument, int slot, const BracketStep* steps, int num_steps)
+{
+   Bracket& bracket = instrument_states_[slot].bracket;
+   double target_price = tick_scales_[slot].ToPrice(bracket.target_ticks());
+
+   for (int i = 0; i < num_steps; ++i) {
+       const BracketStep& step = steps[i];
+       switch (step.action) {
+           case BRACKET_ACTION_NEW_TARGET:
+               bracket.OnTargetSent(SendLimitOrder(instrument, slot, step.is_buy, step.quantity, target_price), step.quantity);
+               break;
+           case BRACKET_ACTION_RESIZE_TARGET:
+               trade_actions()->SendCancelReplaceOrder(bracket.target_order_id(), step.quantity, target_price);
+               RecordOrderAction(slot);
+               journal_.Order(slot, JOURNAL_ORDER_REPLACE, bracket.target_order_id(),
+                              step.is_buy ? step.quantity : -step.quantity, target_price);
+               break;
+           case BRACKET_ACTION_CANCEL_TARGET:
+               trade_actions()->SendCancelOrder(bracket.target_order_id()); // Canceling the limit orders
+               RecordOrderAction(slot);
+               journal_.Order(slot, JOURNAL_ORDER_CANCEL, bracket.target_order_id(),
+                              step.is_buy ? step.quantity : -step.quantity, target_price);
+               break;
+           case BRACKET_ACTION_EXIT:
+               bracket.OnExitSent(SendMarketOrder(instrument, slot, step.is_buy, step.quantity), step.quantity); // Liquidating the position
+               break;
+       }
+   }
+}
+
+// Positions past max_hold_seconds are exited on the first hold timer event,
+// or event of any kind for any instrument, at or after their deadline. With
+// hold_timer_ms > 0 an exit during the regular session is therefore sent at
+// most hold_timer_ms after its deadline even when no market data arrives;
+// outside it, or with 0, it waits for the next market data or order event.
+template <typename Policy>
+void StopLossHunterV2T<Policy>::FireHoldTimers(TimeType now)
+{
+    hold_timers_.Advance(ToEpochMicros(now), [this, now](int slot) {
+        if (instrument_states_[slot].status != InstrumentState::IN_POSITION) return;
+
+        const Instrument* instrument = instrument_index_.instrument(slot);
+        if (Policy::kDebugLog && debug_) {
+            log_.Log("Exitting position for {} at time {} Reason for exit: Time based exit triggered",
+                     instrument->symbol(), now);
+        }
+        ExitPosition(instrument, slot);
+    });
+}
+
+template <typename Policy>
+void StopLossHunterV2T<Policy>::OnScheduledEvent(const ScheduledEventMsg& msg)
+{
+    if (msg.scheduled_event_name() != kHoldTimerEvent || hold_timers_.empty()) return;
+    journal_.set_time(msg.event_time());
+    FireHoldTimers(msg.event_time());
+}
 
-   trade_actions()->SendNewOrder(params);
+template <typename Policy>
+void StopLossHunterV2T<Policy>::ScheduleHoldTimer(int slot)
+{
+    hold_timers_.Schedule(slot, ToEpochMicros(instrument_states_[slot].entry_time) + max_hold_seconds_ * 1000000LL);
 }
 
-void StopLossHunterV2::CheckTimeBasedExit(const Instrument* instrument)
+template <typename Policy>
+void StopLossHunterV2T<Policy>::ExitPosition(const Instrument* instrument, int slot)
 {
-    auto& state = instrument_states_[instrument];
+    auto& state = instrument_states_[slot];
     
-    if (state.entry_time == boost::posix_time::not_a_date_time) {
-        return;
+    SetStatus(slot, InstrumentState::EXITING);
+    hold_timers_.Cancel(slot);
+
+    BracketStep steps[Bracket::kMaxSteps];
+    int num_steps = state.bracket.Exit(steps);
+    SendBracketSteps(instrument, slot, steps, num_steps);
+}
+
+template <typename Policy>
+void StopLossHunterV2T<Policy>::OnOrderUpdate(const OrderUpdateEventMsg& msg) {
+    OptionalLatencyScope<Policy::kInstrumentation> latency_scope(latency_, LATENCY_HANDLER_ON_ORDER_UPDATE);
+    journal_.set_time(msg.event_time());
+    FireHoldTimers(msg.event_time());
+
+    int slot = instrument_index_.Find(msg.order().instrument());
+    if (slot == InstrumentIndex::kNotFound) return;
+
+    auto& state = instrument_states_[slot];
+    Bracket::Phase phase = state.bracket.phase();
+    OrderID order_id = msg.order().order_id();
+    BracketStep steps[Bracket::kMaxSteps];
+    int num_steps = 0;
+
+    // Order IDs come from SendNewOrder, so a fill racing its open ack still
+    // matches, and the sibling order is handled here rather than on a later trade
+    switch (msg.update_type()) {
+        case ORDER_UPDATE_TYPE_OPEN:
+        case ORDER_UPDATE_TYPE_MODIFY:
+            if (Policy::kDebugLog && debug_ && msg.update_type() == ORDER_UPDATE_TYPE_OPEN) {
+                log_.Log("Order Opened for {} at time: {} Type: {} OrderID: [{}]",
+                         msg.order().instrument()->symbol(), msg.event_time(),
+                         msg.order().order_type() == ORDER_TYPE_MARKET ? "MARKET" : "LIMIT", msg.order_id());
+            }
+            num_steps = state.bracket.OnAcknowledged(order_id, steps);
+            break;
+        case ORDER_UPDATE_TYPE_PARTIAL_FILL:
+        case ORDER_UPDATE_TYPE_FILL: {
+            int fill_size = abs(msg.fill()->fill_size());
+            position_book_.OnFill(slot, msg.order().order_side() == ORDER_SIDE_BUY ? fill_size : -fill_size,
+                                  msg.fill()->fill_price());
+            journal_.Fill(slot, order_id, msg.order().order_side() == ORDER_SIDE_BUY ? fill_size : -fill_size,
+                          msg.fill()->fill_price());
+            num_steps = state.bracket.OnFill(order_id, fill_size, tick_scales_[slot].ToTicks(msg.fill()->fill_price()), steps);
+            break;
+        }
+        case ORDER_UPDATE_TYPE_CANCEL:
+        case ORDER_UPDATE_TYPE_REJECT:
+            num_steps = state.bracket.OnOrderGone(order_id, steps);
+            break;
+        case ORDER_UPDATE_TYPE_CANCEL_REJECT:
+            num_steps = state.bracket.OnCancelRejected(order_id, steps);
+            break;
+        default:
+            break;
     }
-    
-    TimeType current_time = current_strategy_time_;
-    if (current_time - state.entry_time > boost::posix_time::seconds(max_hold_seconds_)) {
-        cout << "Exitting position for " << instrument->symbol() << " at time " << current_time << endl
-             << "Reason for exit: Time based exit triggered" << endl;
-        ExitPosition(instrument);
+    SendBracketSteps(msg.order().instrument(), slot, steps, num_steps);
+
+    Bracket::Phase new_phase = state.bracket.phase();
+    if (new_phase == phase) return;
+
+    if (phase == Bracket::ENTERING && new_phase == Bracket::OPEN) {
+        // Market order fill; the limit target is already on its way
+        SetStatus(slot, InstrumentState::IN_POSITION);
+        state.entry_time = msg.event_time();
+        ScheduleHoldTimer(slot);
+
+        if (Policy::kDebugLog && debug_) {
+            const TickScale& scale = tick_scales_[slot];
+            log_.Log("Entry filled for {} quantity: {} at price: {} target: {} time: {}",
+                     msg.order().instrument()->symbol(), msg.fill()->fill_size(),
+                     msg.fill()->fill_price(), scale.ToPrice(state.bracket.target_ticks()), msg.update_time());
+        }
+    } else if (new_phase == Bracket::FLAT) {
+        if (phase == Bracket::ENTERING) {
+            SetStatus(slot, InstrumentState::IDLE);     // Entry never filled
+        } else {
+            if (Policy::kDebugLog && debug_) {
+                log_.Log("{} for {} at time: {} Current Status of the symbol: NO_TRADE Realized PnL: {}",
+                         phase == Bracket::OPEN ? "Target reached" : "Closed Position",
+                         msg.order().instrument()->symbol(), msg.event_time(),
+                         position_book_.entry(slot).realized_pnl);
+            }
+            SetStatus(slot, InstrumentState::NO_TRADE); // We will change this to IDLE when a new high/low is formed
+        }
+        state.entry_time = boost::posix_time::not_a_date_time;
+        hold_timers_.Cancel(slot);
     }
 }
 
-void StopLossHunterV2::ExitPosition(const Instrument* instrument)
+template <typename Policy>
+void StopLossHunterV2T<Policy>::OnTopQuote(const QuoteEventMsg& msg)
 {
-    auto& state = instrument_states_[instrument];
-    
-    state.status = InstrumentState::EXITING;
+    // Quotes only move the clock in V2
+    journal_.set_time(msg.event_time());
+    FireHoldTimers(msg.event_time());
+}
 
-    if (state.limit_order_id != 0) {
-        trade_actions()->SendCancelOrder(state.limit_order_id); // Canceling the limit orders
+template <typename Policy>
+void StopLossHunterV2T<Policy>::DefineStrategyCommands()
+{
+    commands().AddCommand(StrategyCommand(1, "Dump Latency Stats"));
+}
+
+template <typename Policy>
+void StopLossHunterV2T<Policy>::OnStrategyCommand(const StrategyCommandEventMsg& msg)
+{
+    switch (msg.command_id()) {
+        case 1:
+            ReportLatencyStats("command");
+            break;
+        default:
+            logger().LogToClient(LOGLEVEL_DEBUG, "Unknown strategy command received");
+            break;
     }
-    
-    double current_position = portfolio().position(instrument);
-    SendMarketOrder(instrument, current_position < 0, abs(current_position)); // Liquidating the position
-    return;
 }
 
-void StopLossHunterV2::OnOrderUpdate(const OrderUpdateEventMsg& msg) {
-    auto& state = instrument_states_[msg.order().instrument()];
+template <typename Policy>
+void StopLossHunterV2T<Policy>::SetStatus(int slot, InstrumentState::Status status)
+{
+    auto& state = instrument_states_[slot];
+    if (state.status != status) {
+        journal_.State(slot, state.status, status);
+        state.status = status;
+    }
+}
 
-    if(msg.update_type() == ORDER_UPDATE_TYPE_OPEN){
+template <typename Policy>
+void StopLossHunterV2T<Policy>::StartJournal()
+{
+    if (!journal_.Open(journal_path_, "StopLossHunterV2")) {
+        logger().LogToClient(LOGLEVEL_ERROR, "Could not write " + journal_path_);
+        return;
+    }
+    for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+        journal_.SetSymbol(slot, instrument_index_.instrument(slot)->symbol());
+    }
+    journal_.DefineLabel(JOURNAL_STATE, InstrumentState::IDLE, "IDLE");
+    journal_.DefineLabel(JOURNAL_STATE, InstrumentState::HUNTING, "HUNTING");
+    journal_.DefineLabel(JOURNAL_STATE, InstrumentState::IN_POSITION, "IN_POSITION");
+    journal_.DefineLabel(JOURNAL_STATE, InstrumentState::EXITING, "EXITING");
+    journal_.DefineLabel(JOURNAL_STATE, InstrumentState::NO_TRADE, "NO_TRADE");
+    journal_.DefineLabel(JOURNAL_SIGNAL, JOURNAL_SIGNAL_ENTRY, "entry", "momentum", "high", "low", "price");
+}
 
-        cout << "Order Opened for " << msg.order().instrument()->symbol() << " at time: " << msg.event_time() << endl;
+template <typename Policy>
+void StopLossHunterV2T<Policy>::UpdateBarSpecs()
+{
+    std::vector<BarSpec> specs;
+    ParseBarSpecs(bar_specs_, specs);
+    for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+        bar_aggregators_[slot].SetSpecs(specs);
+        bar_aggregators_[slot].SetRollingWindow(rolling_level_minutes_ * 60000000LL);
+    }
+}
 
-        if(msg.order().order_type() == ORDER_TYPE_MARKET){
-            state.market_order_id = msg.order_id();
-            cout << "Type: MARKET" << endl;
-            cout << "OrderID: [" << state.market_order_id << "]" << endl;
-        }else{
-            state.limit_order_id = msg.order_id();
-            cout << "Type: LIMIT" << endl;
-            cout << "OrderID: [" << state.limit_order_id << "]" << endl;
-        }
-        return;
+template <typename Policy>
+void StopLossHunterV2T<Policy>::UpdateLevelHorizons()
+{
+    std::vector<LevelHorizon> horizons;
+    ParseLevelHorizons(level_horizons_, horizons);
+    for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+        level_trackers_[slot].SetHorizons(horizons);
     }
+}
 
-    if(state.status == InstrumentState::HUNTING){
-        // We have sent entry orders
-        if (msg.update_type() == ORDER_UPDATE_TYPE_FILL || msg.update_type() == ORDER_UPDATE_TYPE_PARTIAL_FILL) {
-            // Market order fill
-            if (msg.order().order_id() == state.market_order_id) {
-                state.status = InstrumentState::IN_POSITION;
-                state.entry_price = msg.fill()->fill_price();
-                state.entry_time = msg.event_time();
-                
-                // Calculate and send limit order for profit target
-                double target_price = state.entry_price + 
-                    (state.position_side * target_ticks_ * msg.order().instrument()->min_tick_size());
-                
-                cout << "Entry filled for " << msg.order().instrument()->symbol() << " quantity: " << msg.fill()->fill_size()
-                    << " at price: " << state.entry_price 
-                    << " target: " << target_price << endl
-                    << " time: " << msg.update_time() << endl;
-
-                SendLimitOrder(msg.order().instrument(), 
-                            state.position_side < 0,  // Buy to cover if short
-                            abs(msg.fill()->fill_size()),
-                            target_price);
-            }
-            // Limit order fill
-            else if (msg.order().order_id() == state.limit_order_id) {
-                cout << "Target reached for " << msg.order().instrument()->symbol() 
-                    << " at price: " << msg.fill()->fill_price() 
-                    << "at time: " << msg.update_time() << endl
-                    << "Profit: " << (msg.fill()->fill_size() * abs(msg.fill()->fill_price() - state.entry_price)) << endl;
-
-                state.status = InstrumentState::NO_TRADE; // We will change this to IDLE when a new high/low is formed
-                state.position_side = 0;
-                state.entry_price = 0;
-                state.entry_time = boost::posix_time::not_a_date_time;
-                state.market_order_id = 0;
-                state.limit_order_id = 0;
-            }
-        }
-    }else if(state.status == InstrumentState::EXITING){
-        if(msg.update_type() == ORDER_UPDATE_TYPE_FILL || msg.update_type() == ORDER_UPDATE_TYPE_PARTIAL_FILL){
-            state.status = InstrumentState::NO_TRADE;
-            cout << "Closed Position for " << msg.order().instrument()->symbol() << " at time: " << msg.event_time() << endl
-                << "Current Status of the symbol: NO_TRADE" << endl
-                << "PNL: " << (msg.fill()->fill_size()) * (state.entry_price - msg.fill()->fill_price()) << endl;
-            state.position_side = 0;
-            state.entry_price = 0;
-            state.entry_time = boost::posix_time::not_a_date_time;
-            state.market_order_id = 0;
-            state.limit_order_id = 0;
+template <typename Policy>
+void StopLossHunterV2T<Policy>::ReconcilePositions()
+{
+    int mismatches = 0;
+    for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+        const Instrument* instrument = instrument_index_.instrument(slot);
+        int book_position = position_book_.position(slot);
+        int portfolio_position = portfolio().position(instrument);
+        if (!position_book_.Reconcile(slot, portfolio_position)) {
+            ++mismatches;
+            std::stringstream ss;
+            ss << "Position mismatch for " << instrument->symbol()
+               << " Book: " << book_position
+               << " Portfolio: " << portfolio_position;
+            logger().LogToClient(LOGLEVEL_WARNING, ss.str());
         }
-    } 
+    }
+
+    std::stringstream ss;
+    ss << "Position book:"
+       << " Realized PnL: " << position_book_.TotalRealizedPnl()
+       << " Unrealized PnL: " << position_book_.TotalUnrealizedPnl()
+       << " Mismatches: " << mismatches;
+    logger().LogToClient(LOGLEVEL_INFO, ss.str());
 }
 
-void StopLossHunterV2::OnTopQuote(const QuoteEventMsg& msg)
+template <typename Policy>
+void StopLossHunterV2T<Policy>::RecordOrderAction(int slot)
 {
-    // Not needed in V2
+    if (Policy::kInstrumentation) {
+        latency_.RecordOrderAction(slot);
+    }
 }
 
-void StopLossHunterV2::DefineStrategyCommands()
+template <typename Policy>
+void StopLossHunterV2T<Policy>::ReportLatencyStats(const std::string& reason)
 {
-    // No custom commands needed
+    if (!Policy::kInstrumentation) {
+        logger().LogToClient(LOGLEVEL_INFO, "Latency stats are only recorded by the diagnostic build");
+        return;
+    }
+
+    for (int handler = 0; handler < LATENCY_HANDLER_COUNT; ++handler) {
+        std::string summary = latency_.Summary(handler);
+        if (!summary.empty()) {
+            logger().LogToClient(LOGLEVEL_INFO, summary);
+        }
+    }
+
+    if (!latency_.Dump(latency_path_, instrument_index_, reason)) {
+        logger().LogToClient(LOGLEVEL_ERROR, "Could not write " + latency_path_);
+    }
 }
 
-void StopLossHunterV2::OnParamChanged(StrategyParam& param)
+template <typename Policy>
+void StopLossHunterV2T<Policy>::OnParamChanged(StrategyParam& param)
 {
    if (param.param_name() == "entry_range_ticks") {
        if (!param.Get(&entry_range_ticks_))
@@ -406,20 +729,76 @@ void StopLossHunterV2::OnParamChanged(StrategyParam& param)
    } else if (param.param_name() == "target_ticks") {
        if (!param.Get(&target_ticks_))
            throw StrategyStudioException("Could not get target_ticks");
+   } else if (param.param_name() == "max_loss_ticks") {
+       if (!param.Get(&max_loss_ticks_))
+           throw StrategyStudioException("Could not get max_loss_ticks");
    } else if (param.param_name() == "tick_lookback") {
        if (!param.Get(&tick_lookback_))
            throw StrategyStudioException("Could not get tick_lookback");
+       for (auto& state : instrument_states_) {
+           state.tick_momentum.SetLookback(tick_lookback_);
+       }
+   } else if (param.param_name() == "bar_specs") {
+       std::string bar_specs;
+       std::vector<BarSpec> specs;
+       if (!param.Get(&bar_specs))
+           throw StrategyStudioException("Could not get bar_specs");
+       if (!ParseBarSpecs(bar_specs, specs) || specs.empty())
+           throw StrategyStudioException("bar_specs must be a list like 1h,5000v,500t (s/m/h time, v volume, t trades)");
+       bar_specs_ = bar_specs;
+       UpdateBarSpecs();
+   } else if (param.param_name() == "rolling_level_minutes") {
+       if (!param.Get(&rolling_level_minutes_))
+           throw StrategyStudioException("Could not get rolling_level_minutes");
+       UpdateBarSpecs();
+   } else if (param.param_name() == "min_level_seconds") {
+       if (!param.Get(&min_level_seconds_))
+           throw StrategyStudioException("Could not get min_level_seconds");
+   } else if (param.param_name() == "level_horizons") {
+       std::string level_horizons;
+       std::vector<LevelHorizon> horizons;
+       if (!param.Get(&level_horizons))
+           throw StrategyStudioException("Could not get level_horizons");
+       if (!ParseLevelHorizons(level_horizons, horizons))
+           throw StrategyStudioException("level_horizons must be a list like 10000t,15m,60m (t trades, s/m/h time)");
+       level_horizons_ = level_horizons;
+       UpdateLevelHorizons();
    } else if (param.param_name() == "momentum_threshold") {
        if (!param.Get(&momentum_threshold_))
            throw StrategyStudioException("Could not get momentum_threshold");
    } else if (param.param_name() == "max_hold_seconds") {
        if (!param.Get(&max_hold_seconds_))
            throw StrategyStudioException("Could not get max_hold_seconds");
+       for (int slot = 0; slot < instrument_index_.size(); ++slot) {
+           if (hold_timers_.pending(slot)) ScheduleHoldTimer(slot);
+       }
+   } else if (param.param_name() == "hold_timer_ms") {
+       // Read when the strategy registers for events, which is when the hold timer event is set up
+       if (!param.Get(&hold_timer_ms_))
+           throw StrategyStudioException("Could not get hold_timer_ms");
    } else if (param.param_name() == "account_risk_per_trade") {
        if (!param.Get(&account_risk_per_trade_))
            throw StrategyStudioException("Could not get account_risk_per_trade");
+   } else if (param.param_name() == "latency_stats") {
+       if (!param.Get(&latency_stats_))
+           throw StrategyStudioException("Could not get latency_stats");
+       latency_.set_enabled(Policy::kInstrumentation && latency_stats_);
+   } else if (param.param_name() == "decision_journal") {
+       if (!param.Get(&decision_journal_))
+           throw StrategyStudioException("Could not get decision_journal");
+       if (decision_journal_) {
+           StartJournal();
+       } else {
+           journal_.Close();
+       }
    } else if (param.param_name() == "debug") {
        if (!param.Get(&debug_))
            throw StrategyStudioException("Could not get debug");
+       if (Policy::kDebugLog && debug_) {
+           log_.Start(log_path_);
+       }
    }
-} 
\ No newline at end of file
+} 
+
+// The variant this library is built as (see StrategyPolicy.h)
+template class StopLossHunterV2T<StrategyPolicy>;
@@ -18,11 +18,22 @@
 #include <Analytics/ScalarRollingWindow.h>
 #include <MarketModels/Instrument.h>
 #include <Utilities/ParseConfig.h>
+#include <AsyncLogger.h>
+#include <BarAggregator.h>
+#include <BracketOrder.h>
+#include <CacheAligned.h>
+#include <DecisionJournal.h>
+#include <EventTime.h>
+#include <InstrumentIndex.h>
+#include <LatencyRecorder.h>
+#include <LevelTracker.h>
+#include <PositionBook.h>
+#include <StrategyPolicy.h>
+#include <TickMomentum.h>
+#include <TickPrice.h>
+#include <TimerWheel.h>
 
 #include <algorithm>
-#include <unordered_map>
-#include <deque>
-#include <tuple>
 
 using namespace RCM::StrategyStudio;
 
@@ -32,46 +43,47 @@ struct InstrumentState {
         HUNTING,        // Near significant level, ready to enter
         IN_POSITION,    // Have an active position
         EXITING,        // Exit orders working
-        NO_TRADE       // Level breached, waiting for new hourly bar
+        NO_TRADE       // Level breached, waiting for the next level bar
     };
 
     InstrumentState() : 
         status(IDLE),
         hourly_high(0),
-        hourly_low(std::numeric_limits<double>::max()),
-        entry_price(0),
-        target_price(0),
+        hourly_low(std::numeric_limits<TickPrice>::max()),
         entry_time(boost::posix_time::not_a_date_time),
         last_bar_time(boost::posix_time::not_a_date_time),
-        last_tick_price(0),
-        position_side(0),
-        market_order_id(0),
-        limit_order_id(0) {}
+        last_tick(0) {}
 
     Status status;
-    double hourly_high;    // High from the last completed 1-hour bar
-    double hourly_low;     // Low from the last completed 1-hour bar
-    double entry_price;    // Market order fill price
-    double target_price;   // Limit order target price
+    TickPrice hourly_high;    // Rolling rolling_level_minutes high, else the last level bar's
+    TickPrice hourly_low;     // Rolling rolling_level_minutes low, else the last level bar's
     TimeType entry_time;   // Time of market order fill
-    TimeType last_bar_time;
-    double last_tick_price;
-    int position_side;
-    OrderID market_order_id;  // Track market order
-    OrderID limit_order_id;   // Track limit order
-    std::deque<int> tick_directions;
+    TimeType last_bar_time;   // Close of the last level bar
+    TickPrice last_tick;
+    Bracket bracket;          // Market entry, limit target and optional stop
+    TickMomentum tick_momentum;  // Up/down bits of the recent ticks, summed over tick_lookback_
 };
 
-class StopLossHunterV2 : public Strategy {
+// Policy is a StrategyPolicy.h policy: which debug and instrumentation code
+// is compiled in
+template <typename Policy>
+class StopLossHunterV2T : public Strategy {
+    friend class StopLossHunterV2Bench;   // Tools/Bench drives the private kernels directly
+
 public:
-    StopLossHunterV2(StrategyID strategyID, const std::string& strategyName, const std::string& groupName);
-    ~StopLossHunterV2();
+    enum JournalSignal {
+        JOURNAL_SIGNAL_ENTRY     // momentum, hourly high, hourly low, price
+    };
+
+    StopLossHunterV2T(StrategyID strategyID, const std::string& strategyName, const std::string& groupName);
+    ~StopLossHunterV2T();
 
 public: // Event handlers
     virtual void OnTrade(const TradeDataEventMsg& msg);
     virtual void OnTopQuote(const QuoteEventMsg& msg);
-    virtual void OnBar(const BarEventMsg& msg);
     virtual void OnOrderUpdate(const OrderUpdateEventMsg& msg);
+    virtual void OnScheduledEvent(const ScheduledEventMsg& msg);
+    virtual void OnStrategyCommand(const StrategyCommandEventMsg& msg);
     virtual void OnResetStrategyState();
     virtual void OnParamChanged(StrategyParam& param);
 
@@ -81,31 +93,63 @@ private: // Strategy setup
     virtual void DefineStrategyCommands();
 
 private: // Trading logic
-    bool IsNearSignificantLevel(const Instrument* instrument, double price, bool& is_near_high);
-    bool IsSafeToTrade(const Instrument* instrument);
-    void UpdateTickMomentum(const Instrument* instrument, double price);
-    int GetTickMomentumSignal(const Instrument* instrument);
-    void ProcessPotentialEntry(const Instrument* instrument, double price);
-    void CheckTimeBasedExit(const Instrument* instrument);
-    void SendMarketOrder(const Instrument* instrument, bool is_buy, int quantity);
-    void SendLimitOrder(const Instrument* instrument, bool is_buy, int quantity, double price);
-    void ExitPosition(const Instrument* instrument);
+    bool IsNearSignificantLevel(int slot, TickPrice price, bool& is_near_high);
+    bool IsSafeToTrade(const Instrument* instrument, int slot);
+    void UpdateTickMomentum(int slot, TickPrice price);
+    int GetTickMomentumSignal(int slot);
+    void ProcessPotentialEntry(const Instrument* instrument, int slot, TickPrice price);
+    void FireHoldTimers(TimeType now);
+    void ScheduleHoldTimer(int slot);
+    OrderID SendMarketOrder(const Instrument* instrument, int slot, bool is_buy, int quantity);
+    OrderID SendLimitOrder(const Instrument* instrument, int slot, bool is_buy, int quantity, double price);
+    void SendBracketSteps(const Instrument* instrument, int slot, const BracketStep* steps, int num_steps);
+    void UpdateBars(const Instrument* instrument, int slot, TimeType now, TickPrice price, double size);
+    void UpdateBarSpecs();
+    void SetStatus(int slot, InstrumentState::Status status);
+    void StartJournal();
+    void UpdateLevelHorizons();
+    void ReconcilePositions();
+    void RecordOrderAction(int slot);
+    void ReportLatencyStats(const std::string& reason);
+    void ExitPosition(const Instrument* instrument, int slot);
     void ManageExits(const Instrument* instrument);
 
 private: // Strategy parameters
     double entry_range_ticks_;     // Range around highs/lows to enter
     double target_ticks_;          // Profit target in ticks from entry price
+    double max_loss_ticks_;        // Stop loss in ticks from entry price, 0 for none
     int tick_lookback_;            // Number of ticks to look back (default 19)
+    std::string bar_specs_;        // Bars built from trades, e.g. "1h,500t"; the first is the level bar
+    int rolling_level_minutes_;    // Window of the rolling hourly high/low, 0 for level bars only
+    int min_level_seconds_;        // Event time the rolling window needs before it is a level
+    std::string level_horizons_;   // Rolling high/low horizons besides the hourly levels, e.g. "10000t,15m"
     int momentum_threshold_;       // Threshold for momentum signal
     int max_hold_seconds_;        // Maximum time to hold position (default 15)
+    int hold_timer_ms_;            // Interval of the scheduled event that fires hold timers, 0 for none
     double account_risk_per_trade_; // Risk per trade (0.1%)
+    bool latency_stats_;           // Record tick-to-order latency histograms
+    bool decision_journal_;        // Write the binary decision journal
     bool debug_;                   // Debug mode flag
 
 private: // Strategy state
-    std::unordered_map<const Instrument*, InstrumentState> instrument_states_;
-    TimeType current_strategy_time_;  // Track current time based on trade events
+    InstrumentIndex instrument_index_;
+    CacheAlignedVector<InstrumentState> instrument_states_;  // Indexed by instrument slot
+    CacheAlignedVector<TickScale> tick_scales_;    // From each instrument's min_tick_size()
+    CacheAlignedVector<BarAggregator> bar_aggregators_;  // bar_specs and the rolling hourly levels
+    CacheAlignedVector<LevelTracker> level_trackers_;  // level_horizons, empty by default
+    PositionBook position_book_;   // Our own fills; reconciled with portfolio() at day end
+    TimerWheel hold_timers_;       // max_hold_seconds deadline of each open position, by slot
+    std::string log_path_;
+    AsyncLogger log_;              // Debug output, formatted off the event thread
+    std::string latency_path_;
+    LatencyRecorder latency_;
+    std::string journal_path_;
+    DecisionJournal journal_;      // States, entry signals, orders and fills
 };
 
+// The variant selected by the build; the diagnostic .so defines STRATEGY_DIAGNOSTIC
+typedef StopLossHunterV2T<StrategyPolicy> StopLossHunterV2;
+
 extern "C" {
     _STRATEGY_EXPORTS const char* GetType() { return "StopLossHunterV2"; }
     _STRATEGY_EXPORTS const char* GetAuthor() { return "##"; }
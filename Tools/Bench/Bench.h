@@ -0,0 +1,210 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_TOOLS_BENCH_H_
+#define _STRATEGY_STUDIO_TOOLS_BENCH_H_
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Heap allocations made since start-up, counted by BenchAlloc.cpp
+uint64_t BenchAllocationCount();
+
+// Keeps the compiler from discarding a kernel result
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchResult {
+    BenchResult() :
+        window(0),
+        symbols(0),
+        ops(0),
+        ns_per_op(0),
+        allocs_per_op(0),
+        ops_per_sec(0) {}
+
+    std::string name;
+    int window;
+    int symbols;
+    uint64_t ops;
+    double ns_per_op;
+    double allocs_per_op;
+    double ops_per_sec;
+};
+
+// One synthetic market event. Prices follow a random walk in whole ticks per
+// symbol; sizes and aggressor sides are uniform.
+struct SyntheticTick {
+    int slot;
+    double price;
+    int64_t price_ticks;    // price in whole ticks
+    double size;
+    bool is_buy;
+    boost::posix_time::ptime time;
+};
+
+class SyntheticTickStream {
+public:
+    SyntheticTickStream(int symbols, double tick_size, uint64_t seed = 0x9E3779B97F4A7C15ULL) :
+        tick_size_(tick_size),
+        state_(seed),
+        time_(boost::gregorian::date(2024, 1, 2), boost::posix_time::hours(14) + boost::posix_time::minutes(30)),
+        prices_(symbols, llround(100.0 / tick_size)) {}
+
+    // Pre-generates n events round-robin across the symbols so generation
+    // stays out of the timed loop
+    std::vector<SyntheticTick> Generate(std::size_t n)
+    {
+        std::vector<SyntheticTick> ticks(n);
+        int symbols = static_cast<int>(prices_.size());
+        for (std::size_t i = 0; i < n; ++i) {
+            SyntheticTick& tick = ticks[i];
+            tick.slot = static_cast<int>(i % symbols);
+
+            int64_t& price_ticks = prices_[tick.slot];
+            price_ticks += static_cast<int>(Next() % 5) - 2;
+            if (price_ticks < 10) price_ticks = 10;
+
+            time_ += boost::posix_time::microseconds(1 + Next() % 500);
+            tick.price = price_ticks * tick_size_;
+            tick.price_ticks = price_ticks;
+            tick.size = static_cast<double>(1 + Next() % 500);
+            tick.is_buy = (Next() & 1) != 0;
+            tick.time = time_;
+        }
+        return ticks;
+    }
+
+private:
+    uint64_t Next()
+    {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    double tick_size_;
+    uint64_t state_;
+    boost::posix_time::ptime time_;
+    std::vector<int64_t> prices_;   // In ticks
+};
+
+// Runs op(i) for i in [0, ops) after a short warm-up and reports the cost.
+// Allocations are counted over the timed loop only.
+template <typename Op>
+BenchResult RunBench(const std::string& name, int window, int symbols, uint64_t ops, Op op)
+{
+    uint64_t warmup = ops / 10;
+    for (uint64_t i = 0; i < warmup; ++i) {
+        op(i);
+    }
+
+    uint64_t allocs_before = BenchAllocationCount();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < ops; ++i) {
+        op(i);
+    }
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+    uint64_t allocs = BenchAllocationCount() - allocs_before;
+
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+
+    BenchResult result;
+    result.name = name;
+    result.window = window;
+    result.symbols = symbols;
+    result.ops = ops;
+    result.ns_per_op = ns / ops;
+    result.allocs_per_op = static_cast<double>(allocs) / ops;
+    result.ops_per_sec = ns > 0 ? ops * 1e9 / ns : 0;
+    return result;
+}
+
+inline void PrintBenchHeader(bool csv)
+{
+    if (csv) {
+        printf("kernel,window,symbols,ops,ns_per_op,allocs_per_op,ops_per_sec\n");
+    } else {
+        printf("%-28s %8s %8s %10s %10s %12s %14s\n",
+               "kernel", "window", "symbols", "ops", "ns/op", "allocs/op", "ops/s");
+    }
+}
+
+inline void PrintBenchResult(const BenchResult& r, bool csv)
+{
+    if (csv) {
+        printf("%s,%d,%d,%llu,%.2f,%.4f,%.0f\n", r.name.c_str(), r.window, r.symbols,
+               static_cast<unsigned long long>(r.ops), r.ns_per_op, r.allocs_per_op, r.ops_per_sec);
+    } else {
+        printf("%-28s %8d %8d %10llu %10.2f %12.4f %14.0f\n", r.name.c_str(), r.window, r.symbols,
+               static_cast<unsigned long long>(r.ops), r.ns_per_op, r.allocs_per_op, r.ops_per_sec);
+    }
+    fflush(stdout);
+}
+
+// Command line shared by the bench binaries:
+//   --csv             machine-readable output
+//   --ops N           timed operations per case
+//   --windows a,b,c   window lengths to sweep
+//   --symbols a,b,c   symbol counts to sweep
+struct BenchOptions {
+    BenchOptions() : csv(false), ops(200000)
+    {
+        windows.push_back(20);
+        windows.push_back(100);
+        windows.push_back(1000);
+        symbols.push_back(1);
+        symbols.push_back(8);
+        symbols.push_back(64);
+    }
+
+    bool Parse(int argc, char** argv)
+    {
+        for (int i = 1; i < argc; ++i) {
+            if (strcmp(argv[i], "--csv") == 0) {
+                csv = true;
+            } else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+                ops = strtoull(argv[++i], nullptr, 10);
+            } else if (strcmp(argv[i], "--windows") == 0 && i + 1 < argc) {
+                windows = ParseList(argv[++i]);
+            } else if (strcmp(argv[i], "--symbols") == 0 && i + 1 < argc) {
+                symbols = ParseList(argv[++i]);
+            } else {
+                fprintf(stderr, "usage: %s [--csv] [--ops N] [--windows a,b,c] [--symbols a,b,c]\n", argv[0]);
+                return false;
+            }
+        }
+        return ops > 0 && !windows.empty() && !symbols.empty();
+    }
+
+    static std::vector<int> ParseList(const char* text)
+    {
+        std::vector<int> values;
+        while (*text != '\0') {
+            char* end;
+            long value = strtol(text, &end, 10);
+            if (end == text) break;
+            if (value > 0) values.push_back(static_cast<int>(value));
+            text = *end == ',' ? end + 1 : end;
+        }
+        return values;
+    }
+
+    bool csv;
+    uint64_t ops;
+    std::vector<int> windows;
+    std::vector<int> symbols;
+};
+
+#endif
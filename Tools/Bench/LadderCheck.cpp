@@ -0,0 +1,173 @@
+// Checks QuoteManager::PlanLadder on ladders shifted by their spacing while
+// one order is still waiting on its ack. An unacknowledged order can't move,
+// so it must hold a level rather than have a new order stacked on it:
+// after the planned messages no level may have two orders, every level must
+// have one, and the only order moved is the one whose price left the ladder
+// (none when that order is the pending one).
+//
+// Also sends a ladder shifted on every requote before any ack arrives, which
+// must never leave more live orders than levels.
+// Exits non-zero on the first failure.
+
+#include "../../Market Making Strategy/QuoteManager.h"
+
+#include <cstdio>
+
+namespace {
+
+const int kSize = 100;
+
+// Bid ladder of num_levels from top_ticks down, spacing apart
+void MakeLevels(TickPrice top_ticks, int spacing, int num_levels, LadderLevel* levels)
+{
+    for (int l = 0; l < num_levels; ++l) {
+        levels[l].price_ticks = top_ticks - l * spacing;
+        levels[l].price = 0;
+        levels[l].size = kSize;
+    }
+}
+
+// Records steps the way TradeImpactMM sends them; no acks
+void ApplySteps(QuoteManager& manager, QuoteLadder& ladder, const LadderLevel* levels, const LadderStep* steps,
+                int num_steps, OrderID& next_order_id)
+{
+    for (int i = 0; i < num_steps; ++i) {
+        const LadderStep& step = steps[i];
+        if (step.action == QUOTE_ACTION_NEW) {
+            const LadderLevel& level = levels[step.level];
+            manager.RecordNew(*ladder.FreeOrder(), next_order_id++, level.price_ticks, level.price, level.size);
+        } else if (step.action == QUOTE_ACTION_REPLACE) {
+            const LadderLevel& level = levels[step.level];
+            manager.RecordReplace(ladder.orders[step.order], level.price_ticks, level.price, level.size);
+        } else if (step.action == QUOTE_ACTION_CANCEL) {
+            manager.RecordCancel(ladder.orders[step.order]);
+        }
+    }
+}
+
+// Every level has exactly one order resting at or moving to it, and no order
+// not being cancelled is off the ladder
+bool CheckOneOrderPerLevel(const QuoteLadder& ladder, const LadderLevel* levels, int num_levels, const char* name)
+{
+    int per_level[QuoteLadder::kMaxLevels] = {};
+    for (int i = 0; i < QuoteLadder::kMaxOrders; ++i) {
+        const RestingQuote& quote = ladder.orders[i];
+        if (!quote.live() || quote.pending == RestingQuote::PENDING_CANCEL) continue;
+        int level = 0;
+        while (level < num_levels && levels[level].price_ticks != quote.target_ticks()) ++level;
+        // A pending order off the ladder holds a level until its ack
+        if (level == num_levels && quote.pending != RestingQuote::PENDING_NONE) continue;
+        if (level == num_levels) {
+            fprintf(stderr, "%s: order %d rests at %lld, off the ladder\n", name, i,
+                    static_cast<long long>(quote.target_ticks()));
+            return false;
+        }
+        ++per_level[level];
+    }
+
+    int live = 0;
+    for (int i = 0; i < QuoteLadder::kMaxOrders; ++i) {
+        live += ladder.orders[i].live() && ladder.orders[i].pending != RestingQuote::PENDING_CANCEL;
+    }
+    if (live != num_levels) {
+        fprintf(stderr, "%s: %d live orders for %d levels\n", name, live, num_levels);
+        return false;
+    }
+    for (int l = 0; l < num_levels; ++l) {
+        if (per_level[l] > 1) {
+            fprintf(stderr, "%s: level %d has %d orders\n", name, l, per_level[l]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Builds an acknowledged ladder, leaves order `pending` waiting on its open
+// ack and shifts the ladder by `shift` spacings (positive towards the touch)
+bool CheckShift(int num_levels, int spacing, int pending, int shift)
+{
+    char name[96];
+    snprintf(name, sizeof(name), "%d levels, order %d pending, shift %+d", num_levels, pending, shift);
+
+    QuoteManager manager;
+    QuoteLadder ladder;
+    LadderLevel levels[QuoteLadder::kMaxLevels];
+    LadderStep steps[QuoteManager::kMaxSteps];
+    OrderID next_order_id = 1;
+
+    TickPrice top = 1000;
+    MakeLevels(top, spacing, num_levels, levels);
+    int num_steps = manager.PlanLadder(ladder, levels, num_levels, steps);
+    ApplySteps(manager, ladder, levels, steps, num_steps, next_order_id);
+    for (int i = 0; i < QuoteLadder::kMaxOrders; ++i) {
+        if (ladder.orders[i].live()) QuoteManager::OnAcknowledged(ladder.orders[i]);
+    }
+
+    // Orders were dealt to slots in level order
+    ladder.orders[pending].pending = RestingQuote::PENDING_NEW;
+    int leaving = shift > 0 ? num_levels - 1 : 0;     // The order whose price leaves the ladder
+
+    MakeLevels(top + shift * spacing, spacing, num_levels, levels);
+    num_steps = manager.PlanLadder(ladder, levels, num_levels, steps);
+
+    int expected_steps = pending == leaving ? 0 : 1;
+    if (num_steps != expected_steps) {
+        fprintf(stderr, "%s: %d messages planned, expected %d\n", name, num_steps, expected_steps);
+        return false;
+    }
+    if (num_steps == 1 && (steps[0].action != QUOTE_ACTION_REPLACE || steps[0].order != leaving)) {
+        fprintf(stderr, "%s: planned action %d for order %d, expected a replace of order %d\n", name,
+                steps[0].action, steps[0].order, leaving);
+        return false;
+    }
+
+    ApplySteps(manager, ladder, levels, steps, num_steps, next_order_id);
+    return CheckOneOrderPerLevel(ladder, levels, num_levels, name);
+}
+
+// Moves the ladder a tick on every requote with no ack in between
+bool CheckUnackedRequotes(int num_levels, int rounds)
+{
+    QuoteManager manager;
+    QuoteLadder ladder;
+    LadderLevel levels[QuoteLadder::kMaxLevels];
+    LadderStep steps[QuoteManager::kMaxSteps];
+    OrderID next_order_id = 1;
+
+    for (int round = 0; round < rounds; ++round) {
+        MakeLevels(1000 + round, 1, num_levels, levels);
+        int num_steps = manager.PlanLadder(ladder, levels, num_levels, steps);
+        ApplySteps(manager, ladder, levels, steps, num_steps, next_order_id);
+
+        int live = 0;
+        for (int i = 0; i < QuoteLadder::kMaxOrders; ++i) live += ladder.orders[i].live();
+        if (live > num_levels) {
+            fprintf(stderr, "%d levels, round %d without acks: %d live orders\n", num_levels, round, live);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    int checks = 0;
+    const int level_counts[] = {2, 3, 5, QuoteLadder::kMaxLevels};
+    for (int c = 0; c < 4; ++c) {
+        int num_levels = level_counts[c];
+        for (int pending = 0; pending < num_levels; ++pending) {
+            for (int spacing = 1; spacing <= 2; ++spacing) {
+                if (!CheckShift(num_levels, spacing, pending, 1) || !CheckShift(num_levels, spacing, pending, -1)) {
+                    return 1;
+                }
+                checks += 2;
+            }
+        }
+        if (!CheckUnackedRequotes(num_levels, 20)) return 1;
+        ++checks;
+    }
+    printf("PlanLadder: %d shifted and unacknowledged ladders keep one order per level\n", checks);
+    return 0;
+}
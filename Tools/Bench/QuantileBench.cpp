@@ -0,0 +1,222 @@
+// Accuracy versus cost of the TradeImpactMM impact quantile modes. Replays a
+// stream of signed impacts through the exact windowed quantiles, P-square and
+// the decayed estimator, and scores the streaming modes against the exact
+// windowed quantile after every sample.
+//
+// Impacts come from --input: one number per line, or TradeImpactMM debug log
+// lines, whose "Impact: " value is used. Without --input a synthetic stream
+// with heavy tails and a drifting scale is generated.
+
+#include "../../Market Making Strategy/ImpactQuantiles.h"
+#include "../../Market Making Strategy/StreamingQuantile.h"
+#include "Bench.h"
+
+#include <RingBuffer.h>
+
+#include <algorithm>
+
+namespace {
+
+std::vector<double> LoadImpacts(const char* path)
+{
+    std::vector<double> impacts;
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return impacts;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        const char* text = strstr(line, "Impact: ");
+        text = text != nullptr ? text + 8 : line;
+        char* end;
+        double value = strtod(text, &end);
+        if (end != text) impacts.push_back(value);
+    }
+    fclose(file);
+    return impacts;
+}
+
+// Lognormal impact sizes with random signs; the log-scale drifts so a
+// window-free estimate is visibly stale
+std::vector<double> SyntheticImpacts(std::size_t n)
+{
+    std::vector<double> impacts(n);
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    auto next = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (state >> 11) * (1.0 / 9007199254740992.0);
+    };
+
+    double log_scale = -6;
+    for (std::size_t i = 0; i < n; ++i) {
+        double u1 = next() + 1e-12;
+        double u2 = next();
+        double normal = sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+        log_scale += 0.002 * (next() - 0.5);
+        double sign = next() < 0.5 ? 1.0 : -1.0;
+        impacts[i] = sign * exp(log_scale + 0.8 * normal);
+    }
+    return impacts;
+}
+
+struct QuantileScore {
+    QuantileScore() : ns_per_update(0), state_bytes(0), mean_rel_error(0), p95_rel_error(0) {}
+
+    double ns_per_update;
+    std::size_t state_bytes;
+    double mean_rel_error;
+    double p95_rel_error;
+};
+
+void PrintHeader(bool csv)
+{
+    if (csv) {
+        printf("mode,window,quantile,samples,ns_per_update,state_bytes,mean_rel_error,p95_rel_error\n");
+    } else {
+        printf("%-10s %8s %8s %10s %12s %12s %14s %14s\n",
+               "mode", "window", "quantile", "samples", "ns/update", "state_bytes", "mean_rel_err", "p95_rel_err");
+    }
+}
+
+void PrintScore(const char* mode, int window, double q, std::size_t samples, const QuantileScore& s, bool csv)
+{
+    if (csv) {
+        printf("%s,%d,%.3f,%zu,%.2f,%zu,%.5f,%.5f\n", mode, window, q, samples,
+               s.ns_per_update, s.state_bytes, s.mean_rel_error, s.p95_rel_error);
+    } else {
+        printf("%-10s %8d %8.3f %10zu %12.2f %12zu %14.5f %14.5f\n", mode, window, q, samples,
+               s.ns_per_update, s.state_bytes, s.mean_rel_error, s.p95_rel_error);
+    }
+    fflush(stdout);
+}
+
+// Exact windowed quantiles as TradeImpactMM keeps them: a ring of impacts and
+// an order-statistic tree per side. Returns the quantiles seen after every
+// sample (NaN while a side is empty).
+QuantileScore RunExact(const std::vector<double>& impacts, int window, double q,
+                       std::vector<double>& buy_exact, std::vector<double>& sell_exact)
+{
+    RingBuffer<double> ring(window);
+    ImpactQuantiles quantiles;
+    quantiles.Reserve(window);
+    buy_exact.assign(impacts.size(), NAN);
+    sell_exact.assign(impacts.size(), NAN);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < impacts.size(); ++i) {
+        if (ring.full() && !ring.empty()) {
+            quantiles.Remove(ring.front());
+        }
+        ring.push_back(impacts[i]);
+        quantiles.Add(impacts[i]);
+
+        if (!quantiles.buy().empty()) buy_exact[i] = ImpactQuantiles::Quantile(quantiles.buy(), q);
+        if (!quantiles.sell().empty()) sell_exact[i] = ImpactQuantiles::Quantile(quantiles.sell(), q);
+    }
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+    // Ring slots plus one treap node (value, priority, size, two children) per sample
+    std::size_t ring_slots = 1;
+    while (ring_slots < static_cast<std::size_t>(window)) ring_slots <<= 1;
+
+    QuantileScore score;
+    score.ns_per_update = std::chrono::duration<double, std::nano>(stop - start).count() / impacts.size();
+    score.state_bytes = ring_slots * sizeof(double) +
+                        (quantiles.buy().capacity() + quantiles.sell().capacity()) * 24;
+    return score;
+}
+
+QuantileScore RunStreaming(QuantileMode mode, const std::vector<double>& impacts, int window, double q,
+                           const std::vector<double>& buy_exact, const std::vector<double>& sell_exact)
+{
+    StreamingImpactQuantiles estimator;
+    estimator.Reset(mode, q, window);
+
+    std::vector<double> buy_estimate(impacts.size());
+    std::vector<double> sell_estimate(impacts.size());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < impacts.size(); ++i) {
+        estimator.Add(impacts[i]);
+        buy_estimate[i] = estimator.BuyQuantile();
+        sell_estimate[i] = estimator.SellQuantile();
+    }
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+    // Scored once the exact window has filled, on both sides
+    std::vector<double> errors;
+    errors.reserve(impacts.size() * 2);
+    for (std::size_t i = static_cast<std::size_t>(window); i < impacts.size(); ++i) {
+        if (buy_exact[i] > 0) errors.push_back(fabs(buy_estimate[i] - buy_exact[i]) / buy_exact[i]);
+        if (sell_exact[i] > 0) errors.push_back(fabs(sell_estimate[i] - sell_exact[i]) / sell_exact[i]);
+    }
+
+    QuantileScore score;
+    score.ns_per_update = std::chrono::duration<double, std::nano>(stop - start).count() / impacts.size();
+    score.state_bytes = sizeof(estimator);
+    if (!errors.empty()) {
+        double sum = 0;
+        for (std::size_t i = 0; i < errors.size(); ++i) sum += errors[i];
+        score.mean_rel_error = sum / errors.size();
+        std::size_t p95 = errors.size() * 95 / 100;
+        std::nth_element(errors.begin(), errors.begin() + p95, errors.end());
+        score.p95_rel_error = errors[p95];
+    }
+    return score;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    bool csv = false;
+    const char* input = nullptr;
+    std::size_t samples = 1000000;
+    double q = 0.1;
+    std::vector<int> windows;
+    windows.push_back(1000);
+    windows.push_back(10000);
+    windows.push_back(50000);
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input = argv[++i];
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--quantile") == 0 && i + 1 < argc) {
+            q = strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--windows") == 0 && i + 1 < argc) {
+            windows = BenchOptions::ParseList(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--csv] [--input file] [--samples N] [--quantile q] [--windows a,b,c]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<double> impacts = input != nullptr ? LoadImpacts(input) : SyntheticImpacts(samples);
+    if (impacts.empty()) {
+        if (input != nullptr) {
+            fprintf(stderr, "no impacts read from %s\n", input);
+        } else {
+            fprintf(stderr, "--samples must be positive\n");
+        }
+        return 1;
+    }
+
+    PrintHeader(csv);
+    for (std::size_t w = 0; w < windows.size(); ++w) {
+        int window = windows[w];
+        std::vector<double> buy_exact;
+        std::vector<double> sell_exact;
+
+        PrintScore("exact", window, q, impacts.size(), RunExact(impacts, window, q, buy_exact, sell_exact), csv);
+        PrintScore("p2", window, q, impacts.size(),
+                   RunStreaming(QUANTILE_MODE_P2, impacts, window, q, buy_exact, sell_exact), csv);
+        PrintScore("decayed", window, q, impacts.size(),
+                   RunStreaming(QUANTILE_MODE_DECAYED, impacts, window, q, buy_exact, sell_exact), csv);
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Checks the TradeImpactMM exact quantile mode against the sort-based rule it
+// replaced. Random impacts slide through a window as they do in OnTrade, with
+// occasional runtime window changes. After every trade the treap quantile of
+// each side must equal the max(0, n * q - 1)-th element of a sorted copy of
+// that side, and every few trades every rank of the treap is compared.
+//
+// Impacts are drawn from a coarse grid part of the time, so duplicate values,
+// zero impacts (sells) and erasing one of several equal values are exercised.
+// Exits non-zero on the first mismatch.
+
+#include "../../Market Making Strategy/ImpactQuantiles.h"
+#include "Bench.h"
+
+#include <algorithm>
+#include <deque>
+
+namespace {
+
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed) {}
+
+    uint64_t Next()
+    {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    double Uniform() { return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+    int Below(int n) { return static_cast<int>(Next() % static_cast<uint64_t>(n)); }
+
+private:
+    uint64_t state_;
+};
+
+double RandomImpact(Random& random)
+{
+    double sign = random.Uniform() < 0.5 ? 1.0 : -1.0;
+    int kind = random.Below(10);
+    if (kind == 0) return 0.0;
+    if (kind < 5) return sign * 0.0005 * (1 + random.Below(8));
+    return sign * exp(-6 + 2 * random.Uniform());
+}
+
+void SplitSides(const std::deque<double>& window, std::vector<double>& buys, std::vector<double>& sells)
+{
+    buys.clear();
+    sells.clear();
+    for (std::size_t i = 0; i < window.size(); ++i) {
+        if (window[i] > 0) {
+            buys.push_back(window[i]);
+        } else {
+            sells.push_back(std::fabs(window[i]));
+        }
+    }
+}
+
+// The k-th smallest of a copy of values, as the sort-based CalculateQuotes read it
+double NthElement(std::vector<double> values, std::size_t k)
+{
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+bool CheckSide(const char* side, const OrderStatisticTree& tree, const std::vector<double>& values,
+               const std::vector<double>& quantiles, bool all_ranks, int window, uint64_t step)
+{
+    if (tree.size() != values.size()) {
+        fprintf(stderr, "window %d step %llu: %s treap holds %zu values, the window %zu\n", window,
+                static_cast<unsigned long long>(step), side, tree.size(), values.size());
+        return false;
+    }
+    if (values.empty()) return true;
+
+    for (std::size_t i = 0; i < quantiles.size(); ++i) {
+        int idx = std::max(0, static_cast<int>(values.size() * quantiles[i]) - 1);
+        double expected = NthElement(values, idx);
+        double actual = ImpactQuantiles::Quantile(tree, quantiles[i]);
+        if (actual != expected) {
+            fprintf(stderr, "window %d step %llu: %s quantile %g is %.17g, sorting gives %.17g\n", window,
+                    static_cast<unsigned long long>(step), side, quantiles[i], actual, expected);
+            return false;
+        }
+    }
+
+    if (all_ranks) {
+        std::vector<double> sorted(values);
+        std::sort(sorted.begin(), sorted.end());
+        for (std::size_t k = 0; k < sorted.size(); ++k) {
+            if (tree.Kth(k) != sorted[k]) {
+                fprintf(stderr, "window %d step %llu: %s rank %zu is %.17g, sorting gives %.17g\n", window,
+                        static_cast<unsigned long long>(step), side, k, tree.Kth(k), sorted[k]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Slides impacts through a window of the given length the way OnTrade does,
+// changing the length now and then the way a rolling_window update does
+bool CheckWindow(int window, const std::vector<double>& quantiles, uint64_t steps, uint64_t seed)
+{
+    Random random(seed);
+    ImpactQuantiles tree;
+    tree.Reserve(window);
+    std::deque<double> impacts;
+    std::vector<double> buys;
+    std::vector<double> sells;
+    int current = window;
+
+    for (uint64_t step = 0; step < steps; ++step) {
+        if (random.Below(1000) == 0) {
+            current = std::max(1, window / 2 + random.Below(window + 1));
+        }
+        while (impacts.size() >= static_cast<std::size_t>(current)) {
+            tree.Remove(impacts.front());
+            impacts.pop_front();
+        }
+        double impact = RandomImpact(random);
+        impacts.push_back(impact);
+        tree.Add(impact);
+
+        SplitSides(impacts, buys, sells);
+        bool all_ranks = step % 97 == 0;
+        if (!CheckSide("buy", tree.buy(), buys, quantiles, all_ranks, window, step) ||
+            !CheckSide("sell", tree.sell(), sells, quantiles, all_ranks, window, step)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint64_t steps = 20000;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    std::vector<int> windows;
+    windows.push_back(1);
+    windows.push_back(2);
+    windows.push_back(20);
+    windows.push_back(100);
+    windows.push_back(1000);
+    std::vector<double> quantiles;
+    quantiles.push_back(0.01);
+    quantiles.push_back(0.1);
+    quantiles.push_back(0.25);
+    quantiles.push_back(0.5);
+    quantiles.push_back(0.9);
+    quantiles.push_back(1.0);
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            steps = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "--windows") == 0 && i + 1 < argc) {
+            windows = BenchOptions::ParseList(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--steps N] [--seed N] [--windows a,b,c]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (seed == 0 || windows.empty()) {
+        fprintf(stderr, "--seed must be non-zero and --windows non-empty\n");
+        return 1;
+    }
+
+    for (std::size_t w = 0; w < windows.size(); ++w) {
+        if (!CheckWindow(windows[w], quantiles, steps, seed + w)) return 1;
+        printf("window %6d: %llu trades, treap quantiles match the sorted window\n", windows[w],
+               static_cast<unsigned long long>(steps));
+    }
+    return 0;
+}
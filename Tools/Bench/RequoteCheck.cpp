@@ -0,0 +1,121 @@
+// Checks that RequoteScheduler never drops a dirty mark. A requote can
+// trigger order updates that mark slots dirty while Flush is still running;
+// each of those slots, the one being requoted included, must be requoted by
+// the next flush with a later timestamp and not by one in the same burst. A
+// slot held back by min_interval_us must stay dirty until it is due.
+// Exits non-zero on the first failure.
+
+#include "../../Market Making Strategy/RequoteScheduler.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int kSlots = 4;
+
+// Runs one flush, counting requotes per slot; the callback marks the slots
+// in marks[requoted slot] dirty, as a nested order update would
+void Flush(RequoteScheduler& scheduler, int64_t now_us, std::vector<int>& requotes,
+           const std::vector<std::vector<int> >& marks)
+{
+    scheduler.Flush(now_us, [&](int slot) {
+        ++requotes[slot];
+        for (std::size_t i = 0; i < marks[slot].size(); ++i) {
+            scheduler.MarkDirty(marks[slot][i], now_us);
+        }
+    });
+}
+
+bool Expect(const char* name, const std::vector<int>& requotes, const int* expected)
+{
+    for (int slot = 0; slot < kSlots; ++slot) {
+        if (requotes[slot] != expected[slot]) {
+            fprintf(stderr, "%s: slot %d requoted %d times, expected %d\n", name, slot, requotes[slot],
+                    expected[slot]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Requoting marked_by marks target dirty during the flush
+bool CheckMarkDuringFlush(int marked_by, int target)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "slot %d marked while requoting slot %d", target, marked_by);
+
+    RequoteScheduler scheduler;
+    scheduler.Reset(kSlots);
+    std::vector<int> requotes(kSlots, 0);
+    std::vector<std::vector<int> > marks(kSlots);
+    marks[marked_by].push_back(target);
+
+    scheduler.MarkDirty(marked_by, 1);
+    Flush(scheduler, 2, requotes, marks);
+    int after_first[kSlots] = {};
+    after_first[marked_by] = 1;
+    if (!Expect(name, requotes, after_first)) return false;
+
+    // Same burst: nothing more
+    marks[marked_by].clear();
+    Flush(scheduler, 2, requotes, marks);
+    if (!Expect(name, requotes, after_first)) return false;
+
+    Flush(scheduler, 3, requotes, marks);
+    int after_next[kSlots] = {};
+    after_next[marked_by] = 1;
+    ++after_next[target];
+    if (!Expect(name, requotes, after_next)) return false;
+
+    // Nothing is left dirty
+    Flush(scheduler, 4, requotes, marks);
+    return Expect(name, requotes, after_next);
+}
+
+// Slot 0 is held back by min_interval_us while slot 1, requoted in the same
+// flush, marks slot 2; both must survive the flush
+bool CheckHeldBackAndMarked()
+{
+    const char* name = "held back slot and slot marked in the same flush";
+    RequoteScheduler scheduler;
+    scheduler.Reset(kSlots);
+    scheduler.set_min_interval_us(10);
+    std::vector<int> requotes(kSlots, 0);
+    std::vector<std::vector<int> > marks(kSlots);
+
+    scheduler.MarkDirty(0, 1);
+    Flush(scheduler, 2, requotes, marks);          // Slot 0 requoted at 2
+    marks[1].push_back(2);
+    scheduler.MarkDirty(0, 3);
+    scheduler.MarkDirty(1, 3);
+    Flush(scheduler, 4, requotes, marks);          // Slot 0 not due until 12
+    int at_4[kSlots] = {1, 1, 0, 0};
+    if (!Expect(name, requotes, at_4)) return false;
+
+    marks[1].clear();
+    Flush(scheduler, 5, requotes, marks);
+    int at_5[kSlots] = {1, 1, 1, 0};
+    if (!Expect(name, requotes, at_5)) return false;
+
+    Flush(scheduler, 12, requotes, marks);
+    int at_12[kSlots] = {2, 1, 1, 0};
+    return Expect(name, requotes, at_12);
+}
+
+} // namespace
+
+int main()
+{
+    int checks = 0;
+    for (int marked_by = 0; marked_by < kSlots; ++marked_by) {
+        for (int target = 0; target < kSlots; ++target) {
+            if (!CheckMarkDuringFlush(marked_by, target)) return 1;
+            ++checks;
+        }
+    }
+    if (!CheckHeldBackAndMarked()) return 1;
+    ++checks;
+    printf("RequoteScheduler: %d cases, slots marked during a flush are requoted by the next one\n", checks);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Microbenchmarks for the StopLossHunter (v1) kernels, built against the
+// Strategy Studio stand-in so they run without a backtest server.
+
+#include "../../Stop Loss Liquidity Taking Strategy/v1/StopLossLiquidityTaking.cpp"
+#include "Bench.h"
+
+#include <memory>
+
+class StopLossHunterBench {
+public:
+    StopLossHunterBench(int window, int symbols, const std::string& level_horizons = std::string()) :
+        strategy_(1, "StopLossHunterBench", "Bench")
+    {
+        for (int i = 0; i < symbols; ++i) {
+            instruments_.push_back(std::unique_ptr<Instrument>(new Instrument("SYM" + std::to_string(i), 0.01)));
+            strategy_.AddInstrument(instruments_.back().get());
+        }
+
+        // The same window drives both the high/low lookback and the volatility period
+        strategy_.SetParam("debug", "false");
+        strategy_.SetParam("lookback_period", std::to_string(window));
+        strategy_.SetParam("volatility_period", std::to_string(window));
+        strategy_.SetParam("level_horizons", level_horizons);
+
+        StrategyEventRegister eventRegister;
+        strategy_.Initialize(&eventRegister, boost::gregorian::date(2024, 1, 2));
+    }
+
+    // Fills every instrument's price and volatility windows
+    void Prime(const std::vector<SyntheticTick>& ticks)
+    {
+        for (std::size_t i = 0; i < ticks.size(); ++i) {
+            UpdateHighLow(ticks[i]);
+            UpdateVolatility(ticks[i]);
+        }
+    }
+
+    void UpdateHighLow(const SyntheticTick& tick)
+    {
+        strategy_.UpdateHighLow(tick.slot, ToEpochMicros(tick.time), tick.price_ticks);
+    }
+
+    void UpdateVolatility(const SyntheticTick& tick)
+    {
+        strategy_.volatility_trackers_[tick.slot].OnPrice(tick.price);
+    }
+
+    double CalculateVolatility(const SyntheticTick& tick)
+    {
+        return strategy_.CalculateVolatility(tick.slot);
+    }
+
+    bool IsNearSignificantLevel(const SyntheticTick& tick)
+    {
+        bool is_near_high = false;
+        return strategy_.IsNearSignificantLevel(tick.slot, tick.price_ticks, is_near_high);
+    }
+
+    TickPrice last_high(int slot) const { return strategy_.instrument_states_[slot].last_high; }
+
+private:
+    std::vector<std::unique_ptr<Instrument>> instruments_;
+    StopLossHunter strategy_;
+};
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if (!options.Parse(argc, argv)) return 1;
+
+    PrintBenchHeader(options.csv);
+    for (std::size_t w = 0; w < options.windows.size(); ++w) {
+        for (std::size_t s = 0; s < options.symbols.size(); ++s) {
+            int window = options.windows[w];
+            int symbols = options.symbols[s];
+
+            StopLossHunterBench bench(window, symbols);
+            SyntheticTickStream stream(symbols, 0.01);
+            bench.Prime(stream.Generate(static_cast<std::size_t>(window) * symbols));
+
+            std::vector<SyntheticTick> ticks = stream.Generate(1 << 16);
+            std::size_t mask = ticks.size() - 1;
+
+            PrintBenchResult(RunBench("UpdateHighLow", window, symbols, options.ops,
+                [&](uint64_t i) {
+                    bench.UpdateHighLow(ticks[i & mask]);
+                    DoNotOptimize(bench.last_high(ticks[i & mask].slot));
+                }), options.csv);
+            PrintBenchResult(RunBench("UpdateVolatility", window, symbols, options.ops,
+                [&](uint64_t i) { bench.UpdateVolatility(ticks[i & mask]); }), options.csv);
+            PrintBenchResult(RunBench("CalculateVolatility", window, symbols, options.ops,
+                [&](uint64_t i) { DoNotOptimize(bench.CalculateVolatility(ticks[i & mask])); }), options.csv);
+
+            // The lookback window plus three time horizons in one tracker
+            StopLossHunterBench levels(window, symbols, "5m,15m,60m");
+            levels.Prime(stream.Generate(static_cast<std::size_t>(window) * symbols));
+            PrintBenchResult(RunBench("UpdateHighLow+3h", window, symbols, options.ops,
+                [&](uint64_t i) {
+                    levels.UpdateHighLow(ticks[i & mask]);
+                    DoNotOptimize(levels.last_high(ticks[i & mask].slot));
+                }), options.csv);
+            PrintBenchResult(RunBench("IsNearLevel+3h", window, symbols, options.ops,
+                [&](uint64_t i) { DoNotOptimize(levels.IsNearSignificantLevel(ticks[i & mask])); }), options.csv);
+        }
+    }
+    return 0;
+}
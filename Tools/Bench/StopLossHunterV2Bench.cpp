@@ -0,0 +1,94 @@
+// Microbenchmarks for the StopLossHunterV2 kernels, built against the
+// Strategy Studio stand-in so they run without a backtest server.
+
+#include "../../Stop Loss Liquidity Taking Strategy/v2/StopLossLiquidityTakingV2.cpp"
+#include "Bench.h"
+
+#include <memory>
+
+class StopLossHunterV2Bench {
+public:
+    StopLossHunterV2Bench(int window, int symbols) :
+        strategy_(1, "StopLossHunterV2Bench", "Bench")
+    {
+        for (int i = 0; i < symbols; ++i) {
+            instruments_.push_back(std::unique_ptr<Instrument>(new Instrument("SYM" + std::to_string(i), 0.01)));
+            strategy_.AddInstrument(instruments_.back().get());
+        }
+
+        strategy_.SetParam("debug", "false");
+        strategy_.SetParam("tick_lookback", std::to_string(window));
+
+        StrategyEventRegister eventRegister;
+        strategy_.Initialize(&eventRegister, boost::gregorian::date(2024, 1, 2));
+    }
+
+    // Fills every instrument's tick direction window
+    void Prime(const std::vector<SyntheticTick>& ticks)
+    {
+        for (std::size_t i = 0; i < ticks.size(); ++i) {
+            UpdateTickMomentum(ticks[i]);
+        }
+    }
+
+    void UpdateTickMomentum(const SyntheticTick& tick)
+    {
+        strategy_.UpdateTickMomentum(tick.slot, tick.price_ticks);
+    }
+
+    int GetTickMomentumSignal(const SyntheticTick& tick)
+    {
+        return strategy_.GetTickMomentumSignal(tick.slot);
+    }
+
+    // Default bar_specs and the rolling 60 minute levels
+    void UpdateBars(const SyntheticTick& tick)
+    {
+        strategy_.UpdateBars(instruments_[tick.slot].get(), tick.slot, tick.time, tick.price_ticks, tick.size);
+    }
+
+    // Event time advances 250us per call; every call (re)arms the slot's
+    // hold deadline, so the wheel holds one timer per symbol and fires or
+    // cascades a few of them on most calls
+    void HoldTimers(TimeType start, uint64_t i, const SyntheticTick& tick)
+    {
+        TimeType now = start + boost::posix_time::microseconds(static_cast<int64_t>(i) * 250);
+        strategy_.FireHoldTimers(now);
+        strategy_.hold_timers_.Schedule(tick.slot, ToEpochMicros(now) + 50000 + static_cast<int64_t>(i % 64) * 1000);
+    }
+
+private:
+    std::vector<std::unique_ptr<Instrument>> instruments_;
+    StopLossHunterV2 strategy_;
+};
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if (!options.Parse(argc, argv)) return 1;
+
+    PrintBenchHeader(options.csv);
+    for (std::size_t w = 0; w < options.windows.size(); ++w) {
+        for (std::size_t s = 0; s < options.symbols.size(); ++s) {
+            int window = options.windows[w];
+            int symbols = options.symbols[s];
+
+            StopLossHunterV2Bench bench(window, symbols);
+            SyntheticTickStream stream(symbols, 0.01);
+            bench.Prime(stream.Generate(static_cast<std::size_t>(window + 1) * symbols));
+
+            std::vector<SyntheticTick> ticks = stream.Generate(1 << 16);
+            std::size_t mask = ticks.size() - 1;
+
+            PrintBenchResult(RunBench("UpdateTickMomentum", window, symbols, options.ops,
+                [&](uint64_t i) { bench.UpdateTickMomentum(ticks[i & mask]); }), options.csv);
+            PrintBenchResult(RunBench("GetTickMomentumSignal", window, symbols, options.ops,
+                [&](uint64_t i) { DoNotOptimize(bench.GetTickMomentumSignal(ticks[i & mask])); }), options.csv);
+            PrintBenchResult(RunBench("UpdateBars", window, symbols, options.ops,
+                [&](uint64_t i) { bench.UpdateBars(ticks[i & mask]); }), options.csv);
+            PrintBenchResult(RunBench("HoldTimers", window, symbols, options.ops,
+                [&](uint64_t i) { bench.HoldTimers(ticks[0].time, i, ticks[i & mask]); }), options.csv);
+        }
+    }
+    return 0;
+}
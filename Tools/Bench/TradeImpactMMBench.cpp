@@ -0,0 +1,121 @@
+// Microbenchmarks for the TradeImpactMM kernels, built against the Strategy
+// Studio stand-in so they run without a backtest server.
+
+#include "../../Market Making Strategy/TradeImpactMM.cpp"
+#include "Bench.h"
+
+#include <memory>
+
+template <typename Policy>
+class TradeImpactMMBench {
+public:
+    TradeImpactMMBench(int window, int symbols, bool diagnostics = false) :
+        strategy_(1, "TradeImpactMMBench", "Bench")
+    {
+        for (int i = 0; i < symbols; ++i) {
+            instruments_.push_back(std::unique_ptr<Instrument>(new Instrument("SYM" + std::to_string(i), 0.01)));
+            Quote& quote = instruments_.back()->top_quote();
+            quote.bid_side().Set(99.99, 300);
+            quote.ask_side().Set(100.01, 300);
+            strategy_.AddInstrument(instruments_.back().get());
+        }
+
+        // Diagnostics on means debug logging and latency sampling, when the policy compiles them in
+        strategy_.SetParam("debug", diagnostics ? "true" : "false");
+        strategy_.SetParam("latency_stats", diagnostics ? "true" : "false");
+        strategy_.SetParam("rolling_window", std::to_string(window));
+
+        StrategyEventRegister eventRegister;
+        strategy_.Initialize(&eventRegister, boost::gregorian::date(2024, 1, 2));
+        remove("TradeImpactMMBench.log");
+    }
+
+    // No final latency dump into the working directory
+    ~TradeImpactMMBench() { strategy_.latency_stats_ = false; }
+
+    // Fills every instrument's impact window so quotes can be computed
+    void Prime(const std::vector<SyntheticTick>& ticks)
+    {
+        for (std::size_t i = 0; i < ticks.size(); ++i) {
+            OnTrade(ticks[i]);
+        }
+    }
+
+    double CalculateTradeImpact(const SyntheticTick& tick)
+    {
+        return strategy_.CalculateTradeImpact(tick.slot, tick.size, tick.is_buy);
+    }
+
+    std::pair<double, double> CalculateQuotes(const SyntheticTick& tick)
+    {
+        return strategy_.CalculateQuotes(instruments_[tick.slot].get(), tick.slot);
+    }
+
+    void OnTrade(const SyntheticTick& tick)
+    {
+        Trade trade(tick.price, static_cast<int>(tick.size), tick.is_buy ? TRADE_SIDE_BUY : TRADE_SIDE_SELL);
+        strategy_.OnTrade(TradeDataEventMsg(*instruments_[tick.slot], trade, tick.time));
+    }
+
+private:
+    std::vector<std::unique_ptr<Instrument>> instruments_;
+    TradeImpactMMT<Policy> strategy_;
+};
+
+// Per-event OnTrade cost of one build variant, with its runtime diagnostics on or off
+template <typename Policy>
+void RunVariant(const char* name, int window, int symbols, bool diagnostics, const BenchOptions& options)
+{
+    TradeImpactMMBench<Policy> bench(window, symbols, diagnostics);
+    SyntheticTickStream stream(symbols, 0.01);
+    bench.Prime(stream.Generate(static_cast<std::size_t>(window) * symbols));
+
+    std::vector<SyntheticTick> ticks = stream.Generate(1 << 16);
+    std::size_t mask = ticks.size() - 1;
+    PrintBenchResult(RunBench(name, window, symbols, options.ops,
+        [&](uint64_t i) { bench.OnTrade(ticks[i & mask]); }), options.csv);
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if (!options.Parse(argc, argv)) return 1;
+
+    PrintBenchHeader(options.csv);
+    for (std::size_t w = 0; w < options.windows.size(); ++w) {
+        for (std::size_t s = 0; s < options.symbols.size(); ++s) {
+            int window = options.windows[w];
+            int symbols = options.symbols[s];
+
+            TradeImpactMMBench<StrategyPolicy> bench(window, symbols);
+            SyntheticTickStream stream(symbols, 0.01);
+            bench.Prime(stream.Generate(static_cast<std::size_t>(window) * symbols));
+
+            std::vector<SyntheticTick> ticks = stream.Generate(1 << 16);
+            std::size_t mask = ticks.size() - 1;
+
+            PrintBenchResult(RunBench("CalculateTradeImpact", window, symbols, options.ops,
+                [&](uint64_t i) { DoNotOptimize(bench.CalculateTradeImpact(ticks[i & mask])); }), options.csv);
+            PrintBenchResult(RunBench("CalculateQuotes", window, symbols, options.ops,
+                [&](uint64_t i) { DoNotOptimize(bench.CalculateQuotes(ticks[i & mask]).first); }), options.csv);
+            PrintBenchResult(RunBench("OnTrade", window, symbols, options.ops,
+                [&](uint64_t i) { bench.OnTrade(ticks[i & mask]); }), options.csv);
+
+            // Cost of one enabled latency sample: handler scope plus record
+            LatencyRecorder recorder;
+            recorder.Reset(symbols);
+            recorder.set_enabled(true);
+            PrintBenchResult(RunBench("LatencySample", window, symbols, options.ops,
+                [&](uint64_t i) {
+                    LatencyRecorder::Scope scope(recorder, LATENCY_HANDLER_ON_TRADE);
+                    recorder.RecordOrderAction(ticks[i & mask].slot);
+                }), options.csv);
+
+            // Production and diagnostic builds side by side
+            RunVariant<ProductionPolicy>("OnTrade/production", window, symbols, false, options);
+            RunVariant<DiagnosticPolicy>("OnTrade/diagnostic", window, symbols, false, options);
+            RunVariant<DiagnosticPolicy>("OnTrade/diagnostic+on", window, symbols, true, options);
+        }
+    }
+    return 0;
+}
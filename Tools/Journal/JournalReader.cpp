@@ -0,0 +1,248 @@
+// Converts a DecisionJournal file (Common/DecisionJournal.h) for analysis:
+//   JournalReader <journal> [--output file.csv]   one CSV row per record
+//   JournalReader <journal> --columns <dir>       one raw array file per column
+//   JournalReader <journal> --labels              the state and signal names
+//
+// Column files are little-endian arrays of the type in their name
+// (time_us.i64, slot.u16, value0.f64, ...), e.g. for numpy.fromfile; the
+// directory also gets schema.csv, symbols.csv and labels.csv.
+
+#include <DecisionJournal.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Journal {
+    JournalHeader header;
+    std::vector<JournalRecord> records;
+};
+
+bool Load(const char* path, Journal& journal)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+
+    char block[JournalHeader::kSize];
+    bool ok = fread(block, 1, sizeof(block), file) == sizeof(block);
+    memcpy(&journal.header, block, sizeof(journal.header));
+    const JournalHeader& header = journal.header;
+    if (!ok || memcmp(header.magic, "SSJRNL1", 8) != 0 || header.version != JournalHeader::kVersion ||
+        header.record_size != sizeof(JournalRecord)) {
+        fprintf(stderr, "%s is not a version %u decision journal\n", path, JournalHeader::kVersion);
+        fclose(file);
+        return false;
+    }
+
+    // A journal whose writer did not close it is still mapped at full size;
+    // record_count is what was written
+    journal.records.resize(header.record_count);
+    std::size_t read = fread(journal.records.data(), sizeof(JournalRecord), journal.records.size(), file);
+    journal.records.resize(read);
+    fclose(file);
+    return true;
+}
+
+const JournalLabel* FindLabel(const JournalHeader& header, int type, int code)
+{
+    for (uint32_t i = 0; i < header.num_labels && i < JournalHeader::kMaxLabels; ++i) {
+        if (header.labels[i].type == type && header.labels[i].code == code) return &header.labels[i];
+    }
+    return nullptr;
+}
+
+const char* TypeName(int type)
+{
+    switch (type) {
+        case JOURNAL_STATE: return "STATE";
+        case JOURNAL_SIGNAL: return "SIGNAL";
+        case JOURNAL_ORDER: return "ORDER";
+        case JOURNAL_FILL: return "FILL";
+        default: return "UNKNOWN";
+    }
+}
+
+std::string RecordLabel(const JournalHeader& header, const JournalRecord& record)
+{
+    if (record.type == JOURNAL_ORDER) {
+        switch (record.code) {
+            case JOURNAL_ORDER_NEW: return "NEW";
+            case JOURNAL_ORDER_REPLACE: return "REPLACE";
+            case JOURNAL_ORDER_CANCEL: return "CANCEL";
+        }
+    }
+    const JournalLabel* label = FindLabel(header, record.type, record.code);
+    if (label != nullptr) return label->name;
+    return record.type == JOURNAL_FILL ? "" : std::to_string(record.code);
+}
+
+std::string Symbol(const JournalHeader& header, int slot)
+{
+    if (slot < static_cast<int>(header.num_symbols) && slot < JournalHeader::kMaxSymbols) {
+        return std::string(header.symbols[slot], strnlen(header.symbols[slot], JournalHeader::kMaxSymbol));
+    }
+    return std::to_string(slot);
+}
+
+// UTC, to the microsecond
+std::string FormatTime(int64_t time_us)
+{
+    time_t seconds = static_cast<time_t>(time_us / 1000000);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    char text[40];
+    size_t length = strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &utc);
+    snprintf(text + length, sizeof(text) - length, ".%06d", static_cast<int>(time_us % 1000000));
+    return text;
+}
+
+bool WriteCsv(const Journal& journal, const char* path)
+{
+    FILE* file = path != nullptr ? fopen(path, "w") : stdout;
+    if (file == nullptr) {
+        fprintf(stderr, "Could not write %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "time_us,time,type,symbol,label,code,order_id,quantity,value0,value1,value2,value3\n");
+    for (std::size_t i = 0; i < journal.records.size(); ++i) {
+        const JournalRecord& r = journal.records[i];
+        fprintf(file, "%" PRId64 ",%s,%s,%s,%s,%d,%" PRId64 ",%" PRId64 ",%.10g,%.10g,%.10g,%.10g\n",
+                r.event_time_us, FormatTime(r.event_time_us).c_str(), TypeName(r.type),
+                Symbol(journal.header, r.slot).c_str(), RecordLabel(journal.header, r).c_str(), r.code,
+                r.order_id, r.quantity, r.values[0], r.values[1], r.values[2], r.values[3]);
+    }
+    if (file != stdout) fclose(file);
+    return true;
+}
+
+template <typename T, typename Get>
+bool WriteColumn(const Journal& journal, const std::string& dir, const char* name, const char* type,
+                 FILE* schema, Get get)
+{
+    std::string path = dir + "/" + name + "." + type;
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+        return false;
+    }
+
+    std::vector<T> column(journal.records.size());
+    for (std::size_t i = 0; i < column.size(); ++i) {
+        column[i] = get(journal.records[i]);
+    }
+    fwrite(column.data(), sizeof(T), column.size(), file);
+    fclose(file);
+    fprintf(schema, "%s,%s,%zu\n", name, type, column.size());
+    return true;
+}
+
+bool WriteColumns(const Journal& journal, const std::string& dir)
+{
+    std::string schema_path = dir + "/schema.csv";
+    FILE* schema = fopen(schema_path.c_str(), "w");
+    if (schema == nullptr) {
+        fprintf(stderr, "Could not write %s\n", schema_path.c_str());
+        return false;
+    }
+
+    fprintf(schema, "column,type,rows\n");
+    bool ok =
+        WriteColumn<int64_t>(journal, dir, "time_us", "i64", schema, [](const JournalRecord& r) { return r.event_time_us; }) &&
+        WriteColumn<uint16_t>(journal, dir, "type", "u16", schema, [](const JournalRecord& r) { return r.type; }) &&
+        WriteColumn<uint16_t>(journal, dir, "slot", "u16", schema, [](const JournalRecord& r) { return r.slot; }) &&
+        WriteColumn<int32_t>(journal, dir, "code", "i32", schema, [](const JournalRecord& r) { return r.code; }) &&
+        WriteColumn<int64_t>(journal, dir, "order_id", "i64", schema, [](const JournalRecord& r) { return r.order_id; }) &&
+        WriteColumn<int64_t>(journal, dir, "quantity", "i64", schema, [](const JournalRecord& r) { return r.quantity; });
+    for (int v = 0; ok && v < JournalRecord::kMaxValues; ++v) {
+        std::string name = "value" + std::to_string(v);
+        ok = WriteColumn<double>(journal, dir, name.c_str(), "f64", schema, [v](const JournalRecord& r) { return r.values[v]; });
+    }
+    fclose(schema);
+    if (!ok) return false;
+
+    FILE* symbols = fopen((dir + "/symbols.csv").c_str(), "w");
+    FILE* labels = fopen((dir + "/labels.csv").c_str(), "w");
+    if (symbols == nullptr || labels == nullptr) {
+        fprintf(stderr, "Could not write %s/symbols.csv and labels.csv\n", dir.c_str());
+        if (symbols != nullptr) fclose(symbols);
+        if (labels != nullptr) fclose(labels);
+        return false;
+    }
+
+    const JournalHeader& header = journal.header;
+    fprintf(symbols, "slot,symbol\n");
+    for (uint32_t slot = 0; slot < header.num_symbols && slot < JournalHeader::kMaxSymbols; ++slot) {
+        fprintf(symbols, "%u,%s\n", slot, Symbol(header, slot).c_str());
+    }
+    fprintf(labels, "type,code,name,value0,value1,value2,value3\n");
+    for (uint32_t i = 0; i < header.num_labels && i < JournalHeader::kMaxLabels; ++i) {
+        const JournalLabel& label = header.labels[i];
+        fprintf(labels, "%s,%d,%s,%s,%s,%s,%s\n", TypeName(label.type), label.code, label.name,
+                label.value_names[0], label.value_names[1], label.value_names[2], label.value_names[3]);
+    }
+    fclose(symbols);
+    fclose(labels);
+    return true;
+}
+
+void PrintLabels(const Journal& journal)
+{
+    const JournalHeader& header = journal.header;
+    printf("%s: %zu records, %u symbols\n", header.strategy, journal.records.size(), header.num_symbols);
+    for (uint32_t i = 0; i < header.num_labels && i < JournalHeader::kMaxLabels; ++i) {
+        const JournalLabel& label = header.labels[i];
+        printf("%-6s %3d %-24s", TypeName(label.type), label.code, label.name);
+        for (int v = 0; v < JournalRecord::kMaxValues; ++v) {
+            if (label.value_names[v][0] != '\0') printf(" value%d=%s", v, label.value_names[v]);
+        }
+        printf("\n");
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const char* input = nullptr;
+    const char* output = nullptr;
+    const char* columns = nullptr;
+    bool labels = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc) {
+            columns = argv[++i];
+        } else if (strcmp(argv[i], "--labels") == 0) {
+            labels = true;
+        } else if (input == nullptr && argv[i][0] != '-') {
+            input = argv[i];
+        } else {
+            input = nullptr;
+            break;
+        }
+    }
+    if (input == nullptr) {
+        fprintf(stderr, "usage: %s <journal> [--output file.csv | --columns dir | --labels]\n", argv[0]);
+        return 1;
+    }
+
+    Journal journal;
+    if (!Load(input, journal)) return 1;
+
+    if (labels) {
+        PrintLabels(journal);
+        return 0;
+    }
+    if (columns != nullptr) return WriteColumns(journal, columns) ? 0 : 1;
+    return WriteCsv(journal, output) ? 0 : 1;
+}
@@ -0,0 +1,390 @@
+// Backtests one strategy over many parameter sets at once: every set is an
+// independent ReplaySession over the same memory-mapped tick file, run on a
+// work-stealing pool with one worker per core.
+//   ParamSweep --library <X>_replay.so --ticks <file> --name <sweep>
+//              [--grid name=v1,v2,... ...] [--sets <file>] [--param name=value ...]
+//              [--threads N] [--output-dir <dir>] [--summary <file>]
+//              [StrategyReplay's --type --symbols --start --end --cash --latency-us
+//               --commission --sell-fee-rate --pnl-interval]
+//
+// The runs are the product of the --grid values, crossed with the lines of
+// --sets when given; each line there is one set of name=value pairs separated
+// by spaces, with # starting a comment. --param values apply to every run.
+// Run i is named <sweep>_<i> and writes its own BACK_<sweep>_<i>_... reports to
+// the output directory; the summary table of all runs goes to --summary,
+// <output dir>/<sweep>_summary.csv by default, and sorted by PnL to stdout.
+
+#include "Replay.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::vector<std::pair<std::string, std::string> > ParamSet;
+
+struct SweepRun {
+    SweepRun() : ok(false) {}
+
+    std::string name;
+    ParamSet params;            // Swept values only
+    bool ok;
+    std::string error;
+    std::string prefix;
+    ReplaySummary summary;
+};
+
+void Usage(const char* program)
+{
+    fprintf(stderr,
+            "usage: %s --library <X>_replay.so --ticks <file> --name <sweep> [--grid name=v1,v2,... ...]\n"
+            "       [--sets <file>] [--param name=value ...] [--threads N] [--output-dir <dir>] [--summary <file>]\n"
+            "       [--type <strategy type>] [--symbols a,b] [--start YYYY-MM-DD] [--end YYYY-MM-DD] [--cash N]\n"
+            "       [--latency-us N] [--commission N] [--sell-fee-rate N] [--pnl-interval seconds]\n",
+            program);
+}
+
+std::vector<std::string> SplitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::size_t pos = 0;
+    while (pos <= list.size()) {
+        std::size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        if (end > pos) items.push_back(list.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return items;
+}
+
+bool SplitParam(const std::string& text, std::pair<std::string, std::string>* param)
+{
+    std::size_t equals = text.find('=');
+    if (equals == 0 || equals == std::string::npos) return false;
+    param->first = text.substr(0, equals);
+    param->second = text.substr(equals + 1);
+    return true;
+}
+
+bool ReadSets(const char* path, std::vector<ParamSet>* sets)
+{
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+
+    char buffer[4096];
+    int line_number = 0;
+    bool ok = true;
+    while (ok && fgets(buffer, sizeof(buffer), file) != nullptr) {
+        ++line_number;
+        char* comment = strchr(buffer, '#');
+        if (comment != nullptr) *comment = '\0';
+
+        ParamSet set;
+        for (char* token = strtok(buffer, " \t\r\n"); token != nullptr; token = strtok(nullptr, " \t\r\n")) {
+            std::pair<std::string, std::string> param;
+            if (!SplitParam(token, &param)) {
+                fprintf(stderr, "%s:%d: expected name=value, not %s\n", path, line_number, token);
+                ok = false;
+                break;
+            }
+            set.push_back(param);
+        }
+        if (!set.empty()) sets->push_back(set);
+    }
+    fclose(file);
+    return ok;
+}
+
+// Every combination of the grid values, the first axis varying slowest
+std::vector<ParamSet> ExpandGrid(const std::vector<std::pair<std::string, std::vector<std::string> > >& grid)
+{
+    std::vector<ParamSet> sets(1);
+    for (std::size_t axis = 0; axis < grid.size(); ++axis) {
+        std::vector<ParamSet> expanded;
+        for (std::size_t i = 0; i < sets.size(); ++i) {
+            for (std::size_t v = 0; v < grid[axis].second.size(); ++v) {
+                expanded.push_back(sets[i]);
+                expanded.back().push_back(std::make_pair(grid[axis].first, grid[axis].second[v]));
+            }
+        }
+        sets.swap(expanded);
+    }
+    return sets;
+}
+
+std::string CsvField(const std::string& value)
+{
+    if (value.find_first_of(",\"") == std::string::npos) return value;
+    std::string quoted = "\"";
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '"') quoted += '"';
+        quoted += value[i];
+    }
+    return quoted + "\"";
+}
+
+const std::string* FindParam(const ParamSet& params, const std::string& name)
+{
+    for (std::size_t i = 0; i < params.size(); ++i) {
+        if (params[i].first == name) return &params[i].second;
+    }
+    return nullptr;
+}
+
+bool WriteSummary(const std::string& path, const std::vector<SweepRun>& runs, const std::vector<std::string>& columns)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+        return false;
+    }
+
+    fprintf(file, "Run");
+    for (std::size_t c = 0; c < columns.size(); ++c) {
+        fprintf(file, ",%s", CsvField(columns[c]).c_str());
+    }
+    fprintf(file, ",PnL,MaxDrawdown,Trades,Shares,Orders,FillRatio,ExecutionCost,Events,Seconds,Reports,Error\n");
+
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        const SweepRun& run = runs[i];
+        const ReplaySummary& s = run.summary;
+        fprintf(file, "%s", run.name.c_str());
+        for (std::size_t c = 0; c < columns.size(); ++c) {
+            const std::string* value = FindParam(run.params, columns[c]);
+            fprintf(file, ",%s", value != nullptr ? CsvField(*value).c_str() : "");
+        }
+        if (run.ok) {
+            fprintf(file, ",%.2f,%.2f,%llu,%lld,%llu,%.4f,%.2f,%llu,%.3f,%s,\n", s.pnl, s.max_drawdown,
+                    static_cast<unsigned long long>(s.fills), static_cast<long long>(s.shares),
+                    static_cast<unsigned long long>(s.orders), s.fill_ratio(), s.execution_cost,
+                    static_cast<unsigned long long>(s.events), s.seconds, CsvField(run.prefix).c_str());
+        } else {
+            fprintf(file, ",,,,,,,,,,,%s\n", CsvField(run.error).c_str());
+        }
+    }
+
+    bool ok = fclose(file) == 0;
+    if (!ok) fprintf(stderr, "Could not write %s\n", path.c_str());
+    return ok;
+}
+
+std::string DescribeParams(const ParamSet& params)
+{
+    std::string text;
+    for (std::size_t i = 0; i < params.size(); ++i) {
+        if (i > 0) text += ' ';
+        text += params[i].first + "=" + params[i].second;
+    }
+    return text;
+}
+
+bool HigherPnL(const SweepRun* a, const SweepRun* b)
+{
+    if (a->ok != b->ok) return a->ok;
+    return a->summary.pnl > b->summary.pnl;
+}
+
+void PrintTable(const std::vector<SweepRun>& runs)
+{
+    std::vector<const SweepRun*> ranked;
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        ranked.push_back(&runs[i]);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), HigherPnL);
+
+    printf("%-20s %12s %12s %8s %10s  %s\n", "Run", "PnL", "MaxDrawdown", "Trades", "FillRatio", "Params");
+    for (std::size_t i = 0; i < ranked.size(); ++i) {
+        const SweepRun& run = *ranked[i];
+        if (run.ok) {
+            printf("%-20s %12.2f %12.2f %8llu %10.3f  %s\n", run.name.c_str(), run.summary.pnl, run.summary.max_drawdown,
+                   static_cast<unsigned long long>(run.summary.fills), run.summary.fill_ratio(),
+                   DescribeParams(run.params).c_str());
+        } else {
+            printf("%-20s %12s %12s %8s %10s  %s: %s\n", run.name.c_str(), "-", "-", "-", "-",
+                   DescribeParams(run.params).c_str(), run.error.c_str());
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string library_path;
+    std::string ticks_path;
+    std::string output_dir = ".";
+    std::string summary_path;
+    std::size_t threads = std::thread::hardware_concurrency();
+    std::vector<std::pair<std::string, std::vector<std::string> > > grid;
+    std::vector<ParamSet> sets;
+    bool have_sets = false;
+    ReplayOptions options;
+    options.quiet = true;           // Log lines from parallel runs would interleave
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            Usage(argv[0]);
+            return 1;
+        }
+        ++i;
+        if (strcmp(arg, "--library") == 0) {
+            library_path = value;
+        } else if (strcmp(arg, "--ticks") == 0) {
+            ticks_path = value;
+        } else if (strcmp(arg, "--name") == 0) {
+            options.name = value;
+        } else if (strcmp(arg, "--grid") == 0) {
+            std::pair<std::string, std::string> param;
+            if (!SplitParam(value, &param) || SplitList(param.second).empty()) {
+                fprintf(stderr, "--grid takes name=v1,v2,..., not %s\n", value);
+                return 1;
+            }
+            grid.push_back(std::make_pair(param.first, SplitList(param.second)));
+        } else if (strcmp(arg, "--sets") == 0) {
+            if (!ReadSets(value, &sets)) return 1;
+            have_sets = true;
+        } else if (strcmp(arg, "--param") == 0) {
+            std::pair<std::string, std::string> param;
+            if (!SplitParam(value, &param)) {
+                fprintf(stderr, "--param takes name=value, not %s\n", value);
+                return 1;
+            }
+            options.params.push_back(param);
+        } else if (strcmp(arg, "--threads") == 0) {
+            threads = static_cast<std::size_t>(atoi(value));
+        } else if (strcmp(arg, "--output-dir") == 0) {
+            output_dir = value;
+        } else if (strcmp(arg, "--summary") == 0) {
+            summary_path = value;
+        } else if (strcmp(arg, "--type") == 0) {
+            options.type = value;
+        } else if (strcmp(arg, "--symbols") == 0) {
+            options.symbols = SplitList(value);
+        } else if (strcmp(arg, "--start") == 0 || strcmp(arg, "--end") == 0) {
+            int64_t day_us;
+            if (!ParseDay(value, &day_us)) {
+                fprintf(stderr, "%s takes YYYY-MM-DD, not %s\n", arg, value);
+                return 1;
+            }
+            if (arg[2] == 's') {
+                options.start_us = day_us;
+            } else {
+                options.end_us = day_us + int64_t(86400) * 1000000;
+            }
+        } else if (strcmp(arg, "--cash") == 0) {
+            options.cash = atof(value);
+        } else if (strcmp(arg, "--latency-us") == 0) {
+            options.latency_us = atoll(value);
+        } else if (strcmp(arg, "--commission") == 0) {
+            options.commission_per_share = atof(value);
+        } else if (strcmp(arg, "--sell-fee-rate") == 0) {
+            options.sell_fee_rate = atof(value);
+        } else if (strcmp(arg, "--pnl-interval") == 0) {
+            options.pnl_interval_us = static_cast<int64_t>(atof(value) * 1000000);
+        } else {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (library_path.empty() || ticks_path.empty() || options.name.empty() || (grid.empty() && !have_sets) ||
+        options.latency_us < 0 || options.pnl_interval_us <= 0) {
+        Usage(argv[0]);
+        return 1;
+    }
+    if (have_sets && sets.empty()) {
+        fprintf(stderr, "No parameter sets in --sets\n");
+        return 1;
+    }
+    if (threads == 0) threads = 1;
+    if (summary_path.empty()) summary_path = output_dir + "/" + options.name + "_summary.csv";
+
+    // Each set from the file crossed with every grid point
+    std::vector<ParamSet> points = ExpandGrid(grid);
+    if (!have_sets) sets.push_back(ParamSet());
+    std::vector<SweepRun> runs;
+    std::vector<std::string> columns;
+    for (std::size_t s = 0; s < sets.size(); ++s) {
+        for (std::size_t p = 0; p < points.size(); ++p) {
+            SweepRun run;
+            run.params = sets[s];
+            run.params.insert(run.params.end(), points[p].begin(), points[p].end());
+            for (std::size_t i = 0; i < run.params.size(); ++i) {
+                if (std::find(columns.begin(), columns.end(), run.params[i].first) == columns.end()) {
+                    columns.push_back(run.params[i].first);
+                }
+            }
+            runs.push_back(run);
+        }
+    }
+    int width = static_cast<int>(std::to_string(runs.size() - 1).size());
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        char index[32];
+        snprintf(index, sizeof(index), "_%0*zu", width, i);
+        runs[i].name = options.name + index;
+    }
+
+    std::string error;
+    TickFile ticks;
+    StrategyLibrary library;
+    if (!ticks.Open(ticks_path, &error) || !library.Load(library_path, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    std::mutex progress_mutex;
+    std::size_t finished = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(std::min(threads, runs.size()));
+        for (std::size_t i = 0; i < runs.size(); ++i) {
+            SweepRun& run = runs[i];
+            pool.Submit([&run, &options, &ticks, &library, &output_dir, &progress_mutex, &finished, &runs] {
+                ReplayOptions run_options = options;
+                run_options.name = run.name;
+                // Swept values follow the --param ones, so they win
+                run_options.params.insert(run_options.params.end(), run.params.begin(), run.params.end());
+
+                ReplaySession session(ticks, library, run_options);
+                run.ok = session.Run(&run.error);
+                if (run.ok) {
+                    run.summary = session.summary();
+                    run.prefix = output_dir + "/" + BacktestPrefix(run.name, run.summary.first_us, run.summary.last_us);
+                    run.ok = session.WriteResults(run.prefix, &run.error);
+                }
+
+                std::lock_guard<std::mutex> lock(progress_mutex);
+                ++finished;
+                fprintf(stderr, "[%zu/%zu] %s %s\n", finished, runs.size(), run.name.c_str(),
+                        run.ok ? "done" : run.error.c_str());
+            });
+        }
+        pool.Wait();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    PrintTable(runs);
+    uint64_t events = 0;
+    std::size_t failed = 0;
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        events += runs[i].summary.events;
+        failed += !runs[i].ok;
+    }
+    printf("%zu runs on %zu threads in %.3f s (%.0f events/s)%s\n", runs.size(), std::min(threads, runs.size()), seconds,
+           seconds > 0 ? events / seconds : 0, failed > 0 ? ", some failed" : "");
+    if (!WriteSummary(summary_path, runs, columns)) return 1;
+    printf("Summary: %s\n", summary_path.c_str());
+    return failed > 0 ? 1 : 0;
+}
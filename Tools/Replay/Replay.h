@@ -0,0 +1,902 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_TOOLS_REPLAY_H_
+#define _STRATEGY_STUDIO_TOOLS_REPLAY_H_
+
+#include "TickData.h"
+
+#include <Strategy.h>
+#include <BarAggregator.h>
+#include <EventTime.h>
+#include <TickPrice.h>
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace RCM::StrategyStudio;
+using namespace RCM::StrategyStudio::MarketModels;
+
+// A strategy library built against Tools/StudioShim, loaded through the same
+// exports Strategy Studio uses. Strategies it creates must be deleted before
+// it is.
+class StrategyLibrary {
+public:
+    typedef IStrategy* (*CreateStrategyFn)(const char*, unsigned, const char*, const char*);
+    typedef const char* (*GetTypeFn)();
+
+    StrategyLibrary() : handle_(nullptr), create_(nullptr), get_type_(nullptr) {}
+    ~StrategyLibrary() { if (handle_ != nullptr) dlclose(handle_); }
+
+    bool Load(const std::string& path, std::string* error)
+    {
+        // dlopen searches the library path for a bare file name
+        std::string file = path.find('/') == std::string::npos ? "./" + path : path;
+        handle_ = dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle_ == nullptr) {
+            *error = dlerror();
+            return false;
+        }
+        create_ = reinterpret_cast<CreateStrategyFn>(dlsym(handle_, "CreateStrategy"));
+        get_type_ = reinterpret_cast<GetTypeFn>(dlsym(handle_, "GetType"));
+        if (create_ == nullptr || get_type_ == nullptr) {
+            *error = path + " does not export CreateStrategy and GetType";
+            return false;
+        }
+        return true;
+    }
+
+    const char* type() const { return get_type_(); }
+
+    // nullptr when the library has no strategy of that type
+    Strategy* Create(const std::string& type, unsigned id, const std::string& name, const std::string& group) const
+    {
+        return static_cast<Strategy*>(create_(type.c_str(), id, name.c_str(), group.c_str()));
+    }
+
+private:
+    StrategyLibrary(const StrategyLibrary&);
+    StrategyLibrary& operator=(const StrategyLibrary&);
+
+    void* handle_;
+    CreateStrategyFn create_;
+    GetTypeFn get_type_;
+};
+
+struct ReplayOptions {
+    ReplayOptions() :
+        start_us(0),
+        end_us(0),
+        cash(1000000),
+        latency_us(0),
+        commission_per_share(0.0012),
+        sell_fee_rate(0.0000224),
+        pnl_interval_us(60000000),
+        quiet(false),
+        account("SIM-REPLAY"),
+        trader("replay") {}
+
+    std::string type;                   // Empty for the library's own
+    std::string name;                   // Instance name, first column of the result files
+    std::vector<std::string> symbols;   // Empty for every symbol in the tick file
+    std::vector<std::pair<std::string, std::string> > params;
+    int64_t start_us;                   // Replay window [start_us, end_us), 0 for open
+    int64_t end_us;
+    double cash;                        // Starting cash balance
+    int64_t latency_us;                 // Order message to exchange and back
+    double commission_per_share;
+    double sell_fee_rate;               // Share of sell notional, as regulatory fees
+    int64_t pnl_interval_us;            // Spacing of _pnl.csv rows
+    bool quiet;                         // Drop the strategy's log lines
+    std::string account;
+    std::string trader;
+};
+
+struct ReplaySummary {
+    ReplaySummary() :
+        first_us(0),
+        last_us(0),
+        events(0),
+        orders(0),
+        filled_orders(0),
+        cancelled_orders(0),
+        rejected_orders(0),
+        fills(0),
+        shares(0),
+        pnl(0),
+        max_drawdown(0),
+        execution_cost(0),
+        seconds(0) {}
+
+    // Orders left FILLED or PARTIALLY_FILLED over all orders, as the analysis notebook counts them
+    double fill_ratio() const { return orders > 0 ? static_cast<double>(filled_orders) / orders : 0; }
+    double events_per_second() const { return seconds > 0 ? events / seconds : 0; }
+
+    int64_t first_us;       // First and last event replayed
+    int64_t last_us;
+    uint64_t events;
+    uint64_t orders;
+    uint64_t filled_orders;
+    uint64_t cancelled_orders;
+    uint64_t rejected_orders;
+    uint64_t fills;
+    int64_t shares;
+    double pnl;             // Net of execution cost, open positions marked to the last trade
+    double max_drawdown;    // Largest fall from a running high of the _pnl.csv series
+    double execution_cost;
+    double seconds;         // Wall time of the event loop
+};
+
+// Midnight UTC starting a YYYY-MM-DD day, in epoch microseconds
+inline bool ParseDay(const std::string& day, int64_t* time_us)
+{
+    try {
+        boost::gregorian::date date = boost::gregorian::from_simple_string(day);
+        if (date.is_special()) return false;
+        *time_us = ToEpochMicros(boost::posix_time::ptime(date));
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Strategy Studio's report name: BACK_<name>_<run time>_start_<first day>_end_<last day>
+inline std::string BacktestPrefix(const std::string& name, int64_t first_us, int64_t last_us)
+{
+    time_t now = time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    char run[32];
+    strftime(run, sizeof(run), "%Y-%m-%d_%H%M%S", &local);
+
+    boost::gregorian::date first = FromEpochMicros(first_us).date();
+    boost::gregorian::date last = FromEpochMicros(last_us).date();
+    char days[64];
+    snprintf(days, sizeof(days), "_start_%02d-%02d-%04d_end_%02d-%02d-%04d",
+             static_cast<int>(first.month()), static_cast<int>(first.day()), static_cast<int>(first.year()),
+             static_cast<int>(last.month()), static_cast<int>(last.day()), static_cast<int>(last.year()));
+    return "BACK_" + name + "_" + run + days;
+}
+
+// Hosts one strategy instance and replays a tick file through it in place of
+// StrategyServerBacktesting. Market events are delivered through the stand-in
+// event API (OnTrade, OnTopQuote, OnDepth, and OnBar for the bars the strategy
+// registers for, built from the trades) and the strategy's orders go to a
+// simulated exchange:
+//   - order messages arrive after latency_us, then get their OPEN ack
+//   - market orders fill in full at the opposite top quote, or the last trade
+//     with no quote; with neither they are rejected
+//   - a marketable limit fills in full at the opposite top quote
+//   - a resting limit fills at its price when a trade or the opposite quote
+//     crosses it, and up to the trade size when a trade prints at its price
+//   - a cancel/replace gives the order a new price and open quantity
+// Results are kept in memory and written by WriteResults in the layouts of
+// the Strategy Studio backtest reports under Analysis/Results.
+//
+// Sessions share nothing but the read-only tick file and library, so several
+// can run on different threads.
+class ReplaySession : public IStrategyHost {
+public:
+    ReplaySession(const TickFile& ticks, const StrategyLibrary& library, const ReplayOptions& options) :
+        ticks_(ticks),
+        library_(library),
+        options_(options),
+        strategy_(nullptr),
+        next_action_(0),
+        now_us_(0),
+        next_pnl_us_(0),
+        next_schedule_us_(kNever),
+        cash_(0),
+        costs_(0),
+        pnl_high_(0) {}
+
+    ~ReplaySession() { delete strategy_; }
+
+    // Creates the strategy, applies the params and replays the window
+    bool Run(std::string* error)
+    {
+        std::string type = options_.type.empty() ? library_.type() : options_.type;
+        strategy_ = library_.Create(type, 1, options_.name, "Replay");
+        if (strategy_ == nullptr) {
+            *error = "The library has no strategy type " + type;
+            return false;
+        }
+        strategy_->AttachHost(this);
+        strategy_->mutable_portfolio().set_cash_balance(options_.cash);
+        if (!AddInstruments(error)) return false;
+
+        const TickRecord* first = options_.start_us > 0 ? ticks_.LowerBound(options_.start_us) : ticks_.begin();
+        const TickRecord* last = options_.end_us > 0 ? ticks_.LowerBound(options_.end_us) : ticks_.end();
+        if (first >= last) {
+            *error = "No ticks in the replay window";
+            return false;
+        }
+
+        try {
+            for (std::size_t i = 0; i < options_.params.size(); ++i) {
+                strategy_->SetParam(options_.params[i].first, options_.params[i].second);
+            }
+            StrategyEventRegister eventRegister;
+            strategy_->Initialize(&eventRegister, FromEpochMicros(first->time_us).date());
+            Subscribe(eventRegister, first->time_us);
+
+            summary_.first_us = first->time_us;
+            next_pnl_us_ = first->time_us;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            Replay(first, last);
+            summary_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } catch (const std::exception& e) {
+            *error = e.what();
+            return false;
+        }
+
+        summary_.last_us = now_us_;
+        SamplePnl();
+        Summarize();
+        return true;
+    }
+
+    // Writes prefix_fill.csv, prefix_order.csv and prefix_pnl.csv
+    bool WriteResults(const std::string& prefix, std::string* error) const
+    {
+        std::string orders = "StrategyName,EntryTime,LastModTime,State,LastUpdateType,Symbol,Side,Type,TIF,Price,"
+                             "Quantity,DisplayQuantity,FilledQty,Remains,AvgFillPrice,ExecutionCost,Account,Trader,"
+                             "Broker,MarketCenter,OrderId,Tag,Reason,Closure\n";
+        for (std::size_t i = 0; i < orders_.size(); ++i) {
+            AppendOrderRow(orders_[i], orders);
+        }
+        return WriteFile(prefix + "_fill.csv",
+                         "StrategyName,TradeTime,Symbol,Quantity,Price,ExecutionCost,LiquidityAction,LiquidityCode,"
+                         "RawLiquidity,Account,Trader,MarketCenter,OrderID,ExecID,TransactionType\n" + fill_rows_, error) &&
+               WriteFile(prefix + "_order.csv", orders, error) &&
+               WriteFile(prefix + "_pnl.csv", "Name,Time,Cumulative PnL\n" + pnl_rows_, error);
+    }
+
+    const ReplaySummary& summary() const { return summary_; }
+
+public: // IStrategyHost; the exchange receives each message latency_us later
+    OrderID SendNewOrder(OrderParams& params)
+    {
+        int slot = FindSlot(params.instrument);
+        if (slot < 0) return 0;
+
+        OrderID order_id = orders_.size() + 1;
+        orders_.push_back(SimOrder(order_id, params, slot, now_us_));
+        orders_.back().price_ticks = instruments_[slot].scale.ToTicks(params.price);
+        Queue(PendingAction::NEW, order_id, 0, 0);
+        return order_id;
+    }
+
+    bool SendCancelOrder(OrderID order_id)
+    {
+        if (order_id == 0 || order_id > orders_.size()) return false;
+        Queue(PendingAction::CANCEL, order_id, 0, 0);
+        return true;
+    }
+
+    bool SendCancelReplaceOrder(OrderID order_id, int quantity, double price)
+    {
+        if (order_id == 0 || order_id > orders_.size()) return false;
+        Queue(PendingAction::REPLACE, order_id, quantity, price);
+        return true;
+    }
+
+    void LogToClient(LogLevel level, const std::string& message)
+    {
+        if (options_.quiet) return;
+        static const char* const kLevels[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+        fprintf(stderr, "%s %s [%s] %s\n", FormatTime(now_us_).c_str(), options_.name.c_str(),
+                kLevels[level >= LOGLEVEL_DEBUG && level <= LOGLEVEL_ERROR ? level : LOGLEVEL_ERROR], message.c_str());
+    }
+
+private:
+    static const int64_t kNever = std::numeric_limits<int64_t>::max();
+
+    struct ReplayInstrument {
+        ReplayInstrument() : subscribed(false), last_price(0), mark(0), position(0) {}
+
+        std::unique_ptr<Instrument> instrument;
+        TickScale scale;
+        bool subscribed;                        // Registered for market data
+        double last_price;
+        double mark;                            // Last trade, or the mid before one
+        int position;
+        BarAggregator bars;                     // One spec per bar registration
+        std::vector<BarSubscription> bar_subscriptions;
+        std::vector<std::size_t> resting;       // Working limit orders, index into orders_
+    };
+
+    // A recurring scheduled event registration
+    struct ReplaySchedule {
+        std::string name;
+        int64_t next_us;
+        int64_t end_us;
+        int64_t interval_us;
+    };
+
+    struct SimOrder {
+        SimOrder(OrderID order_id, const OrderParams& params, int slot, int64_t now_us) :
+            order(order_id, params),
+            slot(slot),
+            tif(params.tif),
+            price_ticks(0),
+            entry_us(now_us),
+            last_mod_us(now_us),
+            last_update(ORDER_UPDATE_TYPE_OPEN),
+            updated(false),
+            fill_notional(0),
+            cost(0) {}
+
+        Order order;
+        int slot;
+        OrderTIF tif;
+        TickPrice price_ticks;
+        int64_t entry_us;
+        int64_t last_mod_us;
+        OrderUpdateType last_update;
+        bool updated;               // Any update sent yet
+        double fill_notional;
+        double cost;
+    };
+
+    struct PendingAction {
+        enum Kind {
+            NEW,
+            CANCEL,
+            REPLACE
+        };
+
+        int64_t due_us;
+        Kind kind;
+        OrderID order_id;
+        int quantity;
+        double price;
+    };
+
+    bool AddInstruments(std::string* error)
+    {
+        slots_.assign(ticks_.num_symbols(), -1);
+        std::vector<bool> found(options_.symbols.size(), false);
+        for (int file_slot = 0; file_slot < ticks_.num_symbols(); ++file_slot) {
+            std::string symbol = ticks_.symbol(file_slot);
+            if (!options_.symbols.empty()) {
+                std::size_t i = 0;
+                while (i < options_.symbols.size() && options_.symbols[i] != symbol) ++i;
+                if (i == options_.symbols.size()) continue;
+                found[i] = true;
+            }
+            slots_[file_slot] = static_cast<int>(instruments_.size());
+            instruments_.push_back(ReplayInstrument());
+            ReplayInstrument& instrument = instruments_.back();
+            instrument.instrument.reset(new Instrument(symbol, ticks_.tick_size(file_slot)));
+            instrument.scale.set_tick_size(ticks_.tick_size(file_slot));
+        }
+        for (std::size_t i = 0; i < found.size(); ++i) {
+            if (!found[i]) {
+                *error = "The tick file has no symbol " + options_.symbols[i];
+                return false;
+            }
+        }
+        if (instruments_.empty()) {
+            *error = "The tick file has no symbols";
+            return false;
+        }
+        for (std::size_t slot = 0; slot < instruments_.size(); ++slot) {
+            strategy_->AddInstrument(instruments_[slot].instrument.get());
+        }
+        return true;
+    }
+
+    void Subscribe(const StrategyEventRegister& eventRegister, int64_t first_us)
+    {
+        // Scheduled events start with the first replayed event, on their own grid
+        for (std::size_t i = 0; i < eventRegister.scheduled_events().size(); ++i) {
+            const ScheduledEventSubscription& sub = eventRegister.scheduled_events()[i];
+            ReplaySchedule schedule;
+            schedule.name = sub.name;
+            schedule.next_us = ToEpochMicros(sub.start_time);
+            schedule.end_us = ToEpochMicros(sub.end_time);
+            schedule.interval_us = sub.interval.total_microseconds();
+            if (schedule.interval_us <= 0) continue;
+            if (schedule.next_us < first_us) {
+                schedule.next_us += (first_us - schedule.next_us + schedule.interval_us - 1) / schedule.interval_us *
+                                    schedule.interval_us;
+            }
+            if (schedule.next_us > schedule.end_us) continue;
+            schedules_.push_back(schedule);
+            next_schedule_us_ = std::min(next_schedule_us_, schedule.next_us);
+        }
+
+        for (std::size_t slot = 0; slot < instruments_.size(); ++slot) {
+            ReplayInstrument& instrument = instruments_[slot];
+            instrument.subscribed = eventRegister.market_data().count(instrument.instrument->symbol()) > 0;
+
+            std::vector<BarSpec> specs;
+            for (std::size_t i = 0; i < eventRegister.bars().size(); ++i) {
+                const BarSubscription& sub = eventRegister.bars()[i];
+                if (sub.symbol != instrument.instrument->symbol() || sub.interval <= 0 ||
+                    specs.size() == static_cast<std::size_t>(BarAggregator::kMaxSpecs)) continue;
+                switch (sub.type) {
+                    case BAR_TYPE_TIME: specs.push_back(BarSpec(BarSpec::TIME, sub.interval * int64_t(1000000))); break;
+                    case BAR_TYPE_TICK: specs.push_back(BarSpec(BarSpec::TICKS, sub.interval)); break;
+                    case BAR_TYPE_VOLUME: specs.push_back(BarSpec(BarSpec::VOLUME, sub.interval)); break;
+                }
+                instrument.bar_subscriptions.push_back(sub);
+            }
+            instrument.bars.SetSpecs(specs);
+        }
+    }
+
+    void Replay(const TickRecord* first, const TickRecord* last)
+    {
+        for (const TickRecord* tick = first; tick != last; ++tick) {
+            if (tick->slot >= slots_.size() || slots_[tick->slot] < 0) continue;
+            int slot = slots_[tick->slot];
+
+            if (next_schedule_us_ <= tick->time_us) FireSchedules(tick->time_us);
+            ProcessActions(tick->time_us);
+            now_us_ = tick->time_us;
+            if (now_us_ >= next_pnl_us_) SamplePnl();
+
+            switch (tick->type) {
+                case TICK_TRADE: OnTrade(slot, *tick); break;
+                case TICK_QUOTE: OnQuote(slot, *tick); break;
+                case TICK_DEPTH: OnDepth(slot, *tick); break;
+                default: continue;
+            }
+            ++summary_.events;
+
+            // Messages sent while handling this event, when there is no latency
+            ProcessActions(now_us_);
+        }
+    }
+
+    // Delivers the scheduled events due up to until_us, in time order with the
+    // order messages
+    void FireSchedules(int64_t until_us)
+    {
+        while (next_schedule_us_ <= until_us) {
+            int64_t time_us = next_schedule_us_;
+            ProcessActions(time_us);
+            now_us_ = time_us;
+            if (now_us_ >= next_pnl_us_) SamplePnl();
+
+            TimeType now = FromEpochMicros(now_us_);
+            next_schedule_us_ = kNever;
+            for (std::size_t i = 0; i < schedules_.size(); ++i) {
+                ReplaySchedule& schedule = schedules_[i];
+                if (schedule.next_us == time_us) {
+                    ScheduledEventMsg msg(schedule.name, now);
+                    strategy_->OnScheduledEvent(msg);
+                    schedule.next_us += schedule.interval_us;
+                    if (schedule.next_us > schedule.end_us) schedule.next_us = kNever;
+                }
+                next_schedule_us_ = std::min(next_schedule_us_, schedule.next_us);
+            }
+            ProcessActions(now_us_);
+        }
+    }
+
+    void OnTrade(int slot, const TickRecord& tick)
+    {
+        ReplayInstrument& instrument = instruments_[slot];
+        instrument.last_price = tick.price;
+        instrument.mark = tick.price;
+        TickPrice price_ticks = instrument.scale.ToTicks(tick.price);
+        MatchTrade(slot, price_ticks, tick.size);
+        if (!instrument.subscribed) return;
+
+        unsigned closed = instrument.bars.num_specs() > 0 ? instrument.bars.OnTrade(tick.time_us, price_ticks, tick.size) : 0;
+        TimeType now = FromEpochMicros(now_us_);
+        // A time bar closes before the trade that ends it; volume and tick bars include it
+        SendBars(slot, closed, BarSpec::TIME);
+
+        Trade trade(tick.price, tick.size, static_cast<TradeSide>(tick.side));
+        TradeDataEventMsg msg(*instrument.instrument, trade, now);
+        strategy_->OnTrade(msg);
+
+        SendBars(slot, closed, BarSpec::VOLUME);
+        SendBars(slot, closed, BarSpec::TICKS);
+    }
+
+    void OnQuote(int slot, const TickRecord& tick)
+    {
+        ReplayInstrument& instrument = instruments_[slot];
+        Quote& quote = instrument.instrument->top_quote();
+        quote.bid_side().Set(tick.price, tick.size);
+        quote.ask_side().Set(tick.price2, tick.size2);
+        OnTopChanged(slot);
+        if (!instrument.subscribed) return;
+
+        QuoteEventMsg msg(*instrument.instrument, FromEpochMicros(now_us_));
+        strategy_->OnTopQuote(msg);
+    }
+
+    // Sets or removes one book level; a change at level 0 is also a top quote
+    void OnDepth(int slot, const TickRecord& tick)
+    {
+        ReplayInstrument& instrument = instruments_[slot];
+        bool is_bid = tick.side == 1;
+        std::vector<IAggrPriceLevel>& levels = is_bid ? instrument.instrument->aggregate_order_book().bids() :
+                                                        instrument.instrument->aggregate_order_book().asks();
+        if (tick.size > 0) {
+            if (tick.level >= levels.size()) levels.resize(tick.level + 1);
+            levels[tick.level] = IAggrPriceLevel(tick.price, tick.size);
+        } else if (tick.level < levels.size()) {
+            levels.erase(levels.begin() + tick.level);
+        }
+
+        bool top = tick.level == 0;
+        if (top) {
+            QuoteSide& side = is_bid ? instrument.instrument->top_quote().bid_side() : instrument.instrument->top_quote().ask_side();
+            if (levels.empty()) {
+                side.Set(0, 0);
+            } else {
+                side.Set(levels[0].price(), levels[0].size());
+            }
+            OnTopChanged(slot);
+        }
+        if (!instrument.subscribed) return;
+
+        TimeType now = FromEpochMicros(now_us_);
+        MarketDepthEventMsg msg(*instrument.instrument, now);
+        strategy_->OnDepth(msg);
+        if (top) {
+            QuoteEventMsg quote_msg(*instrument.instrument, now);
+            strategy_->OnTopQuote(quote_msg);
+        }
+    }
+
+    void OnTopChanged(int slot)
+    {
+        ReplayInstrument& instrument = instruments_[slot];
+        const Quote& quote = instrument.instrument->top_quote();
+        if (instrument.last_price == 0 && quote.bid_side().IsValid() && quote.ask_side().IsValid()) {
+            instrument.mark = (quote.bid() + quote.ask()) / 2.0;
+        }
+        MatchQuote(slot);
+    }
+
+    void SendBars(int slot, unsigned closed, BarSpec::Kind kind)
+    {
+        ReplayInstrument& instrument = instruments_[slot];
+        for (int i = 0; closed != 0 && i < instrument.bars.num_specs(); ++i) {
+            if ((closed & (1u << i)) == 0 || instrument.bars.spec(i).kind != kind) continue;
+            const AggregatedBar& bar = instrument.bars.bar(i);
+            const BarSubscription& sub = instrument.bar_subscriptions[i];
+            Bar out(instrument.scale.ToPrice(bar.open), instrument.scale.ToPrice(bar.high),
+                    instrument.scale.ToPrice(bar.low), instrument.scale.ToPrice(bar.close), static_cast<int>(bar.volume));
+            int64_t time_us = kind == BarSpec::TIME ? bar.end_us : now_us_;
+            BarEventMsg msg(*instrument.instrument, out, sub.type, sub.interval, FromEpochMicros(time_us));
+            strategy_->OnBar(msg);
+        }
+    }
+
+    int FindSlot(const Instrument* instrument) const
+    {
+        for (std::size_t slot = 0; slot < instruments_.size(); ++slot) {
+            if (instruments_[slot].instrument.get() == instrument) return static_cast<int>(slot);
+        }
+        return -1;
+    }
+
+    void Queue(PendingAction::Kind kind, OrderID order_id, int quantity, double price)
+    {
+        PendingAction action = { now_us_ + options_.latency_us, kind, order_id, quantity, price };
+        actions_.push_back(action);
+    }
+
+    // Delivers the messages due by until_us, each at its own time. Latency is
+    // the same for every message, so the queue is in due order.
+    void ProcessActions(int64_t until_us)
+    {
+        while (next_action_ < actions_.size() && actions_[next_action_].due_us <= until_us) {
+            // Handling one can queue more
+            PendingAction action = actions_[next_action_++];
+            now_us_ = action.due_us;
+            SimOrder& order = orders_[action.order_id - 1];
+            switch (action.kind) {
+                case PendingAction::NEW: Arrive(order); break;
+                case PendingAction::CANCEL: Cancel(order); break;
+                case PendingAction::REPLACE: Replace(order, action.quantity, action.price); break;
+            }
+        }
+        if (next_action_ == actions_.size()) {
+            actions_.clear();
+            next_action_ = 0;
+        }
+    }
+
+    void Arrive(SimOrder& order)
+    {
+        ReplayInstrument& instrument = instruments_[order.slot];
+        bool is_market = order.order.order_type() == ORDER_TYPE_MARKET;
+        double market_price = is_market ? OppositeTop(order) : 0;
+        if (is_market && market_price <= 0) market_price = instrument.last_price;
+        if (order.order.size() <= 0 || (is_market ? market_price <= 0 : order.order.price() <= 0)) {
+            order.order.set_order_state(ORDER_STATE_REJECTED);
+            SendUpdate(order, ORDER_UPDATE_TYPE_REJECT, nullptr);
+            return;
+        }
+
+        order.order.set_order_state(ORDER_STATE_OPEN);
+        SendUpdate(order, ORDER_UPDATE_TYPE_OPEN, nullptr);
+        if (is_market) {
+            Fill(order, order.order.size_remaining(), market_price, false);
+        } else if (!FillMarketable(order)) {
+            instrument.resting.push_back(order.order.order_id() - 1);
+        }
+    }
+
+    void Cancel(SimOrder& order)
+    {
+        if (!IsWorking(order)) {
+            SendUpdate(order, ORDER_UPDATE_TYPE_CANCEL_REJECT, nullptr);
+            return;
+        }
+        RemoveResting(order);
+        order.order.set_order_state(ORDER_STATE_CANCELLED);
+        SendUpdate(order, ORDER_UPDATE_TYPE_CANCEL, nullptr);
+    }
+
+    // quantity is the new open quantity
+    void Replace(SimOrder& order, int quantity, double price)
+    {
+        if (!IsWorking(order) || quantity <= 0 || (order.order.order_type() == ORDER_TYPE_LIMIT && price <= 0)) {
+            SendUpdate(order, ORDER_UPDATE_TYPE_CANCEL_REJECT, nullptr);
+            return;
+        }
+        order.order.set_size(order.order.executed_size() + quantity);
+        order.order.set_price(price);
+        order.price_ticks = instruments_[order.slot].scale.ToTicks(price);
+        SendUpdate(order, ORDER_UPDATE_TYPE_MODIFY, nullptr);
+        if (FillMarketable(order)) RemoveResting(order);
+    }
+
+    // Fills a limit crossing the opposite top quote in full at the quote
+    bool FillMarketable(SimOrder& order)
+    {
+        double top = OppositeTop(order);
+        if (top <= 0) return false;
+        TickPrice top_ticks = instruments_[order.slot].scale.ToTicks(top);
+        if (order.order.IsBuy() ? top_ticks > order.price_ticks : top_ticks < order.price_ticks) return false;
+        Fill(order, order.order.size_remaining(), top, false);
+        return true;
+    }
+
+    void MatchTrade(int slot, TickPrice price_ticks, int size)
+    {
+        ReplayInstrument& instrument = instruments_[slot];
+        int at_price = size;
+        for (std::size_t i = 0; i < instrument.resting.size();) {
+            SimOrder& order = orders_[instrument.resting[i]];
+            int fill = 0;
+            if (order.order.IsBuy() ? price_ticks < order.price_ticks : price_ticks > order.price_ticks) {
+                fill = order.order.size_remaining();
+            } else if (price_ticks == order.price_ticks && at_price > 0) {
+                fill = std::min(order.order.size_remaining(), at_price);
+                at_price -= fill;
+            }
+            if (fill == 0) {
+                ++i;
+                continue;
+            }
+            if (fill == order.order.size_remaining()) {
+                instrument.resting[i] = instrument.resting.back();
+                instrument.resting.pop_back();
+            } else {
+                ++i;
+            }
+            Fill(order, fill, order.order.price(), true);
+        }
+    }
+
+    // Resting orders the opposite quote has moved through fill at their price
+    void MatchQuote(int slot)
+    {
+        ReplayInstrument& instrument = instruments_[slot];
+        for (std::size_t i = 0; i < instrument.resting.size();) {
+            SimOrder& order = orders_[instrument.resting[i]];
+            double top = OppositeTop(order);
+            TickPrice top_ticks = instrument.scale.ToTicks(top);
+            if (top <= 0 || (order.order.IsBuy() ? top_ticks > order.price_ticks : top_ticks < order.price_ticks)) {
+                ++i;
+                continue;
+            }
+            instrument.resting[i] = instrument.resting.back();
+            instrument.resting.pop_back();
+            Fill(order, order.order.size_remaining(), order.order.price(), true);
+        }
+    }
+
+    double OppositeTop(const SimOrder& order) const
+    {
+        const Quote& quote = instruments_[order.slot].instrument->top_quote();
+        const QuoteSide& side = order.order.IsBuy() ? quote.ask_side() : quote.bid_side();
+        return side.IsValid() ? side.price() : 0;
+    }
+
+    static bool IsWorking(const SimOrder& order)
+    {
+        return order.order.order_state() == ORDER_STATE_OPEN || order.order.order_state() == ORDER_STATE_PARTIALLY_FILLED;
+    }
+
+    void RemoveResting(const SimOrder& order)
+    {
+        std::vector<std::size_t>& resting = instruments_[order.slot].resting;
+        std::size_t index = order.order.order_id() - 1;
+        for (std::size_t i = 0; i < resting.size(); ++i) {
+            if (resting[i] == index) {
+                resting[i] = resting.back();
+                resting.pop_back();
+                return;
+            }
+        }
+    }
+
+    // Books the fill, then reports it; the portfolio is updated first, as
+    // Strategy Studio does
+    void Fill(SimOrder& order, int size, double price, bool added)
+    {
+        ReplayInstrument& instrument = instruments_[order.slot];
+        bool is_buy = order.order.IsBuy();
+        int signed_size = is_buy ? size : -size;
+        double cost = options_.commission_per_share * size + (is_buy ? 0 : options_.sell_fee_rate * size * price);
+
+        order.order.AddExecution(size);
+        order.fill_notional += size * price;
+        order.cost += cost;
+        order.order.set_order_state(order.order.size_remaining() > 0 ? ORDER_STATE_PARTIALLY_FILLED : ORDER_STATE_FILLED);
+
+        instrument.position += signed_size;
+        if (instrument.mark == 0) instrument.mark = price;
+        cash_ -= signed_size * price;
+        costs_ += cost;
+        ++summary_.fills;
+        summary_.shares += size;
+        strategy_->mutable_portfolio().ApplyFill(instrument.instrument.get(), signed_size, price);
+
+        char row[256];
+        snprintf(row, sizeof(row), ",%d,%.6f,%.6f,%s,0,,", signed_size, price, cost, added ? "ADDED" : "REMOVED");
+        fill_rows_ += options_.name;
+        fill_rows_ += ',';
+        fill_rows_ += FormatTime(now_us_);
+        fill_rows_ += ',';
+        fill_rows_ += instrument.instrument->symbol();
+        fill_rows_ += row;
+        snprintf(row, sizeof(row), ",IEX,%llu,,FILL\n", static_cast<unsigned long long>(order.order.order_id()));
+        fill_rows_ += options_.account + ',' + options_.trader + row;
+
+        FillInfo fill(price, signed_size);
+        SendUpdate(order, order.order.size_remaining() > 0 ? ORDER_UPDATE_TYPE_PARTIAL_FILL : ORDER_UPDATE_TYPE_FILL, &fill);
+    }
+
+    void SendUpdate(SimOrder& order, OrderUpdateType type, const FillInfo* fill)
+    {
+        order.last_update = type;
+        order.last_mod_us = now_us_;
+        order.updated = true;
+        OrderUpdateEventMsg msg(order.order, type, fill, FromEpochMicros(now_us_));
+        strategy_->OnOrderUpdate(msg);
+    }
+
+    // Cash plus open positions at their marks, net of execution cost
+    double Pnl() const
+    {
+        double pnl = cash_ - costs_;
+        for (std::size_t slot = 0; slot < instruments_.size(); ++slot) {
+            pnl += instruments_[slot].position * instruments_[slot].mark;
+        }
+        return pnl;
+    }
+
+    void SamplePnl()
+    {
+        double pnl = Pnl();
+        if (pnl_rows_.empty() || pnl > pnl_high_) pnl_high_ = pnl;
+        if (pnl_high_ - pnl > summary_.max_drawdown) summary_.max_drawdown = pnl_high_ - pnl;
+
+        char value[64];
+        snprintf(value, sizeof(value), ",%.6f\n", pnl);
+        pnl_rows_ += options_.name;
+        pnl_rows_ += ',';
+        pnl_rows_ += FormatTime(now_us_);
+        pnl_rows_ += value;
+        next_pnl_us_ = now_us_ + options_.pnl_interval_us;
+    }
+
+    void Summarize()
+    {
+        summary_.orders = orders_.size();
+        for (std::size_t i = 0; i < orders_.size(); ++i) {
+            OrderState state = orders_[i].order.order_state();
+            if (state == ORDER_STATE_FILLED || state == ORDER_STATE_PARTIALLY_FILLED) ++summary_.filled_orders;
+            if (state == ORDER_STATE_CANCELLED) ++summary_.cancelled_orders;
+            if (state == ORDER_STATE_REJECTED) ++summary_.rejected_orders;
+        }
+        summary_.pnl = Pnl();
+        summary_.execution_cost = costs_;
+    }
+
+    void AppendOrderRow(const SimOrder& sim, std::string& out) const
+    {
+        static const char* const kStates[] = {
+            "PENDING_OPEN", "OPEN", "PARTIALLY_FILLED", "FILLED", "PENDING_CANCEL", "CANCELLED", "REJECTED"
+        };
+        static const char* const kUpdates[] = {
+            "OPEN", "PARTIAL_FILL", "FILL", "CANCEL", "MODIFY", "REJECT", "CANCEL_REJECT"
+        };
+        static const char* const kTifs[] = { "DAY", "IOC", "GTC" };
+
+        const Order& order = sim.order;
+        int sign = order.IsBuy() ? 1 : -1;
+        int remains = IsWorking(sim) || order.order_state() == ORDER_STATE_PENDING_OPEN ||
+                      order.order_state() == ORDER_STATE_CANCELLED ? order.size_remaining() : 0;
+        double average = order.executed_size() > 0 ? sim.fill_notional / order.executed_size() : 0;
+
+        char row[512];
+        snprintf(row, sizeof(row), ",%s,%s,%s,%s,%s,%s,%s,%s,%.6f,%d,0,%d,%d,%.6f,%.6f,",
+                 FormatTime(sim.entry_us).c_str(), FormatTime(sim.last_mod_us).c_str(),
+                 kStates[order.order_state()], sim.updated ? kUpdates[sim.last_update] : "",
+                 instruments_[sim.slot].instrument->symbol().c_str(), order.IsBuy() ? "BUY" : "SELL",
+                 order.order_type() == ORDER_TYPE_MARKET ? "MARKET" : "LIMIT",
+                 kTifs[sim.tif],
+                 order.price(), sign * order.size(), sign * order.executed_size(), sign * remains, average, sim.cost);
+        out += options_.name;
+        out += row;
+        snprintf(row, sizeof(row), ",FILL_SIMULATOR,IEX,%llu,,,\n", static_cast<unsigned long long>(order.order_id()));
+        out += options_.account + ',' + options_.trader + row;
+    }
+
+    static std::string FormatTime(int64_t time_us)
+    {
+        return boost::posix_time::to_simple_string(FromEpochMicros(time_us));
+    }
+
+    static bool WriteFile(const std::string& path, const std::string& contents, std::string* error)
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        if (file == nullptr || fwrite(contents.data(), 1, contents.size(), file) != contents.size()) {
+            if (file != nullptr) fclose(file);
+            *error = "Could not write " + path;
+            return false;
+        }
+        fclose(file);
+        return true;
+    }
+
+    const TickFile& ticks_;
+    const StrategyLibrary& library_;
+    ReplayOptions options_;
+    Strategy* strategy_;
+
+    std::vector<ReplayInstrument> instruments_;
+    std::vector<int> slots_;                    // Tick file slot to instrument, -1 when not replayed
+    std::deque<SimOrder> orders_;               // By order ID - 1; a deque, so messages can hold references
+    std::vector<PendingAction> actions_;
+    std::size_t next_action_;
+
+    int64_t now_us_;                            // Time of the event or message being delivered
+    int64_t next_pnl_us_;
+    std::vector<ReplaySchedule> schedules_;
+    int64_t next_schedule_us_;                  // Earliest scheduled event due, kNever for none
+    double cash_;                               // Trading cash flow
+    double costs_;
+    double pnl_high_;
+    std::string fill_rows_;
+    std::string pnl_rows_;
+    ReplaySummary summary_;
+};
+
+#endif
@@ -0,0 +1,149 @@
+// Backtests a strategy without StrategyServerBacktesting: replays a tick file
+// (see TickConvert) through a strategy library built against the Strategy
+// Studio stand-in and writes the backtest reports.
+//   StrategyReplay --library <X>_replay.so --ticks <file> --name <instance>
+//                  [--type <strategy type>] [--symbols BA,MSFT] [--param name=value ...]
+//                  [--start YYYY-MM-DD] [--end YYYY-MM-DD] [--cash N] [--latency-us N]
+//                  [--commission N] [--sell-fee-rate N] [--pnl-interval seconds]
+//                  [--output-dir <dir>] [--quiet]
+//
+// --end is inclusive. The reports are BACK_<name>_..._fill.csv, _order.csv and
+// _pnl.csv in the output directory, as Strategy Studio names them.
+
+#include "Replay.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+void Usage(const char* program)
+{
+    fprintf(stderr,
+            "usage: %s --library <X>_replay.so --ticks <file> --name <instance> [--type <strategy type>]\n"
+            "       [--symbols a,b] [--param name=value ...] [--start YYYY-MM-DD] [--end YYYY-MM-DD]\n"
+            "       [--cash N] [--latency-us N] [--commission N] [--sell-fee-rate N]\n"
+            "       [--pnl-interval seconds] [--output-dir <dir>] [--quiet]\n",
+            program);
+}
+
+std::vector<std::string> SplitList(const char* text)
+{
+    std::vector<std::string> items;
+    std::string list(text);
+    std::size_t pos = 0;
+    while (pos <= list.size()) {
+        std::size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        if (end > pos) items.push_back(list.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return items;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string library_path;
+    std::string ticks_path;
+    std::string output_dir = ".";
+    ReplayOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+            continue;
+        }
+        if (value == nullptr) {
+            Usage(argv[0]);
+            return 1;
+        }
+        ++i;
+        if (strcmp(arg, "--library") == 0) {
+            library_path = value;
+        } else if (strcmp(arg, "--ticks") == 0) {
+            ticks_path = value;
+        } else if (strcmp(arg, "--name") == 0) {
+            options.name = value;
+        } else if (strcmp(arg, "--type") == 0) {
+            options.type = value;
+        } else if (strcmp(arg, "--symbols") == 0) {
+            options.symbols = SplitList(value);
+        } else if (strcmp(arg, "--param") == 0) {
+            const char* equals = strchr(value, '=');
+            if (equals == nullptr) {
+                fprintf(stderr, "--param takes name=value, not %s\n", value);
+                return 1;
+            }
+            options.params.push_back(std::make_pair(std::string(value, equals), std::string(equals + 1)));
+        } else if (strcmp(arg, "--start") == 0 || strcmp(arg, "--end") == 0) {
+            int64_t day_us;
+            if (!ParseDay(value, &day_us)) {
+                fprintf(stderr, "%s takes YYYY-MM-DD, not %s\n", arg, value);
+                return 1;
+            }
+            if (arg[2] == 's') {
+                options.start_us = day_us;
+            } else {
+                options.end_us = day_us + int64_t(86400) * 1000000;
+            }
+        } else if (strcmp(arg, "--cash") == 0) {
+            options.cash = atof(value);
+        } else if (strcmp(arg, "--latency-us") == 0) {
+            options.latency_us = atoll(value);
+        } else if (strcmp(arg, "--commission") == 0) {
+            options.commission_per_share = atof(value);
+        } else if (strcmp(arg, "--sell-fee-rate") == 0) {
+            options.sell_fee_rate = atof(value);
+        } else if (strcmp(arg, "--pnl-interval") == 0) {
+            options.pnl_interval_us = static_cast<int64_t>(atof(value) * 1000000);
+        } else if (strcmp(arg, "--output-dir") == 0) {
+            output_dir = value;
+        } else {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (library_path.empty() || ticks_path.empty() || options.name.empty() ||
+        options.latency_us < 0 || options.pnl_interval_us <= 0) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    std::string error;
+    TickFile ticks;
+    StrategyLibrary library;
+    if (!ticks.Open(ticks_path, &error) || !library.Load(library_path, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    ReplaySession session(ticks, library, options);
+    if (!session.Run(&error)) {
+        fprintf(stderr, "%s: %s\n", options.name.c_str(), error.c_str());
+        return 1;
+    }
+
+    const ReplaySummary& summary = session.summary();
+    std::string prefix = output_dir + "/" + BacktestPrefix(options.name, summary.first_us, summary.last_us);
+    if (!session.WriteResults(prefix, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    printf("%s: %llu events in %.3f s (%.0f events/s)\n", options.name.c_str(),
+           static_cast<unsigned long long>(summary.events), summary.seconds, summary.events_per_second());
+    printf("PnL %.2f, max drawdown %.2f, execution cost %.2f\n", summary.pnl, summary.max_drawdown, summary.execution_cost);
+    printf("%llu orders: %llu filled, %llu cancelled, %llu rejected (fill ratio %.3f); %llu fills, %lld shares\n",
+           static_cast<unsigned long long>(summary.orders), static_cast<unsigned long long>(summary.filled_orders),
+           static_cast<unsigned long long>(summary.cancelled_orders), static_cast<unsigned long long>(summary.rejected_orders),
+           summary.fill_ratio(), static_cast<unsigned long long>(summary.fills), static_cast<long long>(summary.shares));
+    printf("Reports: %s_{fill,order,pnl}.csv\n", prefix.c_str());
+    return 0;
+}
@@ -0,0 +1,290 @@
+// Builds a tick file for StrategyReplay (see TickData.h) from CSV ticks:
+//   TickConvert --output <file> [--tick-size SYMBOL=0.01 ...] [--default-tick-size 0.01] <csv> [<csv> ...]
+//
+// One event per line, time first; the time is "YYYY-MM-DD HH:MM:SS[.ffffff]"
+// (UTC) or integer microseconds since the Unix epoch:
+//   time,symbol,T,price,size[,side]             trade; side B, S or empty
+//   time,symbol,Q,bid,bid_size,ask,ask_size     top quote
+//   time,symbol,D,side,level,price,size         book level; side B or A, level 0 is
+//                                               the best, size 0 removes the level
+// Blank lines, lines starting with # and a header line starting with "time"
+// are skipped. Events from all inputs are merged by time, keeping the input
+// order for equal times.
+
+#include "TickData.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct ConvertState {
+    ConvertState() : default_tick_size(0.01) {}
+
+    std::map<std::string, double> tick_sizes;
+    double default_tick_size;
+    std::map<std::string, int> slots;
+    std::vector<std::string> symbols;
+    std::vector<TickRecord> records;
+};
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+int64_t DaysFromCivil(int64_t year, int64_t month, int64_t day)
+{
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t year_of_era = year - era * 400;
+    int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+bool ParseDigits(const char*& p, int count, int64_t* value)
+{
+    *value = 0;
+    for (int i = 0; i < count; ++i, ++p) {
+        if (*p < '0' || *p > '9') return false;
+        *value = *value * 10 + (*p - '0');
+    }
+    return true;
+}
+
+bool ParseTime(const std::string& text, int64_t* time_us)
+{
+    const char* p = text.c_str();
+    if (text.find('-') == std::string::npos) {
+        char* end;
+        *time_us = strtoll(p, &end, 10);
+        return end != p && *end == '\0';
+    }
+
+    int64_t year, month, day, hour, minute, second;
+    if (!ParseDigits(p, 4, &year) || *p++ != '-' || !ParseDigits(p, 2, &month) || *p++ != '-' ||
+        !ParseDigits(p, 2, &day) || (*p != ' ' && *p != 'T') || !ParseDigits(++p, 2, &hour) || *p++ != ':' ||
+        !ParseDigits(p, 2, &minute) || *p++ != ':' || !ParseDigits(p, 2, &second)) {
+        return false;
+    }
+    int64_t micros = 0;
+    if (*p == '.') {
+        int digits = 0;
+        for (++p; *p >= '0' && *p <= '9'; ++p, ++digits) {
+            if (digits < 6) micros = micros * 10 + (*p - '0');
+        }
+        for (; digits < 6; ++digits) micros *= 10;
+    }
+    if (*p != '\0') return false;
+    *time_us = ((DaysFromCivil(year, month, day) * 24 + hour) * 60 + minute) * 60000000 + second * 1000000 + micros;
+    return true;
+}
+
+std::vector<std::string> SplitFields(const std::string& line)
+{
+    std::vector<std::string> fields;
+    std::size_t pos = 0;
+    while (true) {
+        std::size_t end = line.find(',', pos);
+        if (end == std::string::npos) {
+            fields.push_back(line.substr(pos));
+            return fields;
+        }
+        fields.push_back(line.substr(pos, end - pos));
+        pos = end + 1;
+    }
+}
+
+bool ParseNumber(const std::string& text, double* value)
+{
+    char* end;
+    *value = strtod(text.c_str(), &end);
+    return end != text.c_str() && *end == '\0';
+}
+
+bool ParseInt(const std::string& text, int* value)
+{
+    char* end;
+    long parsed = strtol(text.c_str(), &end, 10);
+    *value = static_cast<int>(parsed);
+    return end != text.c_str() && *end == '\0' && parsed >= 0;
+}
+
+int SymbolSlot(ConvertState& state, const std::string& symbol)
+{
+    std::map<std::string, int>::const_iterator it = state.slots.find(symbol);
+    if (it != state.slots.end()) return it->second;
+    if (state.symbols.size() == static_cast<std::size_t>(TickFileHeader::kMaxSymbols) ||
+        symbol.empty() || symbol.size() >= static_cast<std::size_t>(TickSymbol::kMaxName)) {
+        return -1;
+    }
+    int slot = static_cast<int>(state.symbols.size());
+    state.slots[symbol] = slot;
+    state.symbols.push_back(symbol);
+    return slot;
+}
+
+bool ParseLine(ConvertState& state, const std::string& line, TickRecord& record)
+{
+    std::vector<std::string> fields = SplitFields(line);
+    if (fields.size() < 3 || fields[2].size() != 1) return false;
+
+    memset(&record, 0, sizeof(record));
+    int slot = SymbolSlot(state, fields[1]);
+    if (slot < 0 || !ParseTime(fields[0], &record.time_us)) return false;
+    record.slot = static_cast<uint16_t>(slot);
+
+    int level = 0;
+    switch (fields[2][0]) {
+        case 'T':
+            record.type = TICK_TRADE;
+            if (fields.size() < 5 || fields.size() > 6 || !ParseNumber(fields[3], &record.price) ||
+                !ParseInt(fields[4], &record.size)) {
+                return false;
+            }
+            if (fields.size() == 6 && !fields[5].empty()) {
+                if (fields[5][0] != 'B' && fields[5][0] != 'S') return false;
+                record.side = fields[5][0] == 'B' ? 1 : 2;      // TradeSide
+            }
+            return true;
+
+        case 'Q':
+            record.type = TICK_QUOTE;
+            return fields.size() == 7 && ParseNumber(fields[3], &record.price) && ParseInt(fields[4], &record.size) &&
+                   ParseNumber(fields[5], &record.price2) && ParseInt(fields[6], &record.size2);
+
+        case 'D':
+            record.type = TICK_DEPTH;
+            if (fields.size() != 7 || fields[3].empty() || (fields[3][0] != 'B' && fields[3][0] != 'A') ||
+                !ParseInt(fields[4], &level) || level > 0xFFFF || !ParseNumber(fields[5], &record.price) ||
+                !ParseInt(fields[6], &record.size)) {
+                return false;
+            }
+            record.side = fields[3][0] == 'B' ? 1 : 2;
+            record.level = static_cast<uint16_t>(level);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool ReadInput(ConvertState& state, const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    char buffer[4096];
+    uint64_t line_number = 0;
+    bool ok = true;
+    while (ok && fgets(buffer, sizeof(buffer), file) != nullptr) {
+        line.assign(buffer);
+        // Lines longer than the buffer arrive in pieces
+        while (!line.empty() && line[line.size() - 1] != '\n' && fgets(buffer, sizeof(buffer), file) != nullptr) {
+            line.append(buffer);
+        }
+        ++line_number;
+        while (!line.empty() && (line[line.size() - 1] == '\n' || line[line.size() - 1] == '\r')) {
+            line.erase(line.size() - 1);
+        }
+        if (line.empty() || line[0] == '#' || line.compare(0, 4, "time") == 0) continue;
+
+        TickRecord record;
+        if (!ParseLine(state, line, record)) {
+            fprintf(stderr, "%s:%llu: bad tick line: %s\n", path, static_cast<unsigned long long>(line_number), line.c_str());
+            ok = false;
+            break;
+        }
+        state.records.push_back(record);
+    }
+    fclose(file);
+    return ok;
+}
+
+bool EarlierTick(const TickRecord& a, const TickRecord& b) { return a.time_us < b.time_us; }
+
+bool WriteTickFile(const ConvertState& state, const char* path)
+{
+    char block[TickFileHeader::kSize];
+    memset(block, 0, sizeof(block));
+    TickFileHeader* header = reinterpret_cast<TickFileHeader*>(block);
+    memcpy(header->magic, "SSTICK1", 8);
+    header->version = TickFileHeader::kVersion;
+    header->record_size = sizeof(TickRecord);
+    header->record_count = state.records.size();
+    header->num_symbols = static_cast<uint32_t>(state.symbols.size());
+    for (std::size_t slot = 0; slot < state.symbols.size(); ++slot) {
+        const std::string& symbol = state.symbols[slot];
+        strncpy(header->symbols[slot].name, symbol.c_str(), TickSymbol::kMaxName - 1);
+        std::map<std::string, double>::const_iterator it = state.tick_sizes.find(symbol);
+        header->symbols[slot].tick_size = it != state.tick_sizes.end() ? it->second : state.default_tick_size;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        fprintf(stderr, "Could not write %s\n", path);
+        return false;
+    }
+    bool ok = fwrite(block, 1, sizeof(block), file) == sizeof(block) &&
+              fwrite(state.records.data(), sizeof(TickRecord), state.records.size(), file) == state.records.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok) fprintf(stderr, "Could not write %s\n", path);
+    return ok;
+}
+
+void Usage(const char* program)
+{
+    fprintf(stderr, "usage: %s --output <file> [--tick-size SYMBOL=0.01 ...] [--default-tick-size 0.01] <csv> [<csv> ...]\n",
+            program);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ConvertState state;
+    const char* output = nullptr;
+    std::vector<const char*> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--tick-size") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            const char* equals = strchr(value, '=');
+            double tick_size = equals != nullptr ? atof(equals + 1) : 0;
+            if (tick_size <= 0) {
+                fprintf(stderr, "--tick-size takes SYMBOL=size, not %s\n", value);
+                return 1;
+            }
+            state.tick_sizes[std::string(value, equals)] = tick_size;
+        } else if (strcmp(argv[i], "--default-tick-size") == 0 && i + 1 < argc) {
+            state.default_tick_size = atof(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            Usage(argv[0]);
+            return 1;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (output == nullptr || inputs.empty() || state.default_tick_size <= 0) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        if (!ReadInput(state, inputs[i])) return 1;
+    }
+    std::stable_sort(state.records.begin(), state.records.end(), EarlierTick);
+    if (!WriteTickFile(state, output)) return 1;
+
+    printf("%s: %llu events, %llu symbols\n", output, static_cast<unsigned long long>(state.records.size()),
+           static_cast<unsigned long long>(state.symbols.size()));
+    return 0;
+}
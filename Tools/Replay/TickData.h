@@ -0,0 +1,146 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_TOOLS_REPLAY_TICK_DATA_H_
+#define _STRATEGY_STUDIO_TOOLS_REPLAY_TICK_DATA_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+enum TickType {
+    TICK_TRADE = 1,     // price, size; side: TradeSide
+    TICK_QUOTE,         // price/size: bid, price2/size2: ask
+    TICK_DEPTH          // side: 1 bid, 2 ask; level: book level; size 0 removes the level
+};
+
+// One market event; the layout is the file format
+struct TickRecord {
+    int64_t time_us;        // Microseconds since the Unix epoch
+    double price;
+    double price2;
+    int32_t size;
+    int32_t size2;
+    uint16_t slot;          // Symbol, named in the header
+    uint8_t type;           // TickType
+    uint8_t side;
+    uint16_t level;         // Depth level, 0 is the best price
+    uint16_t reserved;
+};
+
+struct TickSymbol {
+    static const int kMaxName = 16;
+
+    char name[kMaxName];
+    double tick_size;
+};
+
+// First kSize bytes of the file; records follow, ordered by time
+struct TickFileHeader {
+    static const int kSize = 4096;
+    static const int kMaxSymbols = 128;
+    static const uint32_t kVersion = 1;
+
+    char magic[8];                  // "SSTICK1"
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t record_count;
+    uint32_t num_symbols;
+    uint32_t reserved;
+    TickSymbol symbols[kMaxSymbols];
+};
+
+static_assert(sizeof(TickRecord) == 40, "TickRecord is the file format");
+static_assert(sizeof(TickFileHeader) <= TickFileHeader::kSize, "TickFileHeader must fit its block");
+
+// A tick file mapped read-only. Nothing is written through it after Open, so
+// replays on several threads can share one TickFile and page the data in once.
+class TickFile {
+public:
+    TickFile() : map_(nullptr), map_size_(0), records_(nullptr), count_(0) {}
+    ~TickFile() { Close(); }
+
+    bool Open(const std::string& path, std::string* error)
+    {
+        Close();
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            *error = "Could not open " + path;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < static_cast<std::size_t>(TickFileHeader::kSize)) {
+            close(fd);
+            *error = path + " is not a tick file";
+            return false;
+        }
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            *error = "Could not map " + path;
+            return false;
+        }
+        map_ = map;
+        map_size_ = st.st_size;
+
+        const TickFileHeader& header = this->header();
+        if (memcmp(header.magic, "SSTICK1", 8) != 0 || header.version != TickFileHeader::kVersion ||
+            header.record_size != sizeof(TickRecord) || header.num_symbols > TickFileHeader::kMaxSymbols ||
+            TickFileHeader::kSize + header.record_count * sizeof(TickRecord) > map_size_) {
+            Close();
+            *error = path + " is not a version 1 tick file";
+            return false;
+        }
+        records_ = reinterpret_cast<const TickRecord*>(static_cast<const char*>(map_) + TickFileHeader::kSize);
+        count_ = header.record_count;
+        madvise(map_, map_size_, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void Close()
+    {
+        if (map_ != nullptr) munmap(map_, map_size_);
+        map_ = nullptr;
+        map_size_ = 0;
+        records_ = nullptr;
+        count_ = 0;
+    }
+
+    const TickFileHeader& header() const { return *static_cast<const TickFileHeader*>(map_); }
+    int num_symbols() const { return static_cast<int>(header().num_symbols); }
+    std::string symbol(int slot) const { return std::string(header().symbols[slot].name); }
+    double tick_size(int slot) const { return header().symbols[slot].tick_size; }
+
+    const TickRecord* begin() const { return records_; }
+    const TickRecord* end() const { return records_ + count_; }
+    uint64_t size() const { return count_; }
+
+    // First record at or after time_us
+    const TickRecord* LowerBound(int64_t time_us) const
+    {
+        const TickRecord* first = records_;
+        uint64_t count = count_;
+        while (count > 0) {
+            uint64_t step = count / 2;
+            if (first[step].time_us < time_us) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        return first;
+    }
+
+private:
+    void* map_;
+    std::size_t map_size_;
+    const TickRecord* records_;
+    uint64_t count_;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#pragma once
+
+#ifndef _STRATEGY_STUDIO_TOOLS_REPLAY_WORK_STEALING_POOL_H_
+#define _STRATEGY_STUDIO_TOOLS_REPLAY_WORK_STEALING_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool for coarse, uneven tasks such as whole replays. Each worker has
+// its own queue: it takes its newest task first and, when its queue is empty,
+// steals the oldest task of another worker, so a worker stuck behind one long
+// replay doesn't hold up the short ones dealt to it. Tasks are seconds long,
+// so a mutex per queue costs nothing measurable.
+class WorkStealingPool {
+public:
+    typedef std::function<void()> Task;
+
+    explicit WorkStealingPool(std::size_t num_threads) :
+        queues_(num_threads > 0 ? num_threads : 1),
+        next_queue_(0),
+        queued_(0),
+        pending_(0),
+        stopping_(false)
+    {
+        for (std::size_t i = 0; i < queues_.size(); ++i) {
+            queues_[i].reset(new WorkerQueue());
+        }
+        for (std::size_t i = 0; i < queues_.size(); ++i) {
+            workers_.push_back(std::thread(&WorkStealingPool::Work, this, i));
+        }
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (std::size_t i = 0; i < workers_.size(); ++i) {
+            workers_[i].join();
+        }
+    }
+
+    // Deals tasks to the workers' queues in turn, from one thread. Tasks must not throw.
+    void Submit(const Task& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++queued_;
+            ++pending_;
+        }
+        WorkerQueue& queue = *queues_[next_queue_++ % queues_.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(task);
+        }
+        wake_.notify_one();
+    }
+
+    // Blocks until every submitted task has finished
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    std::size_t num_threads() const { return workers_.size(); }
+
+private:
+    WorkStealingPool(const WorkStealingPool&);
+    WorkStealingPool& operator=(const WorkStealingPool&);
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool TakeOwn(std::size_t index, Task& task)
+    {
+        WorkerQueue& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return false;
+        task.swap(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool Steal(std::size_t thief, Task& task)
+    {
+        for (std::size_t i = 1; i < queues_.size(); ++i) {
+            WorkerQueue& queue = *queues_[(thief + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            task.swap(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void Work(std::size_t index)
+    {
+        Task task;
+        while (true) {
+            if (TakeOwn(index, task) || Steal(index, task)) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    --queued_;
+                }
+                task();
+                task = nullptr;
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--pending_ == 0) idle_.notify_all();
+                continue;
+            }
+
+            // Submit counts a task just before queueing it, so a worker that
+            // wakes for a count may spin until the task lands, never miss it
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+            if (stopping_) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkerQueue> > queues_;
+    std::vector<std::thread> workers_;
+    std::size_t next_queue_;
+
+    std::mutex mutex_;              // Guards the counts below
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::size_t queued_;            // Submitted and not yet taken by a worker
+    std::size_t pending_;           // Submitted and not yet finished
+    bool stopping_;
+};
+
+#endif
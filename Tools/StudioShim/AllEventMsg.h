@@ -0,0 +1,161 @@
+/*================================================================================
+*     Stand-in for the Strategy Studio SDK: event messages delivered to
+*     strategies.
+*================================================================================*/
+
+#pragma once
+
+#ifndef _STUDIO_SHIM_ALL_EVENT_MSG_H_
+#define _STUDIO_SHIM_ALL_EVENT_MSG_H_
+
+#include "StudioTypes.h"
+#include "ExecutionTypes.h"
+#include "FillInfo.h"
+#include "MarketModels/Instrument.h"
+
+namespace RCM {
+namespace StrategyStudio {
+
+class EventMsg {
+public:
+    explicit EventMsg(TimeType event_time) : event_time_(event_time) {}
+
+    TimeType event_time() const { return event_time_; }
+    TimeType adapter_time() const { return event_time_; }
+    TimeType source_time() const { return event_time_; }
+
+private:
+    TimeType event_time_;
+};
+
+class Trade {
+public:
+    Trade() : price_(0), size_(0), side_(TRADE_SIDE_UNKNOWN) {}
+    Trade(double price, int size, TradeSide side) : price_(price), size_(size), side_(side) {}
+
+    double price() const { return price_; }
+    int size() const { return size_; }
+    TradeSide side() const { return side_; }
+
+private:
+    double price_;
+    int size_;
+    TradeSide side_;
+};
+
+class TradeDataEventMsg : public EventMsg {
+public:
+    TradeDataEventMsg(const MarketModels::Instrument& instrument, const Trade& trade, TimeType event_time) :
+        EventMsg(event_time), instrument_(&instrument), trade_(trade) {}
+
+    const MarketModels::Instrument& instrument() const { return *instrument_; }
+    const Trade& trade() const { return trade_; }
+
+private:
+    const MarketModels::Instrument* instrument_;
+    Trade trade_;
+};
+
+class QuoteEventMsg : public EventMsg {
+public:
+    QuoteEventMsg(const MarketModels::Instrument& instrument, TimeType event_time) :
+        EventMsg(event_time), instrument_(&instrument) {}
+
+    const MarketModels::Instrument& instrument() const { return *instrument_; }
+    const MarketModels::Quote& quote() const { return instrument_->top_quote(); }
+
+private:
+    const MarketModels::Instrument* instrument_;
+};
+
+class MarketDepthEventMsg : public EventMsg {
+public:
+    MarketDepthEventMsg(const MarketModels::Instrument& instrument, TimeType event_time) :
+        EventMsg(event_time), instrument_(&instrument) {}
+
+    const MarketModels::Instrument& instrument() const { return *instrument_; }
+
+private:
+    const MarketModels::Instrument* instrument_;
+};
+
+class Bar {
+public:
+    Bar() : open_(0), high_(0), low_(0), close_(0), volume_(0) {}
+    Bar(double open, double high, double low, double close, int volume) :
+        open_(open), high_(high), low_(low), close_(close), volume_(volume) {}
+
+    double open() const { return open_; }
+    double high() const { return high_; }
+    double low() const { return low_; }
+    double close() const { return close_; }
+    int volume() const { return volume_; }
+
+private:
+    double open_;
+    double high_;
+    double low_;
+    double close_;
+    int volume_;
+};
+
+class BarEventMsg : public EventMsg {
+public:
+    BarEventMsg(const MarketModels::Instrument& instrument, const Bar& bar, BarType type, int interval, TimeType event_time) :
+        EventMsg(event_time), instrument_(&instrument), bar_(bar), type_(type), interval_(interval) {}
+
+    const MarketModels::Instrument& instrument() const { return *instrument_; }
+    const Bar& bar() const { return bar_; }
+    BarType type() const { return type_; }
+    int interval() const { return interval_; }
+
+private:
+    const MarketModels::Instrument* instrument_;
+    Bar bar_;
+    BarType type_;
+    int interval_;
+};
+
+class OrderUpdateEventMsg : public EventMsg {
+public:
+    OrderUpdateEventMsg(const Order& order, OrderUpdateType update_type, const FillInfo* fill, TimeType event_time) :
+        EventMsg(event_time), order_(&order), update_type_(update_type), fill_(fill) {}
+
+    const Order& order() const { return *order_; }
+    OrderID order_id() const { return order_->order_id(); }
+    OrderUpdateType update_type() const { return update_type_; }
+    const FillInfo* fill() const { return fill_; }
+    TimeType update_time() const { return event_time(); }
+
+private:
+    const Order* order_;
+    OrderUpdateType update_type_;
+    const FillInfo* fill_;
+};
+
+class ScheduledEventMsg : public EventMsg {
+public:
+    ScheduledEventMsg(const std::string& name, TimeType event_time) :
+        EventMsg(event_time), name_(name) {}
+
+    const std::string& scheduled_event_name() const { return name_; }
+
+private:
+    std::string name_;
+};
+
+class StrategyCommandEventMsg : public EventMsg {
+public:
+    StrategyCommandEventMsg(unsigned command_id, TimeType event_time) :
+        EventMsg(event_time), command_id_(command_id) {}
+
+    unsigned command_id() const { return command_id_; }
+
+private:
+    unsigned command_id_;
+};
+
+} // namespace StrategyStudio
+} // namespace RCM
+
+#endif
@@ -0,0 +1,72 @@
+/*================================================================================
+*     Stand-in for the Strategy Studio SDK: fixed-length rolling window with
+*     simple descriptive statistics.
+*================================================================================*/
+
+#pragma once
+
+#ifndef _STUDIO_SHIM_SCALAR_ROLLING_WINDOW_H_
+#define _STUDIO_SHIM_SCALAR_ROLLING_WINDOW_H_
+
+#include <boost/circular_buffer.hpp>
+
+#include <cmath>
+#include <cstddef>
+
+namespace RCM {
+namespace StrategyStudio {
+namespace Analytics {
+
+template <typename T>
+class ScalarRollingWindow {
+public:
+    typedef typename boost::circular_buffer<T>::const_iterator const_iterator;
+
+    ScalarRollingWindow() : buffer_(1) {}
+    explicit ScalarRollingWindow(std::size_t size) : buffer_(size) {}
+
+    void push_back(const T& value) { buffer_.push_back(value); }
+    void clear() { buffer_.clear(); }
+    void resize(std::size_t size) { buffer_.set_capacity(size); }
+
+    bool full() const { return buffer_.full(); }
+    bool empty() const { return buffer_.empty(); }
+    std::size_t size() const { return buffer_.size(); }
+    std::size_t max_size() const { return buffer_.capacity(); }
+
+    const_iterator begin() const { return buffer_.begin(); }
+    const_iterator end() const { return buffer_.end(); }
+    const T& front() const { return buffer_.front(); }
+    const T& back() const { return buffer_.back(); }
+
+    T Mean() const
+    {
+        if (buffer_.empty()) return T();
+        T sum = T();
+        for (const_iterator it = buffer_.begin(); it != buffer_.end(); ++it) sum += *it;
+        return sum / static_cast<T>(buffer_.size());
+    }
+
+    T Variance() const
+    {
+        if (buffer_.size() < 2) return T();
+        T mean = Mean();
+        T sum_sq = T();
+        for (const_iterator it = buffer_.begin(); it != buffer_.end(); ++it) {
+            T d = *it - mean;
+            sum_sq += d * d;
+        }
+        return sum_sq / static_cast<T>(buffer_.size() - 1);
+    }
+
+    T StdDev() const { return std::sqrt(Variance()); }
+
+private:
+    boost::circular_buffer<T> buffer_;
+};
+
+} // namespace Analytics
+} // namespace StrategyStudio
+} // namespace RCM
+
+#endif
@@ -0,0 +1,93 @@
+/*================================================================================
+*     Stand-in for the Strategy Studio SDK: order parameters and order objects.
+*================================================================================*/
+
+#pragma once
+
+#ifndef _STUDIO_SHIM_EXECUTION_TYPES_H_
+#define _STUDIO_SHIM_EXECUTION_TYPES_H_
+
+#include "StudioTypes.h"
+#include "MarketModels/Instrument.h"
+
+namespace RCM {
+namespace StrategyStudio {
+
+struct OrderParams {
+    OrderParams(const MarketModels::Instrument& instrument,
+                int quantity,
+                double price,
+                MarketCenterID market_center,
+                OrderSide side,
+                OrderTIF tif,
+                OrderType type) :
+        instrument(&instrument),
+        quantity(quantity),
+        price(price),
+        market_center(market_center),
+        order_side(side),
+        tif(tif),
+        order_type(type) {}
+
+    const MarketModels::Instrument* instrument;
+    int quantity;
+    double price;
+    MarketCenterID market_center;
+    OrderSide order_side;
+    OrderTIF tif;
+    OrderType order_type;
+};
+
+class Order {
+public:
+    Order() :
+        instrument_(nullptr),
+        order_id_(0),
+        order_state_(ORDER_STATE_PENDING_OPEN),
+        order_type_(ORDER_TYPE_MARKET),
+        order_side_(ORDER_SIDE_UNKNOWN),
+        price_(0),
+        size_(0),
+        executed_size_(0) {}
+
+    Order(OrderID order_id, const OrderParams& params) :
+        instrument_(params.instrument),
+        order_id_(order_id),
+        order_state_(ORDER_STATE_PENDING_OPEN),
+        order_type_(params.order_type),
+        order_side_(params.order_side),
+        price_(params.price),
+        size_(params.quantity),
+        executed_size_(0) {}
+
+    const MarketModels::Instrument* instrument() const { return instrument_; }
+    OrderID order_id() const { return order_id_; }
+    OrderState order_state() const { return order_state_; }
+    OrderType order_type() const { return order_type_; }
+    OrderSide order_side() const { return order_side_; }
+    double price() const { return price_; }
+    int size() const { return size_; }
+    int executed_size() const { return executed_size_; }
+    int size_remaining() const { return size_ - executed_size_; }
+    bool IsBuy() const { return order_side_ == ORDER_SIDE_BUY; }
+
+    void set_order_state(OrderState state) { order_state_ = state; }
+    void set_price(double price) { price_ = price; }
+    void set_size(int size) { size_ = size; }
+    void AddExecution(int size) { executed_size_ += size; }
+
+private:
+    const MarketModels::Instrument* instrument_;
+    OrderID order_id_;
+    OrderState order_state_;
+    OrderType order_type_;
+    OrderSide order_side_;
+    double price_;
+    int size_;
+    int executed_size_;
+};
+
+} // namespace StrategyStudio
+} // namespace RCM
+
+#endif
@@ -0,0 +1,32 @@
+/*================================================================================
+*     Stand-in for the Strategy Studio SDK: execution reports.
+*================================================================================*/
+
+#pragma once
+
+#ifndef _STUDIO_SHIM_FILL_INFO_H_
+#define _STUDIO_SHIM_FILL_INFO_H_
+
+#include "StudioTypes.h"
+
+namespace RCM {
+namespace StrategyStudio {
+
+class FillInfo {
+public:
+    FillInfo() : fill_price_(0), fill_size_(0) {}
+    FillInfo(double fill_price, int fill_size) : fill_price_(fill_price), fill_size_(fill_size) {}
+
+    double fill_price() const { return fill_price_; }
+    // Signed: positive for buys, negative for sells
+    int fill_size() const { return fill_size_; }
+
+private:
+    double fill_price_;
+    int fill_size_;
+};
+
+} // namespace StrategyStudio
+} // namespace RCM
+
+#endif
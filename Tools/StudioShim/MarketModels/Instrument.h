@@ -0,0 +1,116 @@
+/*================================================================================
+*     Stand-in for the Strategy Studio SDK: instruments, quotes and the
+*     aggregate order book.
+*================================================================================*/
+
+#pragma once
+
+#ifndef _STUDIO_SHIM_INSTRUMENT_H_
+#define _STUDIO_SHIM_INSTRUMENT_H_
+
+#include "../StudioTypes.h"
+
+#include <string>
+#include <vector>
+
+namespace RCM {
+namespace StrategyStudio {
+namespace MarketModels {
+
+class QuoteSide {
+public:
+    QuoteSide() : price_(0), size_(0) {}
+    QuoteSide(double price, int size) : price_(price), size_(size) {}
+
+    double price() const { return price_; }
+    int size() const { return size_; }
+    bool IsValid() const { return price_ > 0 && size_ > 0; }
+
+    void Set(double price, int size) { price_ = price; size_ = size; }
+
+private:
+    double price_;
+    int size_;
+};
+
+class Quote {
+public:
+    const QuoteSide& bid_side() const { return bid_; }
+    const QuoteSide& ask_side() const { return ask_; }
+    QuoteSide& bid_side() { return bid_; }
+    QuoteSide& ask_side() { return ask_; }
+
+    double bid() const { return bid_.price(); }
+    double ask() const { return ask_.price(); }
+    int bid_size() const { return bid_.size(); }
+    int ask_size() const { return ask_.size(); }
+
+private:
+    QuoteSide bid_;
+    QuoteSide ask_;
+};
+
+class IAggrPriceLevel {
+public:
+    IAggrPriceLevel() : price_(0), size_(0) {}
+    IAggrPriceLevel(double price, int size) : price_(price), size_(size) {}
+
+    double price() const { return price_; }
+    int size() const { return size_; }
+
+private:
+    double price_;
+    int size_;
+};
+
+// Aggregate book ordered best-first on each side.
+class IAggrOrderBook {
+public:
+    int NumBidLevels() const { return static_cast<int>(bids_.size()); }
+    int NumAskLevels() const { return static_cast<int>(asks_.size()); }
+
+    const IAggrPriceLevel* BidPriceLevelAtLevel(int level) const
+    {
+        return (level >= 0 && level < NumBidLevels()) ? &bids_[level] : nullptr;
+    }
+
+    const IAggrPriceLevel* AskPriceLevelAtLevel(int level) const
+    {
+        return (level >= 0 && level < NumAskLevels()) ? &asks_[level] : nullptr;
+    }
+
+    std::vector<IAggrPriceLevel>& bids() { return bids_; }
+    std::vector<IAggrPriceLevel>& asks() { return asks_; }
+
+private:
+    std::vector<IAggrPriceLevel> bids_;
+    std::vector<IAggrPriceLevel> asks_;
+};
+
+class Instrument {
+public:
+    Instrument(const std::string& symbol, double min_tick_size) :
+        symbol_(symbol),
+        min_tick_size_(min_tick_size) {}
+
+    const std::string& symbol() const { return symbol_; }
+    double min_tick_size() const { return min_tick_size_; }
+
+    const Quote& top_quote() const { return top_quote_; }
+    Quote& top_quote() { return top_quote_; }
+
+    const IAggrOrderBook& aggregate_order_book() const { return book_; }
+    IAggrOrderBook& aggregate_order_book() { return book_; }
+
+private:
+    std::string symbol_;
+    double min_tick_size_;
+    Quote top_quote_;
+    IAggrOrderBook book_;
+};
+
+} // namespace MarketModels
+} // namespace StrategyStudio
+} // namespace RCM
+
+#endif
@@ -0,0 +1,316 @@
+/*================================================================================
+*     Stand-in for the Strategy Studio SDK: the Strategy base class and the
+*     services it exposes (parameters, commands, portfolio, trade actions,
+*     logging).
+*
+*     Everything a strategy calls is routed through an IStrategyHost supplied
+*     by whichever tool is driving it.  Without a host, order actions are
+*     accepted and dropped and log lines are discarded.
+*================================================================================*/
+
+#pragma once
+
+#ifndef _STUDIO_SHIM_STRATEGY_H_
+#define _STUDIO_SHIM_STRATEGY_H_
+
+#include "StudioTypes.h"
+#include "AllEventMsg.h"
+#include "ExecutionTypes.h"
+#include "MarketModels/Instrument.h"
+
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace RCM {
+namespace StrategyStudio {
+
+using MarketModels::Instrument;
+
+typedef std::set<std::string> SymbolSet;
+typedef SymbolSet::const_iterator SymbolSetConstIter;
+typedef std::map<std::string, const Instrument*> InstrumentSet;
+typedef InstrumentSet::const_iterator InstrumentSetConstIter;
+
+class IStrategyHost {
+public:
+    virtual ~IStrategyHost() {}
+
+    virtual OrderID SendNewOrder(OrderParams& params) = 0;
+    virtual bool SendCancelOrder(OrderID order_id) = 0;
+    virtual bool SendCancelReplaceOrder(OrderID order_id, int quantity, double price) = 0;
+    virtual void LogToClient(LogLevel level, const std::string& message) = 0;
+};
+
+class IStrategy {
+public:
+    virtual ~IStrategy() {}
+};
+
+class StrategyParam {
+public:
+    StrategyParam(const std::string& name, const std::string& value) : name_(name), value_(value) {}
+
+    const std::string& param_name() const { return name_; }
+    const std::string& value() const { return value_; }
+
+    bool Get(int* out) const { return Parse(out); }
+    bool Get(double* out) const { return Parse(out); }
+    bool Get(std::string* out) const { *out = value_; return true; }
+    bool Get(bool* out) const
+    {
+        if (value_ == "true" || value_ == "1") { *out = true; return true; }
+        if (value_ == "false" || value_ == "0") { *out = false; return true; }
+        return false;
+    }
+
+private:
+    template <typename T>
+    bool Parse(T* out) const
+    {
+        std::istringstream in(value_);
+        T value;
+        if (!(in >> value)) return false;
+        *out = value;
+        return true;
+    }
+
+    std::string name_;
+    std::string value_;
+};
+
+struct CreateStrategyParamArgs {
+    template <typename T>
+    CreateStrategyParamArgs(const std::string& name, StrategyParamType param_type, ValueType value_type, const T& value) :
+        name(name),
+        param_type(param_type),
+        value_type(value_type)
+    {
+        std::ostringstream out;
+        out << std::boolalpha << value;
+        default_value = out.str();
+    }
+
+    std::string name;
+    StrategyParamType param_type;
+    ValueType value_type;
+    std::string default_value;
+};
+
+class StrategyParamCollection {
+public:
+    void CreateParam(const CreateStrategyParamArgs& args) { params_.push_back(args); }
+    const std::vector<CreateStrategyParamArgs>& definitions() const { return params_; }
+    void clear() { params_.clear(); }
+
+private:
+    std::vector<CreateStrategyParamArgs> params_;
+};
+
+struct StrategyCommand {
+    StrategyCommand(unsigned id, const std::string& name) : id(id), name(name) {}
+
+    unsigned id;
+    std::string name;
+};
+
+class StrategyCommandCollection {
+public:
+    void AddCommand(const StrategyCommand& command) { commands_.push_back(command); }
+    const std::vector<StrategyCommand>& definitions() const { return commands_; }
+    void clear() { commands_.clear(); }
+
+private:
+    std::vector<StrategyCommand> commands_;
+};
+
+struct BarSubscription {
+    std::string symbol;
+    BarType type;
+    int interval;
+};
+
+// OnScheduledEvent every interval from start_time until end_time
+struct ScheduledEventSubscription {
+    std::string name;
+    TimeType start_time;
+    TimeType end_time;
+    boost::posix_time::time_duration interval;
+};
+
+class StrategyEventRegister {
+public:
+    void RegisterForMarketData(const std::string& symbol) { market_data_.insert(symbol); }
+    void RegisterForBars(const std::string& symbol, BarType type, int interval)
+    {
+        BarSubscription sub = { symbol, type, interval };
+        bars_.push_back(sub);
+    }
+
+    void RegisterForRecurringScheduledEvents(const std::string& name, TimeType start_time, TimeType end_time,
+                                             boost::posix_time::time_duration interval)
+    {
+        ScheduledEventSubscription sub = { name, start_time, end_time, interval };
+        scheduled_events_.push_back(sub);
+    }
+
+    const std::set<std::string>& market_data() const { return market_data_; }
+    const std::vector<BarSubscription>& bars() const { return bars_; }
+    const std::vector<ScheduledEventSubscription>& scheduled_events() const { return scheduled_events_; }
+
+private:
+    std::set<std::string> market_data_;
+    std::vector<BarSubscription> bars_;
+    std::vector<ScheduledEventSubscription> scheduled_events_;
+};
+
+class Portfolio {
+public:
+    Portfolio() : cash_balance_(0) {}
+
+    int position(const Instrument* instrument) const
+    {
+        std::map<const Instrument*, int>::const_iterator it = positions_.find(instrument);
+        return it == positions_.end() ? 0 : it->second;
+    }
+
+    double cash_balance() const { return cash_balance_; }
+
+    void set_cash_balance(double cash) { cash_balance_ = cash; }
+    void ApplyFill(const Instrument* instrument, int signed_size, double price)
+    {
+        positions_[instrument] += signed_size;
+        cash_balance_ -= signed_size * price;
+    }
+    void clear() { positions_.clear(); }
+
+private:
+    std::map<const Instrument*, int> positions_;
+    double cash_balance_;
+};
+
+class TradeActions {
+public:
+    TradeActions() : host_(nullptr) {}
+
+    OrderID SendNewOrder(OrderParams& params) { return host_ ? host_->SendNewOrder(params) : 0; }
+    bool SendCancelOrder(OrderID order_id) { return host_ ? host_->SendCancelOrder(order_id) : false; }
+    bool SendCancelReplaceOrder(OrderID order_id, int quantity, double price)
+    {
+        return host_ ? host_->SendCancelReplaceOrder(order_id, quantity, price) : false;
+    }
+
+    void set_host(IStrategyHost* host) { host_ = host; }
+
+private:
+    IStrategyHost* host_;
+};
+
+class StrategyLogger {
+public:
+    StrategyLogger() : host_(nullptr) {}
+
+    void LogToClient(LogLevel level, const std::string& message)
+    {
+        if (host_) host_->LogToClient(level, message);
+    }
+
+    void set_host(IStrategyHost* host) { host_ = host; }
+
+private:
+    IStrategyHost* host_;
+};
+
+class Strategy : public IStrategy {
+public:
+    Strategy(StrategyID strategyID, const std::string& strategyName, const std::string& groupName) :
+        strategy_id_(strategyID),
+        name_(strategyName),
+        group_(groupName) {}
+    virtual ~Strategy() {}
+
+    operator IStrategy*() { return this; }
+    static const char* release_version() { return "StudioShim"; }
+
+public: // Event handlers
+    virtual void OnTrade(const TradeDataEventMsg& msg) {}
+    virtual void OnTopQuote(const QuoteEventMsg& msg) {}
+    virtual void OnQuote(const QuoteEventMsg& msg) {}
+    virtual void OnDepth(const MarketDepthEventMsg& msg) {}
+    virtual void OnBar(const BarEventMsg& msg) {}
+    virtual void OnOrderUpdate(const OrderUpdateEventMsg& msg) {}
+    virtual void OnScheduledEvent(const ScheduledEventMsg& msg) {}
+    virtual void OnStrategyCommand(const StrategyCommandEventMsg& msg) {}
+    virtual void OnResetStrategyState() {}
+    virtual void OnParamChanged(StrategyParam& param) {}
+
+public: // Host-facing setup, not part of the Strategy Studio API
+    void AttachHost(IStrategyHost* host)
+    {
+        trade_actions_.set_host(host);
+        logger_.set_host(host);
+    }
+
+    void AddInstrument(const Instrument* instrument)
+    {
+        symbols_.insert(instrument->symbol());
+        instruments_[instrument->symbol()] = instrument;
+    }
+
+    void Initialize(StrategyEventRegister* eventRegister, DateType currDate)
+    {
+        params_.clear();
+        commands_.clear();
+        DefineStrategyParams();
+        DefineStrategyCommands();
+        RegisterForStrategyEvents(eventRegister, currDate);
+    }
+
+    // Applies a named parameter value the same way a runtime parameter change would
+    void SetParam(const std::string& name, const std::string& value)
+    {
+        StrategyParam param(name, value);
+        OnParamChanged(param);
+    }
+
+    Portfolio& mutable_portfolio() { return portfolio_; }
+    const std::string& name() const { return name_; }
+    StrategyID strategy_id() const { return strategy_id_; }
+
+protected:
+    SymbolSetConstIter symbols_begin() const { return symbols_.begin(); }
+    SymbolSetConstIter symbols_end() const { return symbols_.end(); }
+    InstrumentSetConstIter instrument_begin() const { return instruments_.begin(); }
+    InstrumentSetConstIter instrument_end() const { return instruments_.end(); }
+
+    StrategyParamCollection& params() { return params_; }
+    StrategyCommandCollection& commands() { return commands_; }
+    const Portfolio& portfolio() const { return portfolio_; }
+    TradeActions* trade_actions() { return &trade_actions_; }
+    StrategyLogger& logger() { return logger_; }
+
+private:
+    virtual void RegisterForStrategyEvents(StrategyEventRegister* eventRegister, DateType currDate) = 0;
+    virtual void DefineStrategyParams() {}
+    virtual void DefineStrategyCommands() {}
+
+private:
+    StrategyID strategy_id_;
+    std::string name_;
+    std::string group_;
+    SymbolSet symbols_;
+    InstrumentSet instruments_;
+    StrategyParamCollection params_;
+    StrategyCommandCollection commands_;
+    Portfolio portfolio_;
+    TradeActions trade_actions_;
+    StrategyLogger logger_;
+};
+
+} // namespace StrategyStudio
+} // namespace RCM
+
+#endif
@@ -0,0 +1,112 @@
+/*================================================================================
+*     Stand-in for the Strategy Studio SDK.
+*
+*     Only the slice of the API exercised by the strategies in this repository is
+*     declared here.  Strategies compiled against these headers can be driven by
+*     the benchmark and replay tools under Tools/ without a Strategy Studio
+*     installation.  Builds against the real SDK never see these headers.
+*================================================================================*/
+
+#pragma once
+
+#ifndef _STUDIO_SHIM_STUDIO_TYPES_H_
+#define _STUDIO_SHIM_STUDIO_TYPES_H_
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace RCM {
+namespace StrategyStudio {
+
+typedef boost::posix_time::ptime TimeType;
+typedef boost::gregorian::date DateType;
+typedef unsigned StrategyID;
+typedef uint64_t OrderID;
+
+enum TradeSide {
+    TRADE_SIDE_UNKNOWN = 0,
+    TRADE_SIDE_BUY = 1,
+    TRADE_SIDE_SELL = 2
+};
+
+enum OrderSide {
+    ORDER_SIDE_UNKNOWN = 0,
+    ORDER_SIDE_BUY = 1,
+    ORDER_SIDE_SELL = 2
+};
+
+enum OrderTIF {
+    ORDER_TIF_DAY = 0,
+    ORDER_TIF_IOC = 1,
+    ORDER_TIF_GTC = 2
+};
+
+enum OrderType {
+    ORDER_TYPE_MARKET = 0,
+    ORDER_TYPE_LIMIT = 1
+};
+
+enum OrderState {
+    ORDER_STATE_PENDING_OPEN = 0,
+    ORDER_STATE_OPEN = 1,
+    ORDER_STATE_PARTIALLY_FILLED = 2,
+    ORDER_STATE_FILLED = 3,
+    ORDER_STATE_PENDING_CANCEL = 4,
+    ORDER_STATE_CANCELLED = 5,
+    ORDER_STATE_REJECTED = 6
+};
+
+enum OrderUpdateType {
+    ORDER_UPDATE_TYPE_OPEN = 0,
+    ORDER_UPDATE_TYPE_PARTIAL_FILL = 1,
+    ORDER_UPDATE_TYPE_FILL = 2,
+    ORDER_UPDATE_TYPE_CANCEL = 3,
+    ORDER_UPDATE_TYPE_MODIFY = 4,
+    ORDER_UPDATE_TYPE_REJECT = 5,
+    ORDER_UPDATE_TYPE_CANCEL_REJECT = 6
+};
+
+enum MarketCenterID {
+    MARKET_CENTER_ID_UNKNOWN = 0,
+    MARKET_CENTER_ID_IEX = 1
+};
+
+enum BarType {
+    BAR_TYPE_TIME = 0,
+    BAR_TYPE_TICK = 1,
+    BAR_TYPE_VOLUME = 2
+};
+
+enum LogLevel {
+    LOGLEVEL_DEBUG = 0,
+    LOGLEVEL_INFO = 1,
+    LOGLEVEL_WARNING = 2,
+    LOGLEVEL_ERROR = 3
+};
+
+enum StrategyParamType {
+    STRATEGY_PARAM_TYPE_STARTUP = 0,
+    STRATEGY_PARAM_TYPE_RUNTIME = 1
+};
+
+enum ValueType {
+    VALUE_TYPE_INT = 0,
+    VALUE_TYPE_DOUBLE = 1,
+    VALUE_TYPE_BOOL = 2,
+    VALUE_TYPE_STRING = 3
+};
+
+class StrategyStudioException : public std::runtime_error {
+public:
+    explicit StrategyStudioException(const std::string& what) : std::runtime_error(what) {}
+};
+
+} // namespace StrategyStudio
+} // namespace RCM
+
+#endif
@@ -0,0 +1,13 @@
+/*================================================================================
+*     Stand-in for the Strategy Studio SDK.  The strategies include this header
+*     but use nothing from it.
+*================================================================================*/
+
+#pragma once
+
+namespace RCM {
+namespace StrategyStudio {
+namespace Utilities {
+} // namespace Utilities
+} // namespace StrategyStudio
+} // namespace RCM